@@ -2,6 +2,7 @@
 
 #include "applib.hpp"
 #include "bracketed_paste.hpp"
+#include "metrics.hpp"
 #include "myncurses.h"
 #include "safecall.hpp"
 #include "strings.hpp"
@@ -13,16 +14,28 @@ extern "C" {
 
 #include <ncurses.h>
 
+#include <algorithm>
 #include <iostream>
+#include <thread>
 #include <unistd.h>
 
 static char const app_key = '\0';
 
+/// Largest number of network threads; later connections share them
+static unsigned const max_network_threads = 8;
+
+/// Frame interval until the Lua code sets its own; about 30 frames per second
+static std::chrono::milliseconds const default_frame_interval{33};
+
 App::App(char const* const filename)
     : io_context{}
     , stdin_poll{io_context, STDIN_FILENO}
     , signals{io_context, SIGWINCH, SIGUSR1}
     , main_source{filename}
+    , frame_timer{io_context}
+    , frame_interval{default_frame_interval}
+    , last_frame{}
+    , frame_pending{false}
 {
     L = luaL_newstate();
     lua_pushlightuserdata(L, this);
@@ -31,9 +44,74 @@ App::App(char const* const filename)
 
 App::~App()
 {
+    // Network threads must be stopped before the state they report to goes away
+    network_pool.reset();
     lua_close(L);
 }
 
+auto App::get_network_pool() -> NetworkPool&
+{
+    if (not network_pool)
+    {
+        auto const cores = std::max(1u, std::thread::hardware_concurrency());
+        network_pool = std::make_unique<NetworkPool>(std::min(cores, max_network_threads));
+    }
+    return *network_pool;
+}
+
+auto App::get_network_context() -> boost::asio::io_context&
+{
+    return get_network_pool().acquire();
+}
+
+auto App::start_network_thread() -> NetworkPool::Work
+{
+    return get_network_pool().dedicated();
+}
+
+auto App::request_frame() -> void
+{
+    static auto& skipped = metrics::counter("ui_frames_skipped_total", "Redraw requests merged into a pending frame");
+
+    if (frame_pending)
+    {
+        skipped.add();
+        return;
+    }
+    frame_pending = true;
+
+    // A deadline in the past completes right away, still through the queue
+    frame_timer.expires_at(last_frame + frame_interval);
+    frame_timer.async_wait([this](boost::system::error_code const error) {
+        if (error)
+        {
+            frame_pending = false;
+            return;
+        }
+        // Let handlers that are already ready, such as more messages, run first
+        boost::asio::post(io_context, [this]() { draw_frame(); });
+    });
+}
+
+auto App::set_frame_interval(std::chrono::steady_clock::duration const interval) -> void
+{
+    frame_interval = interval;
+}
+
+auto App::draw_frame() -> void
+{
+    static auto& frames = metrics::counter("ui_frames_total", "Frames drawn");
+    static auto& frame_time = metrics::histogram("ui_frame_seconds", "Time spent drawing a frame");
+
+    // Requests made while drawing schedule the next frame
+    frame_pending = false;
+    last_frame = std::chrono::steady_clock::now();
+
+    frames.add();
+    metrics::ScopedTimer const timer{frame_time};
+    lua_callback(L, "on_frame", 0);
+}
+
 auto App::from_lua(lua_State* const L) -> App*
 {
     lua_rawgetp(L, LUA_REGISTRYINDEX, &app_key);
@@ -185,6 +263,7 @@ auto App::shutdown() -> void
 {
     stdin_poll.close();
     signals.cancel();
+    frame_timer.cancel();
 }
 
 auto App::reload() -> bool
@@ -6,8 +6,12 @@
  *
  */
 
+#include "net/networkpool.hpp"
+
 #include <boost/asio.hpp>
 
+#include <chrono>
+#include <memory>
 #include <string_view>
 
 struct lua_State;
@@ -20,6 +24,21 @@ class App
     lua_State* L;
     char const* main_source;
 
+    /// Threads running connections off the main thread; started on demand
+    std::unique_ptr<NetworkPool> network_pool;
+
+    /// Delays the next frame until the frame interval has passed
+    boost::asio::steady_timer frame_timer;
+
+    /// Shortest time between the starts of two frames
+    std::chrono::steady_clock::duration frame_interval;
+
+    /// Start of the most recent frame
+    std::chrono::steady_clock::time_point last_frame;
+
+    /// True while a frame is scheduled and not yet drawn
+    bool frame_pending;
+
 public:
     App(char const*);
     ~App();
@@ -34,6 +53,22 @@ public:
         return io_context;
     }
 
+    /**
+     * @brief Get an IO context run by a network thread
+     *
+     * Events from connections on this context must be marshalled back
+     * to the main IO context before they touch the Lua state.
+     */
+    auto get_network_context() -> boost::asio::io_context&;
+
+    /**
+     * @brief Start a network thread for a single connection
+     *
+     * The thread exits once the returned work is released and the
+     * connection's remaining work is done.
+     */
+    auto start_network_thread() -> NetworkPool::Work;
+
     auto get_lua() const -> lua_State*
     {
         return L;
@@ -42,7 +77,23 @@ public:
     auto start_input() -> void;
     auto stop_input() -> void;
 
+    /**
+     * @brief Ask for the screen to be redrawn
+     *
+     * Requests are coalesced so that Lua's on_frame callback runs at most
+     * once per frame interval. The frame is drawn after the handlers that
+     * were ready when it came due, so a burst of events is drawn once.
+     */
+    auto request_frame() -> void;
+
+    /**
+     * @brief Set the shortest time between frames
+     */
+    auto set_frame_interval(std::chrono::steady_clock::duration interval) -> void;
+
 private:
+    auto draw_frame() -> void;
+    auto get_network_pool() -> NetworkPool&;
     auto signal_thread() -> boost::asio::awaitable<void>;
     auto stdin_thread() -> boost::asio::awaitable<void>;
 };
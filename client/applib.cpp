@@ -4,15 +4,23 @@
 #include "config.hpp"
 #include "dnslookup.hpp"
 #include "httpd.hpp"
+#include "irccase.hpp"
+#include "ircformat.hpp"
+#include "loadtracker.hpp"
+#include "metrics.hpp"
 #include "irc/lua.hpp"
+#include "orderedmap.hpp"
+#include "profiler.hpp"
 #include "safecall.hpp"
 #include "strings.hpp"
 #include "timer.hpp"
 
 #include <ircmsg.hpp>
 #include <mybase64.hpp>
+#include <mylpm.hpp>
 #include <myncurses.h>
 #include <myopenssl.hpp>
+#include <mysnote.hpp>
 #include <mytoml.hpp>
 
 extern "C" {
@@ -38,6 +46,8 @@ extern "C" {
 #include "process.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <csignal>
 #include <cstring>
 #include <ctime>
@@ -45,6 +55,8 @@ extern "C" {
 #include <iostream>
 #include <iterator>
 #include <locale>
+#include <variant>
+#include <vector>
 
 namespace { // lua support for app
 
@@ -154,57 +166,6 @@ auto l_isalnum(lua_State* const L) -> int
     return 1;
 }
 
-/**
- * @brief Lua binding for RFC 1459 case mapping.
- *
- * Converts the input string to its uppercase form according to RFC 1459 rules,
- * which are used for case-insensitive comparisons in IRC. This mapping treats
- * the characters '{', '}', '|', and '^' as equivalent to '[', ']', '\\', and '~'
- * respectively, in addition to standard ASCII uppercase conversion.
- *
- * param:   string input text to normalize
- * return:  string IRC case normalized text
- *
- * @param L Lua state
- * @return int 1
- */
-auto l_irccase(lua_State* const L) -> int
-{
-    char const* const charmap = "\x00\x01\x02\x03\x04\x05\x06\x07"
-                                "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
-                                "\x10\x11\x12\x13\x14\x15\x16\x17"
-                                "\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f"
-                                " !\"#$%&'()*+,-./0123456789:;<=>?"
-                                "@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_"
-                                "`ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^\x7f"
-                                "\x80\x81\x82\x83\x84\x85\x86\x87"
-                                "\x88\x89\x8a\x8b\x8c\x8d\x8e\x8f"
-                                "\x90\x91\x92\x93\x94\x95\x96\x97"
-                                "\x98\x99\x9a\x9b\x9c\x9d\x9e\x9f"
-                                "\xa0\xa1\xa2\xa3\xa4\xa5\xa6\xa7"
-                                "\xa8\xa9\xaa\xab\xac\xad\xae\xaf"
-                                "\xb0\xb1\xb2\xb3\xb4\xb5\xb6\xb7"
-                                "\xb8\xb9\xba\xbb\xbc\xbd\xbe\xbf"
-                                "\xc0\xc1\xc2\xc3\xc4\xc5\xc6\xc7"
-                                "\xc8\xc9\xca\xcb\xcc\xcd\xce\xcf"
-                                "\xd0\xd1\xd2\xd3\xd4\xd5\xd6\xd7"
-                                "\xd8\xd9\xda\xdb\xdc\xdd\xde\xdf"
-                                "\xe0\xe1\xe2\xe3\xe4\xe5\xe6\xe7"
-                                "\xe8\xe9\xea\xeb\xec\xed\xee\xef"
-                                "\xf0\xf1\xf2\xf3\xf4\xf5\xf6\xf7"
-                                "\xf8\xf9\xfa\xfb\xfc\xfd\xfe\xff";
-
-    auto const str = check_string_view(L, 1);
-
-    luaL_Buffer B;
-    auto const output = luaL_buffinitsize(L, &B, str.size());
-    std::transform(std::begin(str), std::end(str), output, [charmap](char c) {
-        return charmap[uint8_t(c)];
-    });
-    luaL_pushresultsize(&B, str.size());
-    return 1;
-}
-
 /**
  * @brief Initiate the shutdown process for the client.
  *
@@ -326,6 +287,159 @@ auto l_parse_irc(lua_State* const L) -> int
     }
 }
 
+/**
+ * @brief Snapshot of the native metrics registry
+ *
+ * Counters and gauges map to integers. Histograms map to tables with
+ * count, sum, max, p50, p90, and p99 fields; durations are in seconds.
+ *
+ * param:       string? format  "prometheus" for the text exposition format
+ * return[1]:   table metrics by name
+ * return[1]:   string Prometheus exposition text
+ *
+ * @param L Lua state
+ * @return int 1
+ */
+auto l_metrics(lua_State* const L) -> int
+{
+    if (not lua_isnoneornil(L, 1))
+    {
+        static char const* const formats[] = {"prometheus", nullptr};
+        luaL_checkoption(L, 1, nullptr, formats);
+        push_string(L, metrics::render_prometheus());
+        return 1;
+    }
+
+    struct Summary
+    {
+        std::uint64_t count, sum, max, p50, p90, p99;
+    };
+    using Value = std::variant<lua_Integer, Summary>;
+
+    // Copy the metrics out first so that no Lua call, which can raise
+    // an error, runs while the registry lock is held.
+    std::vector<std::pair<std::string, Value>> values;
+    metrics::visit({
+        .on_counter = [&values](std::string_view const name, metrics::Counter const& counter) {
+            values.emplace_back(name, static_cast<lua_Integer>(counter.value()));
+        },
+        .on_gauge = [&values](std::string_view const name, metrics::Gauge const& gauge) {
+            values.emplace_back(name, lua_Integer{gauge.value()});
+        },
+        .on_histogram = [&values](std::string_view const name, metrics::Histogram const& hist) {
+            values.emplace_back(name, Summary{
+                hist.count(), hist.sum(), hist.max(),
+                hist.quantile(0.5), hist.quantile(0.9), hist.quantile(0.99)});
+        },
+    });
+
+    auto const seconds = [](std::uint64_t const ns) { return static_cast<lua_Number>(ns) / 1e9; };
+
+    lua_createtable(L, 0, values.size());
+    for (auto const& [name, value] : values)
+    {
+        push_string(L, name);
+        if (auto const n = std::get_if<lua_Integer>(&value))
+        {
+            lua_pushinteger(L, *n);
+        }
+        else
+        {
+            auto const& hist = std::get<Summary>(value);
+            lua_createtable(L, 0, 6);
+            lua_pushinteger(L, hist.count);
+            lua_setfield(L, -2, "count");
+            lua_pushnumber(L, seconds(hist.sum));
+            lua_setfield(L, -2, "sum");
+            lua_pushnumber(L, seconds(hist.max));
+            lua_setfield(L, -2, "max");
+            lua_pushnumber(L, seconds(hist.p50));
+            lua_setfield(L, -2, "p50");
+            lua_pushnumber(L, seconds(hist.p90));
+            lua_setfield(L, -2, "p90");
+            lua_pushnumber(L, seconds(hist.p99));
+            lua_setfield(L, -2, "p99");
+        }
+        lua_rawset(L, -3);
+    }
+    return 1;
+}
+
+/// @brief Number of distinct strings whose formatting is remembered
+constexpr std::size_t irc_format_cache_size = 1024;
+
+auto irc_format_cache() -> IrcFormatCache&
+{
+    static IrcFormatCache cache{irc_format_cache_size};
+    return cache;
+}
+
+/// @brief Terminal color for an IRC color number
+auto irc_color(int const color) -> int
+{
+    static int const colors[] = {
+        COLOR_WHITE, COLOR_BLACK, COLOR_BLUE, COLOR_GREEN,
+        COLOR_RED, COLOR_CYAN, COLOR_MAGENTA, COLOR_YELLOW,
+        COLOR_WHITE, COLOR_BLACK, COLOR_BLUE, COLOR_GREEN,
+        COLOR_RED, COLOR_CYAN, COLOR_MAGENTA, COLOR_YELLOW,
+    };
+    return 0 <= color && color < static_cast<int>(std::size(colors)) ? colors[color] : -1;
+}
+
+/**
+ * @brief Draw text containing IRC formatting codes
+ *
+ * Formatting is interpreted natively and cached per string, and the
+ * whole string is drawn in one call. Drawing attributes are unchanged
+ * afterward.
+ *
+ * param:   string  text    Text with formatting codes
+ * param:   window? win     Window to draw on, defaults to stdscr
+ *
+ * @param L Lua state
+ * @return int 0
+ */
+auto l_addircstr(lua_State* const L) -> int
+{
+    auto const& formatted = irc_format_cache().get(check_string_view(L, 1));
+
+    static std::vector<myncurses_span> spans;
+    spans.clear();
+    auto text = formatted.text.data();
+    for (auto const& span : formatted.spans)
+    {
+        unsigned attr = WA_NORMAL;
+        if (span.attrs & irc_bold) attr |= WA_BOLD;
+        if (span.attrs & irc_italic) attr |= WA_ITALIC;
+        if (span.attrs & irc_underline) attr |= WA_UNDERLINE;
+        if (span.attrs & irc_reverse) attr |= WA_REVERSE;
+        auto const pair = myncurses_colorpair(irc_color(span.fore), irc_color(span.back));
+        spans.push_back({text, span.length, attr, static_cast<short>(pair)});
+        text += span.length;
+    }
+
+    myncurses_addspans(L, 2, spans.data(), spans.size());
+    return 0;
+}
+
+/**
+ * @brief Remove IRC formatting codes from text
+ *
+ * Other control characters are replaced with visible control pictures
+ * as addircstr would draw them.
+ *
+ * param:   string  text    Text with formatting codes
+ * return:  string  text without formatting codes
+ *
+ * @param L Lua state
+ * @return int 1
+ */
+auto l_stripirc(lua_State* const L) -> int
+{
+    push_string(L, irc_format_cache().get(check_string_view(L, 1)).text);
+    return 1;
+}
+
 auto l_start_input(lua_State* const L) -> int
 {
     App::from_lua(L)->start_input();
@@ -338,18 +452,60 @@ auto l_stop_input(lua_State* const L) -> int
     return 0;
 }
 
+/**
+ * @brief Schedule a call to the module's on_frame callback
+ *
+ * Requests made before the frame is drawn share that frame.
+ *
+ * @param L Lua state
+ * @return int 0
+ */
+auto l_redraw(lua_State* const L) -> int
+{
+    App::from_lua(L)->request_frame();
+    return 0;
+}
+
+/**
+ * @brief Set the shortest time between frames
+ *
+ * param:   number milliseconds     Frame interval
+ *
+ * @param L Lua state
+ * @return int 0
+ */
+auto l_set_frame_interval(lua_State* const L) -> int
+{
+    auto const ms = luaL_checknumber(L, 1);
+    luaL_argcheck(L, 0 <= ms && std::isfinite(ms), 1, "interval must be a non-negative number");
+    auto const interval = std::chrono::duration<double, std::milli>{ms};
+    App::from_lua(L)->set_frame_interval(std::chrono::round<std::chrono::steady_clock::duration>(interval));
+    return 0;
+}
+
 luaL_Reg const applib_module[] = {
+    {"addircstr", l_addircstr},
     {"connect", l_start_irc},
     {"dnslookup", l_dnslookup},
     {"irccase", l_irccase},
     {"isalnum", l_isalnum},
+    {"metrics", l_metrics},
+    {"newloadtracker", l_new_load_tracker},
+    {"neworderedmap", l_new_ordered_map},
     {"newtimer", l_new_timer},
     {"parse_irc_tags", l_parse_irc_tags},
     {"parse_irc", l_parse_irc},
+    {"profile_report", l_profile_report},
+    {"profile_reset", l_profile_reset},
+    {"profile_start", l_profile_start},
+    {"profile_stop", l_profile_stop},
     {"pton", l_pton},
     {"raise", l_raise},
+    {"redraw", l_redraw},
+    {"set_frame_interval", l_set_frame_interval},
     {"setmodule", l_setmodule},
     {"shutdown", l_shutdown},
+    {"stripirc", l_stripirc},
     {"time", l_time},
     {"execute", l_execute},
     {"stop_input", l_stop_input},
@@ -425,6 +581,12 @@ auto prepare_globals(lua_State* const L, int const argc, char const* const* cons
     luaL_requiref(L, "mytoml", luaopen_mytoml, 1);
     lua_pop(L, 1);
 
+    luaL_requiref(L, "mysnote", luaopen_mysnote, 1);
+    lua_pop(L, 1);
+
+    luaL_requiref(L, "mylpm", luaopen_mylpm, 1);
+    lua_pop(L, 1);
+
 #ifdef LIBHS_FOUND
     luaL_requiref(L, "hsfilter", luaopen_hsfilter, 1);
     lua_pop(L, 1);
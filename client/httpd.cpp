@@ -1,6 +1,7 @@
 #include "httpd.hpp"
 #include "LuaRef.hpp"
 #include "app.hpp"
+#include "metrics.hpp"
 #include "safecall.hpp"
 #include "strings.hpp"
 #include "userdata.hpp"
@@ -264,6 +265,23 @@ auto handle_request(
             return res;
         };
 
+    static auto& requests = metrics::counter("httpd_requests_total", "HTTP requests handled");
+    static auto& latency = metrics::histogram("httpd_request_seconds", "Time to handle an HTTP request");
+    requests.add();
+    metrics::ScopedTimer const timer{latency};
+
+    // Serve the metrics registry for Prometheus without involving Lua
+    if (req.method() == http::verb::get && req.target() == "/metrics")
+    {
+        http::response<http::string_body> res{http::status::ok, req.version()};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "text/plain; version=0.0.4");
+        res.keep_alive(req.keep_alive());
+        res.body() = metrics::render_prometheus();
+        res.prepare_payload();
+        return res;
+    }
+
     auto const L = cb.get_lua();
     cb.push();
     push_string(L, req.method_string());
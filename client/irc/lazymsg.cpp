@@ -0,0 +1,339 @@
+#include "lazymsg.hpp"
+
+#include "lua.hpp"
+#include "../strings.hpp"
+#include "../userdata.hpp"
+
+#include <ircmsg.hpp>
+
+extern "C" {
+#include <lauxlib.h>
+#include <lua.h>
+}
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+namespace {
+
+using namespace std::literals::string_view_literals;
+
+/// @brief Location of a field within the stored line
+struct span
+{
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+/// @brief Header of a lazy message userdata
+///
+/// The header is followed in the same allocation by the key and value
+/// spans of each tag, the spans of each argument, and the line text.
+struct LazyIrcMsg
+{
+    std::uint32_t ntags;
+    std::uint32_t nargs;
+    span source;
+    span command;
+
+    auto spans() -> span* { return reinterpret_cast<span*>(this + 1); }
+    auto tags() -> span* { return spans(); }
+    auto args() -> span* { return spans() + 2 * ntags; }
+    auto text() -> char const* { return reinterpret_cast<char const*>(args() + nargs); }
+    auto view(span const s) -> std::string_view { return {text() + s.offset, s.length}; }
+};
+
+} // namespace
+
+template <>
+char const* udata_name<LazyIrcMsg> = "lazy_ircmsg";
+
+namespace {
+
+/// @brief Push the table of user-assigned fields, creating it if needed
+auto push_fields(lua_State* const L, int const ud) -> void
+{
+    if (LUA_TTABLE != lua_getiuservalue(L, ud, 1))
+    {
+        lua_pop(L, 1);
+        lua_createtable(L, 0, 4);
+        lua_pushvalue(L, -1);
+        lua_setiuservalue(L, ud, 1);
+    }
+}
+
+/// @brief Get the argument position named by an integral number key, or 0
+///
+/// Numeric strings are not converted, matching table indexing.
+auto number_key(lua_State* const L, int const idx) -> lua_Integer
+{
+    int isint = 0;
+    auto const i = LUA_TNUMBER == lua_type(L, idx) ? lua_tointegerx(L, idx, &isint) : 0;
+    return isint ? i : 0;
+}
+
+auto l_index(lua_State* const L) -> int
+{
+    auto const m = check_udata<LazyIrcMsg>(L, 1);
+
+    // Assigned fields and cached values take priority
+    if (LUA_TTABLE == lua_getiuservalue(L, 1, 1))
+    {
+        lua_pushvalue(L, 2);
+        if (LUA_TNIL != lua_rawget(L, -2))
+        {
+            return 1;
+        }
+    }
+    lua_settop(L, 2);
+
+    if (LUA_TNUMBER == lua_type(L, 2))
+    {
+        auto const i = number_key(L, 2);
+        if (1 <= i && i <= lua_Integer{m->nargs})
+        {
+            push_string(L, m->view(m->args()[i - 1]));
+        }
+        else
+        {
+            lua_pushnil(L);
+        }
+        return 1;
+    }
+
+    if (LUA_TSTRING != lua_type(L, 2))
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    auto const key = check_string_view(L, 2);
+    if ("command"sv == key)
+    {
+        pushcommand(L, m->view(m->command));
+    }
+    else if ("source"sv == key)
+    {
+        if (0 == m->source.length)
+        {
+            lua_pushnil(L);
+        }
+        else
+        {
+            push_string(L, m->view(m->source));
+        }
+    }
+    else if ("tags"sv == key)
+    {
+        // Cache the table so repeated lookups share one table
+        lua_createtable(L, 0, m->ntags);
+        for (std::uint32_t t = 0; t < m->ntags; t++)
+        {
+            push_string(L, m->view(m->tags()[2 * t]));
+            push_string(L, m->view(m->tags()[2 * t + 1]));
+            lua_settable(L, -3);
+        }
+        push_fields(L, 1);
+        lua_pushvalue(L, -2);
+        lua_setfield(L, -2, "tags");
+        lua_pop(L, 1);
+    }
+    else
+    {
+        lua_pushnil(L);
+    }
+    return 1;
+}
+
+auto l_newindex(lua_State* const L) -> int
+{
+    check_udata<LazyIrcMsg>(L, 1);
+    lua_settop(L, 3);
+    push_fields(L, 1);
+    lua_insert(L, 2);
+    lua_rawset(L, 2);
+    return 0;
+}
+
+auto l_len(lua_State* const L) -> int
+{
+    auto const m = check_udata<LazyIrcMsg>(L, 1);
+    lua_pushinteger(L, m->nargs);
+    return 1;
+}
+
+/// Named fields resolved from the line, in iteration order
+char const* const builtin_fields[]{"command", "source", "tags"};
+
+/// @brief Position of a key among the named fields, or -1
+auto builtin_field(lua_State* const L, int const idx) -> int
+{
+    if (LUA_TSTRING == lua_type(L, idx))
+    {
+        auto const key = check_string_view(L, idx);
+        for (int i = 0; i < static_cast<int>(std::size(builtin_fields)); i++)
+        {
+            if (key == builtin_fields[i])
+            {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+/// @brief Check if the value at idx is the index of an argument
+auto is_arg_index(lua_State* const L, LazyIrcMsg* const m, int const idx) -> bool
+{
+    auto const i = number_key(L, idx);
+    return 1 <= i && i <= lua_Integer{m->nargs};
+}
+
+/// @brief Push the value of the key on top of the stack and return 2
+auto push_entry(lua_State* const L) -> int
+{
+    lua_pushvalue(L, -1);
+    lua_gettable(L, 1);
+    return 2;
+}
+
+/// @brief Continue iterating the assigned fields after the key on top of the stack
+auto next_assigned(lua_State* const L, LazyIrcMsg* const m) -> int
+{
+    if (LUA_TTABLE != lua_getiuservalue(L, 1, 1))
+    {
+        return 0;
+    }
+    lua_insert(L, -2);
+    while (0 != lua_next(L, -2))
+    {
+        lua_pop(L, 1);
+        // Cached and shadowing entries are visited with the parsed fields
+        if (not is_arg_index(L, m, -1) && builtin_field(L, -1) < 0)
+        {
+            return push_entry(L);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Iterator behind pairs(msg)
+ *
+ * Visits the arguments in order, then the named fields that have
+ * values, then the assigned fields. Values are looked up through
+ * __index so assigned fields shadow the parsed ones.
+ */
+auto l_next(lua_State* const L) -> int
+{
+    auto const m = check_udata<LazyIrcMsg>(L, 1);
+    lua_settop(L, 2);
+
+    auto const nil = lua_isnil(L, 2);
+    auto const is_arg = is_arg_index(L, m, 2);
+    auto const field = builtin_field(L, 2);
+    if (not nil && not is_arg && field < 0)
+    {
+        return next_assigned(L, m);
+    }
+
+    auto const arg = is_arg ? lua_tointeger(L, 2) : nil ? 0 : lua_Integer{m->nargs};
+    if (arg < lua_Integer{m->nargs})
+    {
+        lua_pushinteger(L, arg + 1);
+        return push_entry(L);
+    }
+
+    for (auto i = field + 1; i < static_cast<int>(std::size(builtin_fields)); i++)
+    {
+        lua_pushstring(L, builtin_fields[i]);
+        lua_pushvalue(L, -1);
+        if (LUA_TNIL != lua_gettable(L, 1))
+        {
+            return 2;
+        }
+        lua_pop(L, 2);
+    }
+
+    lua_pushnil(L);
+    return next_assigned(L, m);
+}
+
+auto l_pairs(lua_State* const L) -> int
+{
+    check_udata<LazyIrcMsg>(L, 1);
+    lua_pushcfunction(L, l_next);
+    lua_pushvalue(L, 1);
+    lua_pushnil(L);
+    return 3;
+}
+
+luaL_Reg const MT[]{
+    {"__index", l_index},
+    {"__newindex", l_newindex},
+    {"__len", l_len},
+    {"__pairs", l_pairs},
+    {}
+};
+
+} // namespace
+
+auto pushlazyircmsg(lua_State* const L, char const* const line, ircmsg const& msg) -> void
+{
+    // Find the extent of the line that is referenced by the message
+    char const* end = line;
+    auto const extend = [&end](std::string_view const field) {
+        if (nullptr != field.data())
+        {
+            end = std::max(end, field.data() + field.size());
+        }
+    };
+    extend(msg.source);
+    extend(msg.command);
+    for (auto&& tag : msg.tags)
+    {
+        extend(tag.key);
+        extend(tag.val);
+    }
+    for (auto&& arg : msg.args)
+    {
+        extend(arg);
+    }
+
+    auto const nspans = 2 * msg.tags.size() + msg.args.size();
+    auto const textlen = static_cast<std::size_t>(end - line);
+    auto const m = static_cast<LazyIrcMsg*>(
+        lua_newuserdatauv(L, sizeof(LazyIrcMsg) + sizeof(span) * nspans + textlen, 1)
+    );
+    if (luaL_newmetatable(L, udata_name<LazyIrcMsg>))
+    {
+        luaL_setfuncs(L, MT, 0);
+    }
+    lua_setmetatable(L, -2);
+
+    auto const to_span = [line](std::string_view const field) -> span {
+        return nullptr == field.data()
+            ? span{0, 0}
+            : span{static_cast<std::uint32_t>(field.data() - line), static_cast<std::uint32_t>(field.size())};
+    };
+
+    m->ntags = msg.tags.size();
+    m->nargs = msg.args.size();
+    m->source = to_span(msg.source);
+    m->command = to_span(msg.command);
+
+    auto cursor = m->spans();
+    for (auto&& tag : msg.tags)
+    {
+        *cursor++ = to_span(tag.key);
+        *cursor++ = to_span(tag.val);
+    }
+    for (auto&& arg : msg.args)
+    {
+        *cursor++ = to_span(arg);
+    }
+    std::memcpy(cursor, line, textlen);
+}
@@ -0,0 +1,28 @@
+#pragma once
+/**
+ * @file lazymsg.hpp
+ * @author Eric Mertens (emertens@gmail.com)
+ * @brief Userdata-backed IRC messages with on-demand fields
+ *
+ */
+
+struct lua_State;
+struct ircmsg;
+
+/**
+ * @brief Push an IRC message as a userdata that resolves fields on demand
+ *
+ * The userdata holds a single copy of the parsed line. The fields
+ * command, source, tags, and the integer-indexed arguments are only
+ * converted into Lua values when they are indexed. Other fields can
+ * be assigned and are stored alongside the message.
+ *
+ * The message supports indexing, #, and pairs like the table it
+ * replaces, but type() reports "userdata" and the raw table functions
+ * such as next and rawget do not see its fields.
+ *
+ * @param L Lua state
+ * @param line Start of the line that msg was parsed from
+ * @param msg Message parsed in place from line
+ */
+auto pushlazyircmsg(lua_State* L, char const* line, ircmsg const& msg) -> void;
@@ -1,6 +1,11 @@
 #include "lua.hpp"
+#include "lazymsg.hpp"
+#include "messagearena.hpp"
 #include "../app.hpp"
+#include "../metrics.hpp"
+#include "../net/capture.hpp"
 #include "../net/linebuffer.hpp"
+#include "../net/mpscqueue.hpp"
 #include "../safecall.hpp"
 #include "../strings.hpp"
 #include "../userdata.hpp"
@@ -16,12 +21,19 @@ extern "C" {
 #include <lua.h>
 }
 
+#include <atomic>
 #include <charconv> // from_chars
+#include <chrono>
+#include <cstring>
 #include <fcntl.h>
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <system_error>
+#include <utility>
 #include <variant>
+#include <vector>
 
 namespace {
 
@@ -30,13 +42,26 @@ using namespace std::literals::string_view_literals;
 using tcp_type = boost::asio::ip::tcp::socket;
 using tls_type = boost::asio::ssl::stream<tcp_type>;
 
+/// True when the connection runs on a network thread instead of the Lua thread
+auto is_remote(lua_State* const L, connection const& irc) -> bool
+{
+    return &irc.get_executor().context() != &App::from_lua(L)->get_context();
+}
+
 auto l_close_irc(lua_State* const L) -> int
 {
     auto const w = check_udata<std::weak_ptr<connection>>(L, 1);
 
     if (auto const irc = w->lock())
     {
-        irc->close();
+        if (is_remote(L, *irc))
+        {
+            boost::asio::post(irc->get_executor(), [irc] { irc->close(); });
+        }
+        else
+        {
+            irc->close();
+        }
         w->reset();
         lua_pushboolean(L, 1);
         return 1;
@@ -49,15 +74,73 @@ auto l_close_irc(lua_State* const L) -> int
     }
 }
 
+char const* const lane_names[] = {"urgent", "normal", "bulk", nullptr};
+Lane const lane_values[] = {Lane::Urgent, Lane::Normal, Lane::Bulk};
+
 auto l_send_irc(lua_State* const L) -> int
 {
     auto const w = check_udata<std::weak_ptr<connection>>(L, 1);
     auto const cmd = check_string_view(L, 2);
+    auto const lane = lua_isnoneornil(L, 3) ? message_lane(cmd) : lane_values[luaL_checkoption(L, 3, nullptr, lane_names)];
 
     if (auto const irc = w->lock())
     {
-        irc->write(cmd);
-        lua_pushboolean(L, 1);
+        if (is_remote(L, *irc))
+        {
+            lua_pushboolean(L, irc->post_send(std::string{cmd}, lane));
+            lua_pushinteger(L, irc->snapshot().backlog());
+        }
+        else
+        {
+            lua_pushboolean(L, irc->send(cmd, lane));
+            lua_pushinteger(L, irc->backlog());
+        }
+        return 2;
+    }
+    else
+    {
+        luaL_pushfail(L);
+        push_string(L, "irc handle destructed"sv);
+        return 2;
+    }
+}
+
+auto l_stats_irc(lua_State* const L) -> int
+{
+    auto const w = check_udata<std::weak_ptr<connection>>(L, 1);
+
+    if (auto const irc = w->lock())
+    {
+        auto const snapshot = irc->snapshot();
+        auto const& stats = snapshot.stats;
+        lua_createtable(L, 0, 10);
+        lua_pushinteger(L, stats.queued_bytes);
+        lua_setfield(L, -2, "queued_bytes");
+        lua_pushinteger(L, stats.queued_messages);
+        lua_setfield(L, -2, "queued_messages");
+        lua_pushinteger(L, stats.sent_bytes);
+        lua_setfield(L, -2, "sent_bytes");
+        lua_pushinteger(L, stats.sent_messages);
+        lua_setfield(L, -2, "sent_messages");
+        lua_pushinteger(L, stats.writes);
+        lua_setfield(L, -2, "writes");
+        lua_pushinteger(L, irc->high_water());
+        lua_setfield(L, -2, "high_water");
+
+        lua_pushinteger(L, snapshot.scheduled_bytes);
+        lua_setfield(L, -2, "scheduled_bytes");
+        for (std::size_t i = 0; i < lane_count; i++)
+        {
+            auto const& lane = snapshot.lanes[i];
+            lua_createtable(L, 0, 3);
+            lua_pushinteger(L, lane.depth);
+            lua_setfield(L, -2, "depth");
+            lua_pushinteger(L, lane.peak);
+            lua_setfield(L, -2, "peak");
+            lua_pushinteger(L, lane.sent);
+            lua_setfield(L, -2, "sent");
+            lua_setfield(L, -2, lane_names[i]);
+        }
         return 1;
     }
     else
@@ -86,6 +169,7 @@ auto pushirc(lua_State* const L, std::weak_ptr<connection> const irc) -> void
         // Setup class methods for IRC objects
         luaL_Reg const Methods[]{
             {"send", l_send_irc},
+            {"stats", l_stats_irc},
             {"close", l_close_irc},
             {}
         };
@@ -96,6 +180,49 @@ auto pushirc(lua_State* const L, std::weak_ptr<connection> const irc) -> void
     std::construct_at(w, irc);
 }
 
+/// Options controlling how messages are delivered to Lua
+struct Delivery
+{
+    /// Deliver messages as userdata resolving fields on demand
+    bool lazy;
+    /// Deliver all messages from a single read in one callback
+    bool batch;
+};
+
+/// Metrics recorded by IRC sessions
+struct SessionMetrics
+{
+    metrics::Gauge& sessions = metrics::gauge("irc_sessions", "Active IRC sessions");
+    metrics::Counter& bytes_read = metrics::counter("irc_read_bytes_total", "Bytes read from IRC servers");
+    metrics::Counter& lines = metrics::counter("irc_lines_parsed_total", "IRC lines parsed");
+    metrics::Counter& parse_errors =
+        metrics::counter("irc_parse_errors_total", "Malformed IRC lines skipped by batched delivery");
+    metrics::Histogram& parse_time = metrics::histogram("irc_parse_seconds", "Time to parse one IRC line");
+    metrics::Histogram& push_time =
+        metrics::histogram("irc_push_seconds", "Time to build the Lua value of one IRC message");
+    metrics::Histogram& callback_time =
+        metrics::histogram("irc_callback_seconds", "Time in the Lua callback per IRC message");
+};
+
+auto session_metrics() -> SessionMetrics&
+{
+    static SessionMetrics instance;
+    return instance;
+}
+
+/// Parse a line while recording parse metrics
+///
+/// @param line Line to parse in place
+/// @return Parsed message
+/// @throws irc_parse_error when the line is malformed
+auto timed_parse(char* const line) -> ircmsg
+{
+    auto& m = session_metrics();
+    metrics::ScopedTimer const timer{m.parse_time};
+    m.lines.add();
+    return parse_irc_message(line);
+}
+
 /// Retrieve the next non-empty line from the buffer.
 ///
 /// Leading spaces are trimmed from each line before checking for emptiness.
@@ -120,6 +247,211 @@ auto get_nonempty_line(LineBuffer& buff) -> char *
     return nullptr;
 }
 
+/// Read the optional delivery options table
+///
+/// @param L Lua state
+/// @param arg Argument index of the options table
+/// @return Delivery options with unspecified fields defaulted
+auto check_delivery(lua_State* const L, int const arg) -> Delivery
+{
+    Delivery delivery{};
+    if (not lua_isnoneornil(L, arg))
+    {
+        luaL_checktype(L, arg, LUA_TTABLE);
+        lua_getfield(L, arg, "lazy");
+        delivery.lazy = lua_toboolean(L, -1);
+        lua_getfield(L, arg, "batch");
+        delivery.batch = lua_toboolean(L, -1);
+        lua_pop(L, 2);
+    }
+    return delivery;
+}
+
+/// Read the send queue high-water mark from the options table
+///
+/// @param L Lua state
+/// @param arg Argument index of the options table
+/// @return Queue size in bytes at which sends report backpressure
+auto check_high_water(lua_State* const L, int const arg) -> std::size_t
+{
+    lua_Integer high_water = connection::irc_buffer_max_size;
+    if (lua_istable(L, arg))
+    {
+        lua_getfield(L, arg, "send_high_water");
+        high_water = luaL_optinteger(L, -1, high_water);
+        lua_pop(L, 1);
+        luaL_argcheck(L, 0 < high_water, arg, "send_high_water must be positive");
+    }
+    return high_water;
+}
+
+/// Flood-control parameters from the options table
+struct Pacing
+{
+    /// Messages sent back-to-back before pacing starts
+    lua_Number burst;
+    /// Messages per second; non-positive disables pacing
+    lua_Number rate;
+};
+
+/// Read the flood-control options from the options table
+///
+/// @param L Lua state
+/// @param arg Argument index of the options table
+/// @return Pacing parameters, unpaced by default
+auto check_pacing(lua_State* const L, int const arg) -> Pacing
+{
+    Pacing pacing{1, 0};
+    if (lua_istable(L, arg))
+    {
+        lua_getfield(L, arg, "send_burst");
+        pacing.burst = luaL_optnumber(L, -1, pacing.burst);
+        lua_getfield(L, arg, "send_rate");
+        pacing.rate = luaL_optnumber(L, -1, pacing.rate);
+        lua_pop(L, 2);
+    }
+    return pacing;
+}
+
+/// Traffic recording and replay parameters from the options table
+///
+/// The file names point into the options table and are only valid while it is.
+struct Capture
+{
+    /// File recording received lines; empty when not recording
+    char const* record;
+    /// File read in place of the server; empty when connecting normally
+    char const* replay;
+    /// Replay rate relative to the recording; non-positive is as fast as possible
+    lua_Number replay_speed;
+};
+
+/// Read the capture and replay options from the options table
+///
+/// @param L Lua state
+/// @param arg Argument index of the options table
+/// @return Capture parameters, neither recording nor replaying by default
+auto check_capture(lua_State* const L, int const arg) -> Capture
+{
+    Capture capture{"", "", 0};
+    if (lua_istable(L, arg))
+    {
+        lua_getfield(L, arg, "capture");
+        capture.record = luaL_optstring(L, -1, "");
+        lua_getfield(L, arg, "replay");
+        capture.replay = luaL_optstring(L, -1, "");
+        lua_getfield(L, arg, "replay_speed");
+        capture.replay_speed = luaL_optnumber(L, -1, capture.replay_speed);
+        lua_pop(L, 3);
+    }
+    return capture;
+}
+
+/// Push a parsed message in the representation selected by the delivery options
+///
+/// @param L Lua state
+/// @param delivery Delivery options
+/// @param line Line the message was parsed from
+/// @param msg Parsed message
+auto push_message(lua_State* const L, Delivery const delivery, char const* const line, ircmsg const& msg) -> void
+{
+    metrics::ScopedTimer const timer{session_metrics().push_time};
+    if (delivery.lazy)
+    {
+        pushlazyircmsg(L, line, msg);
+    }
+    else
+    {
+        pushircmsg(L, msg);
+    }
+}
+
+/// Report a malformed line skipped by batched delivery
+///
+/// Invokes cb("BAD", error_message).
+///
+/// @param L Lua state
+/// @param irc_cb Registry reference to the callback
+/// @param message Description of the parse error
+auto deliver_parse_error(lua_State* const L, int const irc_cb, char const* const message) -> void
+{
+    session_metrics().parse_errors.add();
+    lua_rawgeti(L, LUA_REGISTRYINDEX, irc_cb);
+    push_string(L, "BAD"sv);
+    lua_pushstring(L, message);
+    safecall(L, "irc parse error"sv, 2);
+}
+
+/// Deliver every complete line in the buffer in a single callback
+///
+/// Invokes cb("MSGS", ircmsgs) when at least one line is available. A
+/// malformed line splits the batch: the messages before it are delivered,
+/// then cb("BAD", error_message), then the messages after it.
+///
+/// @param L Lua state
+/// @param irc_cb Registry reference to the callback
+/// @param delivery Delivery options
+/// @param buff Line buffer holding freshly read data
+auto deliver_batch(lua_State* const L, int const irc_cb, Delivery const delivery, LineBuffer& buff) -> void
+{
+    auto line = get_nonempty_line(buff);
+    while (nullptr != line)
+    {
+        auto const top = lua_gettop(L);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, irc_cb);
+        push_string(L, "MSGS"sv);
+        lua_createtable(L, 16, 0);
+
+        lua_Integer n = 0;
+        std::optional<irc_parse_error> error;
+        try
+        {
+            for (; nullptr != line && not error; line = get_nonempty_line(buff))
+            {
+                ircmsg msg;
+                try
+                {
+                    msg = timed_parse(line);
+                }
+                catch (irc_parse_error const& e)
+                {
+                    error = e;
+                    continue;
+                }
+                push_message(L, delivery, line, msg);
+                lua_rawseti(L, -2, ++n);
+            }
+        }
+        catch (...)
+        {
+            lua_settop(L, top);
+            throw;
+        }
+
+        if (0 == n)
+        {
+            lua_settop(L, top);
+        }
+        else
+        {
+            auto const start = std::chrono::steady_clock::now();
+            safecall(L, "irc messages"sv, 2);
+
+            // Attribute the batch callback time evenly to its messages
+            auto const each = (std::chrono::steady_clock::now() - start) / n;
+            for (lua_Integer i = 0; i < n; i++)
+            {
+                session_metrics().callback_time.record(each);
+            }
+        }
+
+        if (error)
+        {
+            deliver_parse_error(L, irc_cb, error->what());
+        }
+    }
+}
+
 /// Coroutine that handles the IRC session.
 /// It connects to the IRC server, reads messages from the stream,
 /// and invokes the provided callback function
@@ -129,16 +461,28 @@ auto get_nonempty_line(LineBuffer& buff) -> char *
 /// @param irc_cb The Lua callback function reference.
 /// @param irc The shared pointer to the IRC connection.
 /// @param settings The settings for the IRC connection.
+/// @param delivery Options for passing messages to Lua.
+/// @param record Capture file recording received lines, empty when not recording.
 /// @return An awaitable that runs the session thread.
-/// @throws std::runtime_error if the line buffer is full.
+/// @throws std::runtime_error if a line exceeds the maximum buffer size.
 auto session_thread(
     boost::asio::io_context& io_context,
     lua_State* const L,
     int const irc_cb,
     std::shared_ptr<connection> const irc,
-    Settings settings
+    Settings settings,
+    Delivery const delivery,
+    std::string record
 ) -> boost::asio::awaitable<void>
 {
+    auto& m = session_metrics();
+
+    std::optional<CaptureWriter> capture;
+    if (not record.empty())
+    {
+        capture.emplace(CaptureWriter::open(record));
+    }
+
     // Connect and invoke the callback function:
     // cb("CON", fingerprint)
     {
@@ -151,8 +495,8 @@ auto session_thread(
     }
 
     // Continuously process lines from the stream and invoke the callback
-    // cb("MSG", ircmsg, redraw)
-    for (LineBuffer buff{connection::irc_buffer_size};;)
+    // cb("MSG", ircmsg, redraw) or cb("MSGS", ircmsgs)
+    for (LineBuffer buff{connection::irc_buffer_size, connection::irc_buffer_max_size};;)
     {
         auto const target = buff.prepare();
         if (target.size() == 0)
@@ -160,22 +504,459 @@ auto session_thread(
             throw std::runtime_error{"line buffer full"};
         }
 
-        buff.commit(co_await irc->get_stream().async_read_some(target, boost::asio::use_awaitable));
+        auto const n = co_await irc->get_stream().async_read_some(target, boost::asio::use_awaitable);
+        m.bytes_read.add(n);
+        if (capture)
+        {
+            capture->write(std::chrono::system_clock::now(), {static_cast<char const*>(target.data()), n});
+        }
+        buff.commit(n);
+        if (delivery.batch)
+        {
+            deliver_batch(L, irc_cb, delivery, buff);
+            buff.shift();
+            continue;
+        }
+
         for (auto line = get_nonempty_line(buff); nullptr != line; /* empty */)
         {
-            auto const msg = parse_irc_message(line); // might throw
-            line = get_nonempty_line(buff); // pre-load next line
+            auto const msg = timed_parse(line); // might throw
+            auto const next = get_nonempty_line(buff); // pre-load next line
 
             lua_rawgeti(L, LUA_REGISTRYINDEX, irc_cb);
             push_string(L, "MSG"sv);
-            pushircmsg(L, msg);
-            lua_pushboolean(L, nullptr == line); // draw on last line
+            push_message(L, delivery, line, msg);
+            lua_pushboolean(L, nullptr == next); // draw on last line
+
+            metrics::ScopedTimer const timer{m.callback_time};
             safecall(L, "irc message"sv, 3);
+
+            line = next;
         }
         buff.shift();
     }
 }
 
+/// Read the option requesting kernel TLS offload
+///
+/// @param L Lua state
+/// @param arg Argument index of the options table
+/// @return True to request kernel TLS offload
+auto check_ktls(lua_State* const L, int const arg) -> bool
+{
+    bool ktls = false;
+    if (lua_istable(L, arg))
+    {
+        lua_getfield(L, arg, "ktls");
+        ktls = lua_toboolean(L, -1);
+        lua_pop(L, 1);
+    }
+    return ktls;
+}
+
+/// Read the TLS session cache option
+///
+/// The file name points into the options table and is only valid while it is.
+///
+/// @param L Lua state
+/// @param arg Argument index of the options table
+/// @return Session file, empty for an in-memory cache, or nullptr to disable resumption
+auto check_session_cache(lua_State* const L, int const arg) -> char const*
+{
+    char const* path = "";
+    if (lua_istable(L, arg))
+    {
+        lua_getfield(L, arg, "session_cache");
+        if (LUA_TBOOLEAN == lua_type(L, -1))
+        {
+            path = lua_toboolean(L, -1) ? "" : nullptr;
+        }
+        else
+        {
+            path = luaL_optstring(L, -1, path);
+        }
+        lua_pop(L, 1);
+    }
+    return path;
+}
+
+/// Find the TLS session cache for a session file, loading it on first use
+///
+/// Reconnects share a cache so they can resume the previous session.
+///
+/// @param path Session file or empty for the in-memory cache
+/// @return Cache shared by every connection using the same file
+auto session_cache(std::string const& path) -> std::shared_ptr<TlsSessionCache>
+{
+    // Never destroyed so no session is freed after OpenSSL's exit handler runs
+    static auto& caches = *new std::map<std::string, std::shared_ptr<TlsSessionCache>>;
+    auto& cache = caches[path];
+    if (not cache)
+    {
+        cache = std::make_shared<TlsSessionCache>(path);
+    }
+    return cache;
+}
+
+/// Thread that reads and parses a connection's traffic
+enum class Threading
+{
+    /// The Lua thread
+    None,
+    /// A network thread that may serve other connections
+    Shared,
+    /// A network thread serving only this connection
+    Dedicated,
+};
+
+/// Read the option to run the connection on a network thread
+///
+/// @param L Lua state
+/// @param arg Argument index of the options table
+/// @return Thread selected by the thread option
+auto check_thread(lua_State* const L, int const arg) -> Threading
+{
+    auto threading = Threading::None;
+    if (lua_istable(L, arg))
+    {
+        lua_getfield(L, arg, "thread");
+        if (LUA_TSTRING == lua_type(L, -1))
+        {
+            char const* const names[] = {"shared", "dedicated", nullptr};
+            Threading const values[] = {Threading::Shared, Threading::Dedicated};
+            auto const name = lua_tostring(L, -1);
+            auto i = 0;
+            while (names[i] && 0 != std::strcmp(names[i], name))
+            {
+                i++;
+            }
+            luaL_argcheck(L, nullptr != names[i], arg, "thread must be a boolean, 'shared', or 'dedicated'");
+            threading = values[i];
+        }
+        else if (lua_toboolean(L, -1))
+        {
+            threading = Threading::Shared;
+        }
+        lua_pop(L, 1);
+    }
+    return threading;
+}
+
+/// Bytes of parsed lines a network thread may queue ahead of the Lua thread
+std::size_t const remote_backlog_limit = 4 * connection::irc_buffer_max_size;
+
+/// State shared by a session on a network thread and the Lua thread
+struct RemoteSession
+{
+    /// Context running the Lua thread
+    boost::asio::io_context& main;
+    /// Context running the network thread
+    boost::asio::io_context& network;
+    lua_State* L;
+    int irc_cb;
+    Delivery delivery;
+    /// Bytes of delivered lines not yet passed to Lua
+    std::atomic<std::size_t> backlog;
+    /// Arenas passed to Lua and cleared for reuse by the network thread
+    MpscQueue<MessageArena> spares;
+    /// Set by the network thread before it waits for the backlog to drain
+    std::atomic<bool> paused {false};
+    /// Timer the paused network thread waits on; only used on the network thread
+    boost::asio::steady_timer* resume {nullptr};
+};
+
+/// Wake the network thread if it paused for the backlog to drain
+///
+/// Called on the Lua thread after the backlog drops to the limit.
+///
+/// @param session Session whose network thread may be paused
+auto resume_reading(std::shared_ptr<RemoteSession> const& session) -> void
+{
+    if (session->paused.exchange(false))
+    {
+        // The network thread checks the backlog and starts waiting without
+        // yielding, so this can't run between the two
+        boost::asio::post(session->network, [session] {
+            if (session->resume)
+            {
+                session->resume->cancel();
+            }
+        });
+    }
+}
+
+/// Session event marshalled from a network thread to the Lua thread
+struct SessionEvent
+{
+    enum class Kind
+    {
+        Connect,
+        Messages,
+        ParseError,
+        End,
+    };
+
+    std::shared_ptr<RemoteSession> session;
+    Kind kind;
+
+    /// Fingerprint of CON, error message of BAD, or error message of END
+    std::optional<std::string> message {};
+
+    /// Messages parsed from one read
+    MessageArena arena {};
+};
+
+/// Invoke the callback for one event on the Lua thread
+///
+/// @param event Event to deliver
+auto deliver_event(SessionEvent& event) -> void
+{
+    auto& session = *event.session;
+    auto const L = session.L;
+    auto& m = session_metrics();
+
+    switch (event.kind)
+    {
+    case SessionEvent::Kind::Connect:
+        lua_rawgeti(L, LUA_REGISTRYINDEX, session.irc_cb);
+        push_string(L, "CON"sv);
+        push_string(L, *event.message);
+        safecall(L, "successful connect"sv, 2);
+        break;
+
+    case SessionEvent::Kind::Messages:
+    {
+        auto const& arena = event.arena;
+        auto const n = arena.size();
+        auto const backlog = session.backlog -= arena.bytes();
+        if (backlog <= remote_backlog_limit)
+        {
+            resume_reading(event.session);
+        }
+
+        if (session.delivery.batch)
+        {
+            lua_rawgeti(L, LUA_REGISTRYINDEX, session.irc_cb);
+            push_string(L, "MSGS"sv);
+            lua_createtable(L, n, 0);
+            for (std::size_t i = 0; i < n; i++)
+            {
+                push_message(L, session.delivery, arena.line(i), arena.message(i));
+                lua_rawseti(L, -2, i + 1);
+            }
+
+            auto const start = std::chrono::steady_clock::now();
+            safecall(L, "irc messages"sv, 2);
+
+            // Attribute the batch callback time evenly to its messages
+            auto const each = (std::chrono::steady_clock::now() - start) / n;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                m.callback_time.record(each);
+            }
+        }
+        else
+        {
+            for (std::size_t i = 0; i < n; i++)
+            {
+                lua_rawgeti(L, LUA_REGISTRYINDEX, session.irc_cb);
+                push_string(L, "MSG"sv);
+                push_message(L, session.delivery, arena.line(i), arena.message(i));
+                lua_pushboolean(L, i + 1 == n); // draw on last line
+
+                metrics::ScopedTimer const timer{m.callback_time};
+                safecall(L, "irc message"sv, 3);
+            }
+        }
+
+        event.arena.clear();
+        session.spares.push(std::move(event.arena));
+        break;
+    }
+
+    case SessionEvent::Kind::ParseError:
+        deliver_parse_error(L, session.irc_cb, event.message->c_str());
+        break;
+
+    case SessionEvent::Kind::End:
+        m.sessions.add(-1);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, session.irc_cb);
+        luaL_unref(L, LUA_REGISTRYINDEX, session.irc_cb);
+        push_string(L, "END"sv);
+        if (event.message)
+        {
+            push_string(L, *event.message);
+        }
+        else
+        {
+            lua_pushnil(L);
+        }
+        safecall(L, "end of connection", 2);
+        break;
+    }
+}
+
+/// Events from every network thread waiting for the Lua thread
+///
+/// Producers wake the Lua thread with a single post no matter how many
+/// events they push before it runs.
+class Inbox
+{
+    MpscQueue<SessionEvent> queue_;
+
+    /// True while a drain is posted and hasn't started
+    std::atomic<bool> scheduled_ {false};
+
+    auto schedule(boost::asio::io_context& main) -> void
+    {
+        if (not scheduled_.exchange(true))
+        {
+            boost::asio::post(main, [this, &main] { drain(main); });
+        }
+    }
+
+    auto drain(boost::asio::io_context& main) -> void
+    {
+        scheduled_ = false;
+        while (auto event = queue_.pop())
+        {
+            deliver_event(*event);
+        }
+
+        // A producer was midway through a push; its event shows up shortly
+        if (not queue_.empty())
+        {
+            schedule(main);
+        }
+    }
+
+public:
+    /// Queue an event for the Lua thread; safe to call from any thread
+    auto push(SessionEvent event) -> void
+    {
+        auto& main = event.session->main;
+        queue_.push(std::move(event));
+        schedule(main);
+    }
+};
+
+auto inbox() -> Inbox&
+{
+    static Inbox instance;
+    return instance;
+}
+
+/// Hand the messages parsed so far to the Lua thread
+///
+/// @param session State shared with the Lua thread
+/// @param arena Parsed messages; replaced by a spare arena when not empty
+auto flush_messages(std::shared_ptr<RemoteSession> const& session, MessageArena& arena) -> void
+{
+    if (arena.empty())
+    {
+        return;
+    }
+
+    session->backlog += arena.bytes();
+    inbox().push({
+        .session = session,
+        .kind = SessionEvent::Kind::Messages,
+        .arena = std::exchange(arena, session->spares.pop().value_or(MessageArena{})),
+    });
+}
+
+/// Coroutine that handles an IRC session on a network thread.
+///
+/// Lines are read, decrypted, split, and parsed on the connection's
+/// thread into a message arena and delivered to the Lua thread through
+/// the inbox one read at a time. Arenas come back cleared for reuse.
+/// Reading pauses while the Lua thread is behind by more than
+/// remote_backlog_limit bytes, and the Lua thread wakes it once it has
+/// caught up.
+///
+/// @param session State shared with the Lua thread
+/// @param irc The shared pointer to the IRC connection.
+/// @param settings The settings for the IRC connection.
+/// @param record Capture file recording received lines, empty when not recording.
+/// @return An awaitable that runs the session thread.
+/// @throws std::runtime_error if a line exceeds the maximum buffer size.
+auto remote_session_thread(
+    std::shared_ptr<RemoteSession> const session,
+    std::shared_ptr<connection> const irc,
+    Settings settings,
+    std::string record
+) -> boost::asio::awaitable<void>
+{
+    auto& m = session_metrics();
+
+    std::optional<CaptureWriter> capture;
+    if (not record.empty())
+    {
+        capture.emplace(CaptureWriter::open(record));
+    }
+
+    inbox().push({
+        .session = session,
+        .kind = SessionEvent::Kind::Connect,
+        .message = co_await irc->connect(std::move(settings)),
+    });
+
+    // Never expires; the Lua thread cancels it to resume reading
+    boost::asio::steady_timer resume{
+        co_await boost::asio::this_coro::executor, boost::asio::steady_timer::time_point::max()};
+    auto arena = session->spares.pop().value_or(MessageArena{});
+    for (LineBuffer buff{connection::irc_buffer_size, connection::irc_buffer_max_size};;)
+    {
+        // Publish the pause before checking the backlog so a drain that
+        // races with the check still sees it and sends a wakeup
+        for (session->paused = true; session->backlog > remote_backlog_limit; session->paused = true)
+        {
+            session->resume = &resume;
+            boost::system::error_code ec;
+            co_await resume.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            session->resume = nullptr;
+        }
+        session->paused = false;
+
+        auto const target = buff.prepare();
+        if (target.size() == 0)
+        {
+            throw std::runtime_error{"line buffer full"};
+        }
+
+        auto const n = co_await irc->get_stream().async_read_some(target, boost::asio::use_awaitable);
+        m.bytes_read.add(n);
+        if (capture)
+        {
+            capture->write(std::chrono::system_clock::now(), {static_cast<char const*>(target.data()), n});
+        }
+        buff.commit(n);
+
+        while (auto const line = get_nonempty_line(buff))
+        {
+            metrics::ScopedTimer const timer{m.parse_time};
+            m.lines.add();
+            try
+            {
+                arena.append(line);
+            }
+            catch (irc_parse_error const& e)
+            {
+                // Deliver the messages before the malformed line either way
+                flush_messages(session, arena);
+                if (not session->delivery.batch)
+                {
+                    throw;
+                }
+                // Keep the report in order with the messages around it
+                inbox().push({.session = session, .kind = SessionEvent::Kind::ParseError, .message = e.what()});
+            }
+        }
+        buff.shift();
+        flush_messages(session, arena);
+    }
+}
+
 } // namespace
 
 /**
@@ -193,13 +974,47 @@ auto session_thread(
  * param:       string?     Optional username for SOCKS5 proxy server
  * param:       string?     Optional password for SOCKS5 proxy server
  * param:       function    Callback function for events on IRC session
+ * param:       table?      Optional delivery options
+ *
+ * Delivery options:
+ * - lazy: deliver messages as userdata that build fields on demand
+ * - batch: deliver all messages from one read as a single MSGS event;
+ *   a malformed line is reported as a BAD event and skipped instead of
+ *   ending the session
+ * - send_high_water: queued bytes at which send reports backpressure
+ * - send_burst: messages sent back-to-back before pacing starts
+ * - send_rate: messages per second after the burst; unpaced when absent
+ * - capture: file recording each received line with its arrival time
+ * - replay: capture file read in place of connecting to the server;
+ *   sends are discarded and the session ends at the end of the file
+ * - replay_speed: replay rate relative to the recording; as fast as
+ *   possible when absent or non-positive
+ * - ktls: request kernel TLS offload of record encryption and decryption;
+ *   the CON fingerprint reports the offloaded directions as ktls=
+ * - session_cache: file keeping TLS sessions for resumption across
+ *   restarts; sessions are kept in memory when absent or true, and
+ *   resumption is disabled when false
+ * - thread: true or "shared" to decrypt, split, and parse lines on a
+ *   network thread shared with other connections, or "dedicated" for a
+ *   thread serving only this connection; parsed messages are handed to
+ *   the callback on the Lua thread
+ *
+ * Connection object methods:
+ * - send(msg, lane?) returns (below_high_water, queued_bytes)
+ *   where lane is "urgent", "normal", or "bulk"; the default lane
+ *   depends on the command: PONG is urgent and server queries like
+ *   STATS are bulk
+ * - stats() returns a table of send queue and per-lane counters
+ * - close()
  *
  * Callback events:
  * - cb("CON", fingerprint)
  * - cb("MSG", ircmsg, redraw)
+ * - cb("MSGS", ircmsgs) when batching; redraw after the batch
+ * - cb("BAD", error_message) when batching and a line is malformed
  * - cb("END", error_message)
  * 
- * Callback sequence: (CON MSG*)? END
+ * Callback sequence: (CON (MSG* | (MSGS | BAD)*))? END
  * 
  * @param L Lua state
  * @return int 1
@@ -218,7 +1033,13 @@ auto l_start_irc(lua_State* const L) -> int
     auto const socks_user = luaL_optlstring(L, 10, "", nullptr);
     auto const socks_pass = luaL_optlstring(L, 11, "", nullptr);
     luaL_checkany(L, 12); // callback
-    lua_settop(L, 12);
+    auto const delivery = check_delivery(L, 13);
+    auto const high_water = check_high_water(L, 13);
+    auto const pacing = check_pacing(L, 13);
+    auto const capture = check_capture(L, 13);
+    auto const threaded = check_thread(L, 13);
+    auto const ktls = check_ktls(L, 13);
+    auto const session_path = check_session_cache(L, 13);
     luaL_argcheck(L, 1 <= port && port <= 0xffff, 3, "port out of range");
     luaL_argcheck(L, 0 <= socks_port && socks_port <= 0xffff, 9, "port out of range");
 
@@ -234,20 +1055,65 @@ auto l_start_irc(lua_State* const L) -> int
         .client_key = client_key,
         .verify = verify,
         .sni = sni,
+        .ktls = ktls,
+        .session_cache = tls && session_path ? session_cache(session_path) : nullptr,
         .socks_host = socks_host,
         .socks_port = static_cast<std::uint16_t>(socks_port),
         .socks_auth = std::move(socks_auth),
+        .replay = capture.replay,
+        .replay_speed = capture.replay_speed,
     };
+    std::string record = capture.record;
+    lua_settop(L, 12); // the options table is no longer needed
 
     auto const app = App::from_lua(L);
     auto& io_context = app->get_context();
     auto const LMain = app->get_lua();
 
-    auto const irc = connection::create(io_context);
+    if (Threading::None != threaded)
+    {
+        // A dedicated thread runs until the session ends and releases its work
+        std::optional<NetworkPool::Work> work;
+        if (Threading::Dedicated == threaded)
+        {
+            work.emplace(app->start_network_thread());
+        }
+        auto& network_context = work ? work->get_executor().context() : app->get_network_context();
+        auto const irc = connection::create(network_context, high_water);
+        irc->set_pacing(pacing.burst, pacing.rate);
+        auto const session = std::make_shared<RemoteSession>(
+            io_context, network_context, LMain, luaL_ref(L, LUA_REGISTRYINDEX), delivery, 0);
+        session_metrics().sessions.add(1);
+        boost::asio::co_spawn(
+            network_context, remote_session_thread(session, irc, std::move(settings), std::move(record)),
+            [session, work = std::move(work)](std::exception_ptr const e) {
+                SessionEvent end{.session = session, .kind = SessionEvent::Kind::End};
+                try
+                {
+                    std::rethrow_exception(e);
+                }
+                catch (std::exception const& ex)
+                {
+                    end.message = ex.what();
+                }
+                catch (...)
+                {
+                }
+                inbox().push(std::move(end));
+            }
+        );
+        pushirc(L, irc);
+        return 1;
+    }
+
+    auto const irc = connection::create(io_context, high_water);
+    irc->set_pacing(pacing.burst, pacing.rate);
     auto const irc_cb = luaL_ref(L, LUA_REGISTRYINDEX);
+    session_metrics().sessions.add(1);
     boost::asio::co_spawn(
-        io_context, session_thread(io_context, LMain, irc_cb, irc, std::move(settings)),
+        io_context, session_thread(io_context, LMain, irc_cb, irc, std::move(settings), delivery, std::move(record)),
         [L = LMain, irc_cb](std::exception_ptr const e) {
+            session_metrics().sessions.add(-1);
             lua_rawgeti(L, LUA_REGISTRYINDEX, irc_cb);
             luaL_unref(L, LUA_REGISTRYINDEX, irc_cb);
             push_string(L, "END"sv);
@@ -285,16 +1151,7 @@ auto pushircmsg(lua_State* const L, ircmsg const& msg) -> void
         lua_setfield(L, -2, "source");
     }
 
-    lua_Integer code;
-    auto const [last, ec] = std::from_chars(msg.command.begin(), msg.command.end(), code);
-    if (ec == std::errc{} && last == msg.command.end())
-    {
-        lua_pushinteger(L, code);
-    }
-    else
-    {
-        push_string(L, msg.command);
-    }
+    pushcommand(L, msg.command);
     lua_setfield(L, -2, "command");
 
     int argix = 1;
@@ -305,7 +1162,21 @@ auto pushircmsg(lua_State* const L, ircmsg const& msg) -> void
     }
 }
 
-auto pushtags(lua_State* const L, std::vector<irctag> const& tags) -> void
+auto pushcommand(lua_State* const L, std::string_view const command) -> void
+{
+    lua_Integer code;
+    auto const [last, ec] = std::from_chars(command.begin(), command.end(), code);
+    if (ec == std::errc{} && last == command.end())
+    {
+        lua_pushinteger(L, code);
+    }
+    else
+    {
+        push_string(L, command);
+    }
+}
+
+auto pushtags(lua_State* const L, std::span<irctag const> const tags) -> void
 {
     lua_createtable(L, 0, tags.size());
     for (auto&& tag : tags)
@@ -6,7 +6,8 @@
  *
  */
 
-#include <vector>
+#include <span>
+#include <string_view>
 
 struct lua_State;
 struct irctag;
@@ -17,5 +18,10 @@ struct ircmsg;
  */
 auto l_start_irc(lua_State* L) -> int;
 
-auto pushtags(lua_State* L, std::vector<irctag> const& tags) -> void;
+auto pushtags(lua_State* L, std::span<irctag const> tags) -> void;
 auto pushircmsg(lua_State* const L, ircmsg const& msg) -> void;
+
+/**
+ * @brief Push an IRC command as an integer for numerics or a string otherwise
+ */
+auto pushcommand(lua_State* L, std::string_view command) -> void;
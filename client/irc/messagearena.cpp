@@ -0,0 +1,68 @@
+#include "messagearena.hpp"
+
+auto MessageArena::to_span(std::string_view const field) const -> span
+{
+    return nullptr == field.data()
+        ? span{null_offset, 0}
+        : span{static_cast<std::uint32_t>(field.data() - text_.data()), static_cast<std::uint32_t>(field.size())};
+}
+
+auto MessageArena::view(span const s) const -> std::string_view
+{
+    return null_offset == s.offset ? std::string_view{} : std::string_view{text_.data() + s.offset, s.length};
+}
+
+auto MessageArena::append(std::string_view const line) -> void
+{
+    auto const offset = text_.size();
+    text_.insert(text_.end(), line.begin(), line.end());
+    text_.push_back('\0');
+
+    ircmsg msg;
+    try
+    {
+        msg = parse_irc_message(text_.data() + offset);
+    }
+    catch (...)
+    {
+        text_.resize(offset);
+        throw;
+    }
+
+    entries_.push_back({
+        .line = static_cast<std::uint32_t>(offset),
+        .first_span = static_cast<std::uint32_t>(spans_.size()),
+        .ntags = static_cast<std::uint32_t>(msg.tags.size()),
+        .nargs = static_cast<std::uint32_t>(msg.args.size()),
+        .source = to_span(msg.source),
+        .command = to_span(msg.command),
+    });
+    for (auto&& tag : msg.tags)
+    {
+        spans_.push_back(to_span(tag.key));
+        spans_.push_back(to_span(tag.val));
+    }
+    for (auto&& arg : msg.args)
+    {
+        spans_.push_back(to_span(arg));
+    }
+}
+
+auto MessageArena::message(std::size_t const i) const -> ircmsg
+{
+    auto const& entry = entries_[i];
+    auto cursor = spans_.data() + entry.first_span;
+
+    ircmsg msg;
+    msg.source = view(entry.source);
+    msg.command = view(entry.command);
+    for (std::uint32_t j = 0; j < entry.ntags; j++, cursor += 2)
+    {
+        msg.tags.push_back({view(cursor[0]), view(cursor[1])});
+    }
+    for (std::uint32_t j = 0; j < entry.nargs; j++)
+    {
+        msg.args.push_back(view(*cursor++));
+    }
+    return msg;
+}
@@ -0,0 +1,105 @@
+#pragma once
+/**
+ * @file messagearena.hpp
+ * @author Eric Mertens <emertens@gmail.com>
+ * @brief Compact storage for a batch of parsed IRC messages
+ *
+ */
+
+#include <ircmsg.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Batch of IRC messages parsed into one shared text buffer
+ *
+ * Each line is copied into the arena and parsed in place. Messages are
+ * kept as offsets of their fields into the text rather than as ircmsg
+ * values with inline tag and argument storage, so a message costs a few
+ * dozen bytes beyond its text. Moving an arena never invalidates it and
+ * clearing one keeps its capacity for the next batch.
+ */
+class MessageArena
+{
+    /// @brief Location of a field within the text
+    struct span
+    {
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+    /// @brief Offset marking a field the parser left null
+    static std::uint32_t const null_offset = UINT32_MAX;
+
+    struct Entry
+    {
+        /// Offset of the line in the text
+        std::uint32_t line;
+        /// Index of the message's first span: tag keys and values, then arguments
+        std::uint32_t first_span;
+        std::uint32_t ntags;
+        std::uint32_t nargs;
+        span source;
+        span command;
+    };
+
+    std::vector<char> text_;
+    std::vector<Entry> entries_;
+    std::vector<span> spans_;
+
+    auto to_span(std::string_view field) const -> span;
+    auto view(span s) const -> std::string_view;
+
+public:
+    /**
+     * @brief Copy a line into the arena and parse it
+     *
+     * The arena is unchanged when the line is malformed.
+     *
+     * @param line IRC message without its line terminator
+     * @throw irc_parse_error when the line is malformed
+     */
+    auto append(std::string_view line) -> void;
+
+    /**
+     * @brief Rebuild a stored message
+     *
+     * @param i Index of the message
+     * @return Message with fields pointing into the arena
+     */
+    auto message(std::size_t i) const -> ircmsg;
+
+    /// @brief Start of the text a stored message was parsed from
+    auto line(std::size_t const i) const -> char const*
+    {
+        return text_.data() + entries_[i].line;
+    }
+
+    /// @brief Number of stored messages
+    auto size() const -> std::size_t
+    {
+        return entries_.size();
+    }
+
+    auto empty() const -> bool
+    {
+        return entries_.empty();
+    }
+
+    /// @brief Bytes of stored text
+    auto bytes() const -> std::size_t
+    {
+        return text_.size();
+    }
+
+    /// @brief Remove every message while keeping the allocated capacity
+    auto clear() -> void
+    {
+        text_.clear();
+        entries_.clear();
+        spans_.clear();
+    }
+};
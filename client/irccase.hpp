@@ -0,0 +1,20 @@
+#pragma once
+/**
+ * @file irccase.hpp
+ * @brief RFC 1459 case mapping
+ * @author Eric Mertens (emertens@gmail.com)
+ */
+
+#include <string_view>
+
+struct lua_State;
+
+/// @brief Map text to its RFC 1459 uppercase form
+/// @param input Text to normalize
+/// @param output Destination with room for input.size() characters
+auto irccase(std::string_view input, char* output) -> void;
+
+/// @brief Lua binding for irccase
+/// @param L Lua state
+/// @return 1
+auto l_irccase(lua_State* L) -> int;
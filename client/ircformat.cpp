@@ -0,0 +1,164 @@
+#include "ircformat.hpp"
+
+#include <algorithm>
+
+namespace {
+
+auto is_digit(char const c) -> bool
+{
+    return '0' <= c && c <= '9';
+}
+
+/**
+ * @brief Consume a one or two digit color number
+ *
+ * @param str Remaining input, advanced past the digits
+ * @return Color number or -1 when no digit was present
+ */
+auto take_color(std::string_view& str) -> int
+{
+    if (str.empty() || not is_digit(str[0]))
+    {
+        return -1;
+    }
+    int color = str[0] - '0';
+    std::size_t used = 1;
+    if (1 < str.size() && is_digit(str[1]))
+    {
+        color = 10 * color + str[1] - '0';
+        used = 2;
+    }
+    str.remove_prefix(used);
+    return color;
+}
+
+/// @brief Append the UTF-8 encoding of the control picture for c
+auto append_picture(std::string& out, unsigned char const c) -> void
+{
+    // Newline uses the dedicated newline symbol rather than line feed's picture
+    char32_t const picture = c == '\x7f' ? U'␡' : c == '\n' ? U'␤' : U'␀' + c;
+    out += static_cast<char>(0xe0 | picture >> 12);
+    out += static_cast<char>(0x80 | (picture >> 6 & 0x3f));
+    out += static_cast<char>(0x80 | (picture & 0x3f));
+}
+
+} // namespace
+
+auto parse_irc_formatting(std::string_view str) -> IrcFormatted
+{
+    IrcFormatted result;
+    result.text.reserve(str.size());
+
+    IrcFormatSpan format{0, 0, -1, -1};
+
+    // Extends the last run when the format hasn't changed since
+    auto const emit = [&result, &format](std::size_t const before) {
+        auto const length = result.text.size() - before;
+        if (0 == length)
+        {
+            return;
+        }
+        auto& spans = result.spans;
+        if (not spans.empty()
+            && spans.back().attrs == format.attrs
+            && spans.back().fore == format.fore
+            && spans.back().back == format.back)
+        {
+            spans.back().length += length;
+        }
+        else
+        {
+            spans.push_back(format);
+            spans.back().length = length;
+        }
+    };
+
+    while (not str.empty())
+    {
+        // Copy the plain text up to the next control character
+        std::size_t n = 0;
+        while (n < str.size() && 0x20 <= static_cast<unsigned char>(str[n]) && '\x7f' != str[n])
+        {
+            n++;
+        }
+        if (0 < n)
+        {
+            auto const before = result.text.size();
+            result.text.append(str.substr(0, n));
+            emit(before);
+            str.remove_prefix(n);
+            if (str.empty())
+            {
+                break;
+            }
+        }
+
+        auto const ctrl = str[0];
+        str.remove_prefix(1);
+        switch (ctrl)
+        {
+        case '\x02':
+            format.attrs ^= irc_bold;
+            break;
+        case '\x1d':
+            format.attrs ^= irc_italic;
+            break;
+        case '\x1f':
+            format.attrs ^= irc_underline;
+            break;
+        case '\x16':
+            format.attrs ^= irc_reverse;
+            break;
+        case '\x0f':
+            format = {0, 0, -1, -1};
+            break;
+        case '\x03': {
+            // ^C alone resets both colors and ^Cf keeps the background
+            auto const fore = take_color(str);
+            format.fore = fore;
+            if (fore < 0)
+            {
+                format.back = -1;
+            }
+            else if (2 <= str.size() && ',' == str[0] && is_digit(str[1]))
+            {
+                str.remove_prefix(1);
+                format.back = take_color(str);
+            }
+            break;
+        }
+        default: {
+            auto const before = result.text.size();
+            append_picture(result.text, ctrl);
+            emit(before);
+            break;
+        }
+        }
+    }
+
+    return result;
+}
+
+IrcFormatCache::IrcFormatCache(std::size_t const capacity)
+    : capacity_{std::max<std::size_t>(1, capacity)}
+{
+}
+
+auto IrcFormatCache::get(std::string_view const str) -> IrcFormatted const&
+{
+    if (auto const it = index_.find(str); it != index_.end())
+    {
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->value;
+    }
+
+    if (entries_.size() >= capacity_)
+    {
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+
+    auto& entry = entries_.emplace_front(std::string{str}, parse_irc_formatting(str));
+    index_.emplace(entry.key, entries_.begin());
+    return entry.value;
+}
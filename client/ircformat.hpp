@@ -0,0 +1,115 @@
+#pragma once
+/**
+ * @file ircformat.hpp
+ * @author Eric Mertens (emertens@gmail.com)
+ * @brief Interpretation of mIRC formatting codes
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// @brief Text attributes toggled by formatting codes
+enum IrcAttr : std::uint8_t
+{
+    irc_bold = 1,
+    irc_italic = 2,
+    irc_underline = 4,
+    irc_reverse = 8,
+};
+
+/**
+ * @brief Run of text sharing one format
+ */
+struct IrcFormatSpan
+{
+    /// @brief Length of the run in bytes of IrcFormatted::text
+    std::size_t length;
+
+    /// @brief IrcAttr bits
+    std::uint8_t attrs;
+
+    /// @brief IRC color numbers from 0 to 99, or -1 for the default
+    std::int8_t fore, back;
+};
+
+/**
+ * @brief Message text with its formatting codes interpreted
+ */
+struct IrcFormatted
+{
+    /// @brief Text with formatting codes removed
+    std::string text;
+
+    /// @brief Consecutive runs covering all of text
+    std::vector<IrcFormatSpan> spans;
+};
+
+/**
+ * @brief Interpret the formatting codes in a message in one pass
+ *
+ * Bold (^B), color (^C), italic (^]), underline (^_), reverse (^V), and
+ * reset (^O) codes are removed. Other control characters are replaced
+ * with their Unicode control pictures so they remain visible.
+ * Adjacent runs with the same format are merged.
+ *
+ * @param str Raw message text
+ * @return Stripped text and its runs
+ */
+auto parse_irc_formatting(std::string_view str) -> IrcFormatted;
+
+/**
+ * @brief Least-recently-used cache of interpreted message text
+ *
+ * Views redraw the same lines every frame, so repeated lookups of a
+ * string skip parsing altogether.
+ */
+class IrcFormatCache
+{
+    struct Entry
+    {
+        std::string key;
+        IrcFormatted value;
+    };
+
+    struct Hash
+    {
+        using is_transparent = void;
+        auto operator()(std::string_view const str) const -> std::size_t
+        {
+            return std::hash<std::string_view>{}(str);
+        }
+    };
+
+    std::size_t capacity_;
+
+    /// @brief Entries with the most recently used first
+    std::list<Entry> entries_;
+
+    /// @brief Index from keys stored in entries_ to their entry
+    std::unordered_map<std::string_view, std::list<Entry>::iterator, Hash, std::equal_to<>> index_;
+
+public:
+    /**
+     * @param capacity Maximum number of strings retained, at least one
+     */
+    explicit IrcFormatCache(std::size_t capacity);
+
+    /**
+     * @brief Find or parse the formatting of a string
+     *
+     * @param str Raw message text
+     * @return Interpreted text valid until the next call
+     */
+    auto get(std::string_view str) -> IrcFormatted const&;
+
+    auto size() const -> std::size_t
+    {
+        return entries_.size();
+    }
+};
@@ -0,0 +1,100 @@
+#include "loadaverage.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/// @brief Decay factors for windows of 1 to 15 minutes of one-second samples
+auto const decays = [] {
+    std::array<double, 16> result{};
+    for (std::size_t i = 1; i < result.size(); i++)
+    {
+        result[i] = std::exp(-1.0 / (60.0 * i));
+    }
+    return result;
+}();
+
+constexpr std::array<std::string_view, 9> ticks{" ", "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+
+} // namespace
+
+LoadAverage::LoadAverage()
+    : averages_{}
+    , recent_{}
+    , n_{0}
+{
+}
+
+auto LoadAverage::sample(std::uint64_t const events) -> void
+{
+    // Minutes of samples so far, counting the partial one
+    auto const mins = std::max<std::uint64_t>(1, (n_ + 59) / 60);
+    std::array<double, 3> const windows{
+        decays[1],
+        decays[std::min<std::uint64_t>(5, mins)],
+        decays[std::min<std::uint64_t>(15, mins)],
+    };
+
+    auto const x = static_cast<double>(events);
+    for (std::size_t i = 0; i < windows.size(); i++)
+    {
+        averages_[i] = averages_[i] * windows[i] + x * (1 - windows[i]);
+    }
+
+    recent_[n_ % history] = static_cast<std::uint8_t>(std::min<std::uint64_t>(ticks.size() - 1, events));
+    n_++;
+}
+
+auto LoadAverage::average(int const minutes) const -> double
+{
+    switch (minutes)
+    {
+    case 1:
+        return averages_[0];
+    case 5:
+        return averages_[1];
+    case 15:
+        return averages_[2];
+    default:
+        return 0;
+    }
+}
+
+auto LoadAverage::graph() const -> std::string
+{
+    std::string result;
+    result.reserve(3 * history);
+    for (std::size_t i = 0; i < history; i++)
+    {
+        result += ticks[recent_[(n_ + history - 1 - i) % history]];
+    }
+    return result;
+}
+
+auto LoadTracker::intern(std::string_view const name) -> std::size_t
+{
+    if (auto const it = index_.find(name); it != index_.end())
+    {
+        return it->second;
+    }
+
+    auto const slot = names_.size();
+    names_.emplace_back(name);
+    details_.emplace_back();
+    events_.push_back(0);
+    index_.emplace(names_.back(), slot);
+    return slot;
+}
+
+auto LoadTracker::tick() -> void
+{
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < details_.size(); i++)
+    {
+        details_[i].sample(events_[i]);
+        total += events_[i];
+    }
+    std::fill(events_.begin(), events_.end(), 0);
+    global_.sample(total);
+}
@@ -0,0 +1,109 @@
+#pragma once
+/**
+ * @file loadaverage.hpp
+ * @author Eric Mertens (emertens@gmail.com)
+ * @brief Per-second event rates with load-style moving averages
+ *
+ */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 1, 5, and 15 minute moving averages of a per-second count
+ *
+ * Until a full window of samples is available the longer averages use
+ * the window covered so far so they track the shorter ones at startup.
+ */
+class LoadAverage
+{
+public:
+    /// @brief Number of samples kept for the sparkline
+    static constexpr std::size_t history = 60;
+
+private:
+    std::array<double, 3> averages_;
+
+    /// @brief Recent samples clamped to the sparkline height, indexed by n % history
+    std::array<std::uint8_t, history> recent_;
+
+    std::uint64_t n_;
+
+public:
+    LoadAverage();
+
+    /// @brief Record the number of events seen in the last second
+    auto sample(std::uint64_t events) -> void;
+
+    /**
+     * @brief Get a moving average
+     *
+     * @param minutes 1, 5, or 15
+     * @return Average events per second, 0 for other window sizes
+     */
+    auto average(int minutes) const -> double;
+
+    /// @brief Number of samples recorded
+    auto n() const -> std::uint64_t { return n_; }
+
+    /**
+     * @brief Render recent samples as a sparkline, newest first
+     *
+     * @return history block characters encoded in UTF-8
+     */
+    auto graph() const -> std::string;
+};
+
+/**
+ * @brief Event rates for a growing set of names and their total
+ *
+ * Names are interned to slot indexes once. Tracking an event on a slot
+ * is an increment of a pending count that is folded into the averages
+ * on each tick.
+ */
+class LoadTracker
+{
+    struct Hash
+    {
+        using is_transparent = void;
+        auto operator()(std::string_view const str) const -> std::size_t
+        {
+            return std::hash<std::string_view>{}(str);
+        }
+    };
+
+    std::unordered_map<std::string, std::size_t, Hash, std::equal_to<>> index_;
+    std::vector<std::string> names_;
+    std::vector<LoadAverage> details_;
+
+    /// @brief Events tracked on each slot since the last tick
+    std::vector<std::uint64_t> events_;
+
+    LoadAverage global_;
+
+public:
+    /**
+     * @brief Find or allocate the slot of a name
+     *
+     * @return Slot index valid for the lifetime of the tracker
+     */
+    auto intern(std::string_view name) -> std::size_t;
+
+    auto track(std::size_t const slot, std::uint64_t const n = 1) -> void
+    {
+        events_[slot] += n;
+    }
+
+    /// @brief Sample every slot and the total, then clear the pending counts
+    auto tick() -> void;
+
+    auto size() const -> std::size_t { return names_.size(); }
+    auto name(std::size_t const slot) const -> std::string const& { return names_[slot]; }
+    auto detail(std::size_t const slot) const -> LoadAverage const& { return details_[slot]; }
+    auto global() const -> LoadAverage const& { return global_; }
+};
@@ -0,0 +1,218 @@
+#include "loadtracker.hpp"
+
+#include "loadaverage.hpp"
+#include "strings.hpp"
+#include "userdata.hpp"
+
+extern "C" {
+#include <lauxlib.h>
+#include <lua.h>
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+namespace {
+
+/// @brief Read-only view of one of a tracker's averages
+///
+/// The tracker is kept alive by the view's uservalue.
+struct LoadView
+{
+    LoadTracker const* tracker;
+    std::size_t slot;
+
+    auto average() const -> LoadAverage const&
+    {
+        return global_slot == slot ? tracker->global() : tracker->detail(slot);
+    }
+
+    static constexpr auto global_slot = std::numeric_limits<std::size_t>::max();
+};
+
+/// Tracker uservalue holding the table from names to views
+constexpr int detail_uv = 1;
+/// Tracker uservalue holding the view of the totals
+constexpr int global_uv = 2;
+/// View uservalue holding its tracker
+constexpr int tracker_uv = 1;
+
+} // namespace
+
+template <>
+char const* udata_name<LoadTracker> = "load_tracker";
+
+template <>
+char const* udata_name<LoadView> = "load_average";
+
+namespace {
+
+auto check_tracker(lua_State* const L) -> LoadTracker*
+{
+    return check_udata<LoadTracker>(L, 1);
+}
+
+auto l_graph(lua_State* const L) -> int
+{
+    push_string(L, check_udata<LoadView>(L, 1)->average().graph());
+    return 1;
+}
+
+auto l_view_index(lua_State* const L) -> int
+{
+    auto const& avg = check_udata<LoadView>(L, 1)->average();
+
+    if (lua_isinteger(L, 2))
+    {
+        auto const minutes = lua_tointeger(L, 2);
+        if (1 == minutes || 5 == minutes || 15 == minutes)
+        {
+            lua_pushnumber(L, avg.average(static_cast<int>(minutes)));
+            return 1;
+        }
+    }
+    else if (LUA_TSTRING == lua_type(L, 2))
+    {
+        auto const key = check_string_view(L, 2);
+        if (key == "n")
+        {
+            lua_pushinteger(L, static_cast<lua_Integer>(avg.n()));
+            return 1;
+        }
+        if (key == "graph")
+        {
+            lua_pushcfunction(L, l_graph);
+            return 1;
+        }
+    }
+
+    lua_pushnil(L);
+    return 1;
+}
+
+luaL_Reg const ViewMT[]{
+    {"__index", l_view_index},
+    {}
+};
+
+/// @brief Push a view of a slot of the tracker at index idx
+auto push_view(lua_State* const L, int idx, LoadTracker const* const tracker, std::size_t const slot) -> void
+{
+    idx = lua_absindex(L, idx);
+    auto const view = new_udata<LoadView>(L, 1, [L] {
+        luaL_setfuncs(L, ViewMT, 0);
+    });
+    std::construct_at(view, tracker, slot);
+    lua_pushvalue(L, idx);
+    lua_setiuservalue(L, -2, tracker_uv);
+}
+
+auto l_track(lua_State* const L) -> int
+{
+    auto const tracker = check_tracker(L);
+    auto const name = check_string_view(L, 2);
+    auto const n = luaL_optinteger(L, 3, 1);
+    luaL_argcheck(L, 0 <= n, 3, "negative event count");
+    lua_settop(L, 2);
+
+    // The detail table doubles as the index from interned Lua strings to slots
+    lua_getiuservalue(L, 1, detail_uv);
+    lua_pushvalue(L, 2);
+    std::size_t slot;
+    if (LUA_TNIL != lua_rawget(L, 3))
+    {
+        auto const view = static_cast<LoadView*>(luaL_testudata(L, -1, udata_name<LoadView>));
+        if (nullptr == view || view->tracker != tracker)
+        {
+            return luaL_error(L, "load tracker detail table was modified");
+        }
+        slot = view->slot;
+    }
+    else
+    {
+        slot = tracker->intern(name);
+        lua_pushvalue(L, 2);
+        push_view(L, 1, tracker, slot);
+        lua_rawset(L, 3);
+    }
+
+    tracker->track(slot, static_cast<std::uint64_t>(n));
+    return 0;
+}
+
+auto l_tick(lua_State* const L) -> int
+{
+    check_tracker(L)->tick();
+    return 0;
+}
+
+luaL_Reg const Methods[]{
+    {"track", l_track},
+    {"tick", l_tick},
+    {}
+};
+
+/// upvalue 1: methods table
+auto l_index(lua_State* const L) -> int
+{
+    check_tracker(L);
+    lua_settop(L, 2);
+
+    if (LUA_TNIL != lua_rawget(L, lua_upvalueindex(1)))
+    {
+        return 1;
+    }
+
+    if (LUA_TSTRING == lua_type(L, 2))
+    {
+        auto const key = check_string_view(L, 2);
+        if (key == "detail")
+        {
+            lua_getiuservalue(L, 1, detail_uv);
+            return 1;
+        }
+        if (key == "global")
+        {
+            lua_getiuservalue(L, 1, global_uv);
+            return 1;
+        }
+    }
+
+    lua_pushnil(L);
+    return 1;
+}
+
+auto l_gc(lua_State* const L) -> int
+{
+    std::destroy_at(check_tracker(L));
+    return 0;
+}
+
+luaL_Reg const MT[]{
+    {"__gc", l_gc},
+    {}
+};
+
+} // namespace
+
+auto l_new_load_tracker(lua_State* const L) -> int
+{
+    auto const tracker = new_udata<LoadTracker>(L, 2, [L] {
+        luaL_setfuncs(L, MT, 0);
+        luaL_newlibtable(L, Methods);
+        luaL_setfuncs(L, Methods, 0);
+        lua_pushcclosure(L, l_index, 1);
+        lua_setfield(L, -2, "__index");
+    });
+    std::construct_at(tracker);
+
+    lua_newtable(L);
+    lua_setiuservalue(L, -2, detail_uv);
+
+    push_view(L, -1, tracker, LoadView::global_slot);
+    lua_setiuservalue(L, -2, global_uv);
+
+    return 1;
+}
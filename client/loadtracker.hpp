@@ -0,0 +1,30 @@
+#pragma once
+/**
+ * @file loadtracker.hpp
+ * @author Eric Mertens (emertens@gmail.com)
+ * @brief Lua bindings for per-name event rate tracking
+ *
+ */
+
+struct lua_State;
+
+/**
+ * @brief Construct a new load tracker
+ *
+ * Names are interned into preallocated slots the first time they are
+ * tracked, after which tracking an event is a single counter increment.
+ * The averages behave like read-only LoadAverage objects: avg[1],
+ * avg[5], and avg[15] are the moving averages, avg.n counts samples,
+ * and avg:graph() renders the recent samples as a sparkline.
+ *
+ * Lua object methods:
+ * * track(name, [n]) - record n events, default 1
+ * * tick() - sample one second of events
+ *
+ * Lua object fields: detail (table from names to averages), global
+ * (average of the totals)
+ *
+ * @param L Lua state
+ * @return 1
+ */
+auto l_new_load_tracker(lua_State* L) -> int;
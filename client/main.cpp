@@ -59,14 +59,18 @@ auto main(int argc, char const* argv[]) -> int
 {
     if (argc < 2)
     {
-        std::cerr << "Usage: snowcone MODE [--config=PATH]\n"
+        std::cerr << "Usage: snowcone MODE [--config=PATH] [--capture=PATH] [--replay=PATH [--replay-speed=N]]\n"
                      "  Modes:\n"
                      "    ircc               - chat client\n"
                      "    dashboard          - server notice dashboard\n"
                      "    path/to/init.lua   - arbitrary Lua script\n"
                      " \n"
                      "  --config=PATH        - override configuration file\n"
-                     "                         (default ~/.config/snowcone/settings.lua)\n";
+                     "                         (default ~/.config/snowcone/settings.lua)\n"
+                     "  --capture=PATH       - record received IRC lines (dashboard)\n"
+                     "  --replay=PATH        - read a capture in place of the server (dashboard)\n"
+                     "  --replay-speed=N     - replay at N times the recorded speed\n"
+                     "                         (default 0: as fast as possible)\n";
         return EXIT_FAILURE;
     }
 
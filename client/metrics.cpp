@@ -0,0 +1,220 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+
+namespace metrics {
+
+namespace {
+
+/// @brief Registered metric and its description
+struct Entry
+{
+    std::string help;
+    std::variant<std::unique_ptr<Counter>, std::unique_ptr<Gauge>, std::unique_ptr<Histogram>> metric;
+};
+
+/// @brief Process-wide metric registry
+struct Registry
+{
+    std::mutex mutex;
+    std::map<std::string, Entry, std::less<>> entries;
+};
+
+auto registry() -> Registry&
+{
+    static Registry instance;
+    return instance;
+}
+
+template <typename T>
+auto lookup(std::string_view const name, std::string_view const help) -> T&
+{
+    auto& reg = registry();
+    std::lock_guard const lock{reg.mutex};
+
+    auto it = reg.entries.find(name);
+    if (it == reg.entries.end())
+    {
+        it = reg.entries.emplace(std::string{name}, Entry{std::string{help}, std::make_unique<T>()}).first;
+    }
+
+    if (auto const metric = std::get_if<std::unique_ptr<T>>(&it->second.metric))
+    {
+        return **metric;
+    }
+    throw std::logic_error{"metric registered with a different type: " + std::string{name}};
+}
+
+/// @brief Format nanoseconds as seconds for exposition
+auto seconds(std::uint64_t const ns) -> double
+{
+    return static_cast<double>(ns) / 1e9;
+}
+
+/// Smallest and largest exponents of the power-of-two bucket bounds: ~1us and ~17s
+constexpr int min_bound_exponent = 10;
+constexpr int max_bound_exponent = 34;
+
+/// Significant digits needed to print every bucket bound exactly
+constexpr int bound_precision = 11;
+
+} // namespace
+
+auto Histogram::bucket_of(std::uint64_t const value) -> std::size_t
+{
+    if (value < sub_buckets)
+    {
+        return value;
+    }
+    auto const exponent = std::bit_width(value) - 1; // at least 3
+    auto const sub = (value >> (exponent - 3)) & (sub_buckets - 1);
+    return (exponent - 2) * sub_buckets + sub;
+}
+
+auto Histogram::bucket_min(std::size_t const bucket) -> std::uint64_t
+{
+    if (bucket < sub_buckets)
+    {
+        return bucket;
+    }
+    auto const exponent = bucket / sub_buckets + 2;
+    auto const sub = bucket % sub_buckets;
+    return (sub_buckets + sub) << (exponent - 3);
+}
+
+auto Histogram::record(std::uint64_t const nanoseconds) -> void
+{
+    buckets_[bucket_of(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    auto current = max_.load(std::memory_order_relaxed);
+    while (current < nanoseconds && not max_.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+auto Histogram::count_below(std::uint64_t const bound) const -> std::uint64_t
+{
+    std::uint64_t total = 0;
+    auto const last = bucket_of(bound);
+    for (std::size_t i = 0; i < last; i++)
+    {
+        total += buckets_[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+auto Histogram::quantile(double const q) const -> std::uint64_t
+{
+    auto const n = count();
+    if (0 == n)
+    {
+        return 0;
+    }
+
+    auto const rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * n)));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucket_count; i++)
+    {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+        {
+            auto const upper = i + 1 < bucket_count ? bucket_min(i + 1) - 1 : UINT64_MAX;
+            return std::min(upper, max());
+        }
+    }
+    return max();
+}
+
+auto counter(std::string_view const name, std::string_view const help) -> Counter&
+{
+    return lookup<Counter>(name, help);
+}
+
+auto gauge(std::string_view const name, std::string_view const help) -> Gauge&
+{
+    return lookup<Gauge>(name, help);
+}
+
+auto histogram(std::string_view const name, std::string_view const help) -> Histogram&
+{
+    return lookup<Histogram>(name, help);
+}
+
+auto visit(Visitor const& visitor) -> void
+{
+    auto& reg = registry();
+    std::lock_guard const lock{reg.mutex};
+
+    for (auto&& [name, entry] : reg.entries)
+    {
+        std::visit([&visitor, &name](auto const& metric) {
+            using T = std::decay_t<decltype(*metric)>;
+            if constexpr (std::is_same_v<T, Counter>)
+            {
+                if (visitor.on_counter) visitor.on_counter(name, *metric);
+            }
+            else if constexpr (std::is_same_v<T, Gauge>)
+            {
+                if (visitor.on_gauge) visitor.on_gauge(name, *metric);
+            }
+            else
+            {
+                if (visitor.on_histogram) visitor.on_histogram(name, *metric);
+            }
+        }, entry.metric);
+    }
+}
+
+auto render_prometheus() -> std::string
+{
+    auto& reg = registry();
+    std::lock_guard const lock{reg.mutex};
+
+    std::ostringstream os;
+    os << std::setprecision(bound_precision);
+    for (auto&& [name, entry] : reg.entries)
+    {
+        os << "# HELP " << name << ' ' << entry.help << '\n';
+
+        if (auto const c = std::get_if<std::unique_ptr<Counter>>(&entry.metric))
+        {
+            os << "# TYPE " << name << " counter\n"
+               << name << ' ' << (*c)->value() << '\n';
+        }
+        else if (auto const g = std::get_if<std::unique_ptr<Gauge>>(&entry.metric))
+        {
+            os << "# TYPE " << name << " gauge\n"
+               << name << ' ' << (*g)->value() << '\n';
+        }
+        else if (auto const h = std::get_if<std::unique_ptr<Histogram>>(&entry.metric))
+        {
+            auto const& hist = **h;
+            auto const count = hist.count();
+            os << "# TYPE " << name << " histogram\n";
+            for (auto e = min_bound_exponent; e <= max_bound_exponent; e++)
+            {
+                // le is inclusive, so each bound is the largest value below a power of two
+                auto const limit = std::uint64_t{1} << e;
+                os << name << "_bucket{le=\"" << seconds(limit - 1) << "\"} " << hist.count_below(limit) << '\n';
+            }
+            os << name << "_bucket{le=\"+Inf\"} " << count << '\n'
+               << name << "_sum " << seconds(hist.sum()) << '\n'
+               << name << "_count " << count << '\n';
+        }
+    }
+    return std::move(os).str();
+}
+
+} // namespace metrics
@@ -0,0 +1,173 @@
+#pragma once
+/**
+ * @file metrics.hpp
+ * @author Eric Mertens (emertens@gmail.com)
+ * @brief In-process counters, gauges, and latency histograms
+ *
+ * Metrics are registered by name on first use and live for the rest of
+ * the process. Call sites keep a reference to the metric they update:
+ *
+ *     static auto& lines = metrics::counter("irc_lines_parsed_total", "Lines parsed");
+ *     lines.add();
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace metrics {
+
+/**
+ * @brief Monotonically increasing count
+ */
+class Counter
+{
+    std::atomic<std::uint64_t> value_{0};
+
+public:
+    auto add(std::uint64_t const n = 1) -> void
+    {
+        value_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    auto value() const -> std::uint64_t
+    {
+        return value_.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Value that can go up and down
+ */
+class Gauge
+{
+    std::atomic<std::int64_t> value_{0};
+
+public:
+    auto set(std::int64_t const n) -> void
+    {
+        value_.store(n, std::memory_order_relaxed);
+    }
+
+    auto add(std::int64_t const n) -> void
+    {
+        value_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    auto value() const -> std::int64_t
+    {
+        return value_.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Log-linear histogram of durations in nanoseconds
+ *
+ * Each power-of-two range is split into 8 linear sub-buckets so that
+ * recorded values keep 3 significant bits, in the style of HDR
+ * histograms. Recording is a constant-time increment.
+ */
+class Histogram
+{
+public:
+    /// Number of linear sub-buckets in each power-of-two range
+    static constexpr std::size_t sub_buckets = 8;
+    /// Number of buckets needed to cover every 64-bit value
+    static constexpr std::size_t bucket_count = (64 - 2) * sub_buckets;
+
+    /// @brief Bucket holding a value
+    static auto bucket_of(std::uint64_t value) -> std::size_t;
+
+    /// @brief Smallest value held by a bucket
+    static auto bucket_min(std::size_t bucket) -> std::uint64_t;
+
+private:
+    std::array<std::atomic<std::uint64_t>, bucket_count> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> sum_{0};
+    std::atomic<std::uint64_t> max_{0};
+
+public:
+    auto record(std::uint64_t nanoseconds) -> void;
+
+    auto record(std::chrono::nanoseconds const duration) -> void
+    {
+        record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, duration.count())));
+    }
+
+    auto count() const -> std::uint64_t { return count_.load(std::memory_order_relaxed); }
+    auto sum() const -> std::uint64_t { return sum_.load(std::memory_order_relaxed); }
+    auto max() const -> std::uint64_t { return max_.load(std::memory_order_relaxed); }
+
+    /// @brief Number of recorded values less than a bound
+    ///
+    /// Exact when the bound is a bucket boundary, such as a power of two.
+    auto count_below(std::uint64_t bound) const -> std::uint64_t;
+
+    /// @brief Estimate a quantile from the bucket counts
+    /// @param q Quantile between 0 and 1
+    /// @return Upper bound of the bucket containing the quantile, 0 when empty
+    auto quantile(double q) const -> std::uint64_t;
+};
+
+/**
+ * @brief Histogram measuring the lifetime of a scope
+ */
+class ScopedTimer
+{
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram_{histogram}
+        , start_{std::chrono::steady_clock::now()}
+    {
+    }
+
+    ScopedTimer(ScopedTimer const&) = delete;
+    auto operator=(ScopedTimer const&) -> ScopedTimer& = delete;
+
+    ~ScopedTimer()
+    {
+        histogram_.record(std::chrono::steady_clock::now() - start_);
+    }
+};
+
+/// @brief Get or register the counter with the given name
+auto counter(std::string_view name, std::string_view help) -> Counter&;
+
+/// @brief Get or register the gauge with the given name
+auto gauge(std::string_view name, std::string_view help) -> Gauge&;
+
+/// @brief Get or register the histogram with the given name
+auto histogram(std::string_view name, std::string_view help) -> Histogram&;
+
+/**
+ * @brief Visitor over every registered metric in name order
+ */
+struct Visitor
+{
+    std::function<void(std::string_view name, Counter const&)> on_counter;
+    std::function<void(std::string_view name, Gauge const&)> on_gauge;
+    std::function<void(std::string_view name, Histogram const&)> on_histogram;
+};
+
+/// @brief Visit every registered metric in name order
+auto visit(Visitor const& visitor) -> void;
+
+/**
+ * @brief Render every registered metric in the Prometheus text format
+ *
+ * Histograms are reported in seconds with bucket bounds one nanosecond
+ * below each power of two from about 1 microsecond to 17 seconds.
+ */
+auto render_prometheus() -> std::string;
+
+} // namespace metrics
@@ -0,0 +1,128 @@
+#include "capture.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+CaptureReader::CaptureReader(std::unique_ptr<std::istream> in)
+    : in_{std::move(in)}
+    , offset_{0}
+    , time_{0}
+    , have_{false}
+    , line_number_{0}
+{
+    load();
+}
+
+auto CaptureReader::open(std::string const& path) -> CaptureReader
+{
+    auto in = std::make_unique<std::ifstream>(path, std::ios::binary);
+    if (not *in)
+    {
+        throw std::runtime_error{"failed to open capture file: " + path};
+    }
+    return CaptureReader{std::move(in)};
+}
+
+auto CaptureReader::load() -> void
+{
+    offset_ = 0;
+    while (std::getline(*in_, line_))
+    {
+        line_number_++;
+
+        if (not line_.empty() && '\r' == line_.back())
+        {
+            line_.pop_back();
+        }
+        if (line_.empty())
+        {
+            continue;
+        }
+
+        auto const space = line_.find(' ');
+        double seconds = 0;
+        if (space == line_.npos || 0 == space
+            || std::from_chars(line_.data(), line_.data() + space, seconds).ptr != line_.data() + space)
+        {
+            throw std::runtime_error{"malformed capture record on line " + std::to_string(line_number_)};
+        }
+
+        if (not origin_)
+        {
+            origin_ = seconds;
+        }
+        auto const offset = std::chrono::duration<double>{seconds - *origin_};
+        time_ = std::max(time_, std::chrono::duration_cast<duration>(offset));
+
+        line_.erase(0, space + 1);
+        line_ += "\r\n";
+        have_ = true;
+        return;
+    }
+
+    if (in_->bad())
+    {
+        throw std::runtime_error{"failed to read capture file"};
+    }
+    line_.clear();
+    have_ = false;
+}
+
+auto CaptureReader::read(std::span<char> out, duration const until) -> std::size_t
+{
+    std::size_t n = 0;
+    while (have_ && n < out.size() && (0 < offset_ || time_ <= until))
+    {
+        auto const chunk = std::min(out.size() - n, line_.size() - offset_);
+        std::copy_n(line_.data() + offset_, chunk, out.data() + n);
+        n += chunk;
+        offset_ += chunk;
+        if (offset_ == line_.size())
+        {
+            load();
+        }
+    }
+    return n;
+}
+
+CaptureWriter::CaptureWriter(std::unique_ptr<std::ostream> out)
+    : out_{std::move(out)}
+{
+}
+
+auto CaptureWriter::open(std::string const& path) -> CaptureWriter
+{
+    auto out = std::make_unique<std::ofstream>(path, std::ios::binary | std::ios::trunc);
+    if (not *out)
+    {
+        throw std::runtime_error{"failed to open capture file: " + path};
+    }
+    return CaptureWriter{std::move(out)};
+}
+
+auto CaptureWriter::write(std::chrono::system_clock::time_point const time, std::string_view bytes) -> void
+{
+    auto const us = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+
+    for (auto eol = bytes.find('\n'); eol != bytes.npos; eol = bytes.find('\n'))
+    {
+        partial_.append(bytes.substr(0, eol));
+        bytes.remove_prefix(eol + 1);
+
+        if (not partial_.empty() && '\r' == partial_.back())
+        {
+            partial_.pop_back();
+        }
+        if (not partial_.empty())
+        {
+            *out_ << us / 1'000'000 << '.' << std::setw(6) << std::setfill('0') << us % 1'000'000
+                  << ' ' << partial_ << '\n';
+        }
+        partial_.clear();
+    }
+    partial_.append(bytes);
+    out_->flush();
+}
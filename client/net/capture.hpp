@@ -0,0 +1,118 @@
+#pragma once
+/**
+ * @file capture.hpp
+ * @author Eric Mertens <emertens@gmail.com>
+ * @brief Timestamped recordings of IRC traffic
+ *
+ * A capture file holds one received line per record:
+ *
+ *     SECONDS LINE
+ *
+ * where SECONDS is a decimal number of seconds since any fixed origin,
+ * for example the Unix epoch, and LINE is the raw IRC line without its
+ * line terminator. Empty records are ignored.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Reader delivering captured lines as a byte stream
+ */
+class CaptureReader
+{
+public:
+    using duration = std::chrono::nanoseconds;
+
+private:
+    std::unique_ptr<std::istream> in_;
+
+    /// @brief Current record with its line terminator
+    std::string line_;
+    /// @brief Bytes of the current record already delivered
+    std::size_t offset_;
+    /// @brief Time of the current record relative to the first record
+    duration time_;
+    /// @brief True when line_ holds a record
+    bool have_;
+
+    /// @brief Time of the first record
+    std::optional<double> origin_;
+    /// @brief Line number of the current record for error messages
+    std::size_t line_number_;
+
+    /// @brief Load the next non-empty record
+    /// @throws std::runtime_error when a record has a malformed timestamp
+    auto load() -> void;
+
+public:
+    /// @brief Construct a reader over a capture stream
+    /// @throws std::runtime_error when the first record is malformed
+    explicit CaptureReader(std::unique_ptr<std::istream> in);
+
+    /// @brief Open a capture file
+    /// @throws std::runtime_error when the file can't be opened
+    static auto open(std::string const& path) -> CaptureReader;
+
+    /**
+     * @brief Time of the next record to deliver
+     *
+     * Times are relative to the first record and never decrease.
+     *
+     * @return Record time or nullopt at the end of the capture
+     */
+    auto next_time() const -> std::optional<duration>
+    {
+        return have_ ? std::optional{time_} : std::nullopt;
+    }
+
+    /**
+     * @brief Copy the records due by a point in time into a buffer
+     *
+     * Records are terminated with CRLF. A record that doesn't fit is
+     * split and the remainder is delivered by the next read regardless
+     * of its time, as it would be by a socket.
+     *
+     * @param out Destination buffer
+     * @param until Latest record time to deliver
+     * @return Bytes written to out
+     * @throws std::runtime_error when a record has a malformed timestamp
+     */
+    auto read(std::span<char> out, duration until = duration::max()) -> std::size_t;
+};
+
+/**
+ * @brief Writer recording received bytes as capture records
+ */
+class CaptureWriter
+{
+    std::unique_ptr<std::ostream> out_;
+
+    /// @brief Incomplete line left over from the previous write
+    std::string partial_;
+
+public:
+    explicit CaptureWriter(std::unique_ptr<std::ostream> out);
+
+    /// @brief Create or truncate a capture file
+    /// @throws std::runtime_error when the file can't be opened
+    static auto open(std::string const& path) -> CaptureWriter;
+
+    /**
+     * @brief Record bytes received from the network
+     *
+     * Each completed line is written with the time of the read that
+     * completed it. Incomplete lines wait for the next write.
+     *
+     * @param time Time the bytes were received
+     * @param bytes Received bytes
+     */
+    auto write(std::chrono::system_clock::time_point time, std::string_view bytes) -> void;
+};
@@ -1,38 +1,248 @@
 #include "connection.hpp"
 
+#include "../metrics.hpp"
+
 #include <socks5.hpp>
 
 #include <boost/io/ios_state.hpp>
 
 #include <array>
 #include <iomanip>
+#include <utility>
 #include <vector>
 
-connection::connection(boost::asio::io_context& io_context)
-    : stream_{io_context}
+namespace {
+
+/// @brief Number of emptied chunks kept for reuse by later writes
+std::size_t const max_spare_chunks = 16;
+
+/// @brief TLS handshakes completed
+auto tls_handshakes_counter() -> metrics::Counter&
+{
+    static auto& counter = metrics::counter("irc_tls_handshakes_total", "TLS handshakes completed");
+    return counter;
+}
+
+/// @brief TLS handshakes that resumed a cached session
+auto tls_resumed_counter() -> metrics::Counter&
+{
+    static auto& counter = metrics::counter("irc_tls_resumed_total", "TLS handshakes that resumed a cached session");
+    return counter;
+}
+
+/// @brief Index of the owning connection in an SSL object's extra data
+auto connection_index() -> int
+{
+    static int const index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+/// @brief Connections whose sent records are encrypted by the kernel
+auto ktls_send_gauge() -> metrics::Gauge&
+{
+    static auto& gauge = metrics::gauge("irc_ktls_send_connections", "Connections with kernel TLS send offload");
+    return gauge;
+}
+
+/// @brief Connections whose received records are decrypted by the kernel
+auto ktls_recv_gauge() -> metrics::Gauge&
+{
+    static auto& gauge = metrics::gauge("irc_ktls_recv_connections", "Connections with kernel TLS receive offload");
+    return gauge;
+}
+
+} // namespace
+
+connection::connection(boost::asio::io_context& io_context, std::size_t const high_water)
+    : executor_{io_context.get_executor()}
+    , stream_{io_context}
     , resolver_{io_context}
+    , high_water_{high_water}
+    , pace_timer_{io_context}
+{
+}
+
+connection::~connection()
+{
+    set_ktls(false, false);
+}
+
+auto connection::resume_session(SSL* const ssl) -> void
+{
+    if (not session_cache_)
+    {
+        return;
+    }
+
+    SSL_set_ex_data(ssl, connection_index(), this);
+    if (auto const session = session_cache_->get(session_key_))
+    {
+        SSL_set_session(ssl, session.get());
+    }
+}
+
+auto connection::on_new_session(SSL* const ssl, SSL_SESSION* const session) -> int
+{
+    auto const self = static_cast<connection*>(SSL_get_ex_data(ssl, connection_index()));
+    if (nullptr == self || not self->session_cache_)
+    {
+        return 0;
+    }
+
+    // OpenSSL marks the connection's own session unresumable when the
+    // connection ends without a clean shutdown, so cache a copy instead.
+    self->session_cache_->put(self->session_key_, TlsSessionCache::Session{SSL_SESSION_dup(session)});
+    return 0;
+}
+
+auto connection::set_ktls(bool const send, bool const recv) -> void
+{
+    ktls_send_gauge().add(int{send} - int{ktls_send_});
+    ktls_recv_gauge().add(int{recv} - int{ktls_recv_});
+    ktls_send_ = send;
+    ktls_recv_ = recv;
+}
+
+auto connection::send(std::string_view const msg, Lane const lane) -> bool
+{
+    if (not msg.empty())
+    {
+        scheduler_.push(lane, msg);
+        pump();
+    }
+    return backlog() < high_water_;
+}
+
+auto connection::post_send(std::string msg, Lane const lane) -> bool
+{
+    posted_bytes_ += msg.size();
+    boost::asio::post(executor_, [self = shared_from_this(), msg = std::move(msg), lane] {
+        self->send(msg, lane);
+        self->posted_bytes_ -= msg.size();
+    });
+
+    return snapshot().backlog() < high_water_;
+}
+
+auto connection::snapshot() const -> SendSnapshot
+{
+    std::lock_guard const lock{snapshot_mutex_};
+    auto result = snapshot_;
+    result.stats.queued_bytes += posted_bytes_;
+    return result;
+}
+
+auto connection::publish() -> void
 {
+    std::lock_guard const lock{snapshot_mutex_};
+    snapshot_.stats = stats_;
+    snapshot_.scheduled_bytes = scheduler_.queued_bytes();
+    for (std::size_t i = 0; i < lane_count; i++)
+    {
+        snapshot_.lanes[i] = scheduler_.lane_stats(static_cast<Lane>(i));
+    }
 }
 
-auto connection::write(std::string_view const cmd) -> void
+auto connection::set_pacing(double const burst, double const rate) -> void
+{
+    scheduler_.configure(burst, rate, SendScheduler::clock::now());
+    pump();
+}
+
+auto connection::pump() -> void
+{
+    auto const now = SendScheduler::clock::now();
+    while (auto const msg = scheduler_.pop(now))
+    {
+        write(*msg);
+    }
+
+    if (not scheduler_.empty() && not pace_pending_)
+    {
+        pace_pending_ = true;
+        pace_timer_.expires_after(scheduler_.delay(now));
+        pace_timer_.async_wait([self = shared_from_this()](boost::system::error_code const& error) {
+            self->pace_pending_ = false;
+            if (not error)
+            {
+                self->pump();
+            }
+        });
+    }
+
+    // Other threads see the bytes scheduled and queued before any write completes
+    publish();
+}
+
+auto connection::write(std::string_view const cmd) -> bool
 {
     if (not cmd.empty()) {
-        send_.insert(end(send_), begin(cmd), end(cmd));
+        // Start a new chunk unless the message fits in the current one
+        if (send_.empty() || send_.back().size() + cmd.size() > send_chunk_size)
+        {
+            if (spare_.empty())
+            {
+                send_.emplace_back().reserve(send_chunk_size);
+            }
+            else
+            {
+                send_.push_back(std::move(spare_.back()));
+                spare_.pop_back();
+            }
+        }
+        send_.back().append(cmd);
+        send_messages_++;
+        stats_.queued_bytes += cmd.size();
+        stats_.queued_messages++;
+
         if (sending_.empty())
         {
             write_actual();
         }
     }
+    return stats_.queued_bytes < high_water_;
 }
 
 auto connection::write_actual() -> void
 {
     std::swap(send_, sending_);
+    sending_messages_ = std::exchange(send_messages_, 0);
+
+    std::vector<boost::asio::const_buffer> buffers;
+    buffers.reserve(sending_.size());
+    std::size_t sending_bytes = 0;
+    for (auto const& chunk : sending_)
+    {
+        buffers.push_back(boost::asio::buffer(chunk));
+        sending_bytes += chunk.size();
+    }
+    stats_.writes++;
+
     boost::asio::async_write(
         stream_,
-        boost::asio::buffer(sending_),
-        [self = shared_from_this()](boost::system::error_code const& error, std::size_t) {
+        std::move(buffers),
+        [self = shared_from_this(), sending_bytes](boost::system::error_code const& error, std::size_t const n) {
+            self->stats_.sent_bytes += n;
+            self->stats_.queued_bytes -= sending_bytes;
+            self->stats_.queued_messages -= self->sending_messages_;
+            if (not error)
+            {
+                self->stats_.sent_messages += self->sending_messages_;
+            }
+
+            // Recycle ordinary chunks; oversized ones are released
+            for (auto& chunk : self->sending_)
+            {
+                if (self->spare_.size() < max_spare_chunks && chunk.capacity() < 2 * send_chunk_size)
+                {
+                    chunk.clear();
+                    self->spare_.push_back(std::move(chunk));
+                }
+            }
             self->sending_.clear();
+            self->sending_messages_ = 0;
+            self->publish();
+
             if (not error && not self->send_.empty())
             {
                 self->write_actual();
@@ -44,6 +254,7 @@ auto connection::write_actual() -> void
 auto connection::close() -> void
 {
     resolver_.cancel();
+    pace_timer_.cancel();
     stream_.close();
 }
 
@@ -170,6 +381,71 @@ auto constexpr alpn_encode(char const (&... protocols)[Ns]) -> std::array<unsign
     throw boost::system::system_error{ec, prefix};
 }
 
+/**
+ * @brief Apply the client certificate, ALPN, and SNI settings to a TLS session
+ *
+ * @param ssl TLS session before its handshake
+ * @param settings Connection settings
+ * @throws boost::system::system_error when OpenSSL rejects a setting
+ */
+auto configure_tls(SSL* const ssl, Settings const& settings) -> void
+{
+    // Set the client certificate, if specified
+    if (auto const client_cert = settings.client_cert.get())
+    {
+        if (1 != SSL_use_certificate(ssl, client_cert))
+        {
+            openssl_error("SSL_use_certificate");
+        }
+    }
+
+    // Set the client private key, if specified
+    if (auto const client_key = settings.client_key.get())
+    {
+        if (1 != SSL_use_PrivateKey(ssl, client_key))
+        {
+            openssl_error("SSL_use_PrivateKey");
+        }
+    }
+
+    // Configure ALPN
+    {
+        auto constexpr protos = alpn_encode("irc");
+        // non-standard return behavior
+        if (0 != SSL_set_alpn_protos(ssl, protos.data(), protos.size()))
+        {
+            // not documented to set an error code
+            throw std::runtime_error{"SSL_set_alpn_protos"};
+        }
+    }
+
+    // Set the SNI hostname, if specified
+    if (not settings.sni.empty())
+    {
+        if (1 != SSL_set_tlsext_host_name(ssl, settings.sni.c_str()))
+        {
+            // not documented to set an error code
+            throw std::runtime_error{"SSL_set_tlsext_host_name"};
+        }
+    }
+}
+
+/**
+ * @brief Count a completed handshake and report whether it resumed a session
+ *
+ * @param os Connection description
+ * @param ssl TLS session after its handshake
+ */
+auto count_handshake(std::ostream& os, SSL const* const ssl) -> void
+{
+    tls_handshakes_counter().add();
+    if (SSL_session_reused(ssl))
+    {
+        tls_resumed_counter().add();
+        os << " resumed=yes";
+    }
+}
+
 } // namespace
 
 auto connection::connect(Settings settings) -> boost::asio::awaitable<std::string>
@@ -177,7 +453,23 @@ auto connection::connect(Settings settings) -> boost::asio::awaitable<std::strin
     // Fingerprint string builder
     std::ostringstream os;
 
+    if (not settings.replay.empty())
+    {
+        stream_.replay(CaptureReader::open(settings.replay), settings.replay_speed);
+        os << "replay=" << settings.replay;
+        co_return os.str();
+    }
+
+    // Sessions are keyed by the IRC server, not any SOCKS proxy in between
+    session_cache_ = std::move(settings.session_cache);
+    if (session_cache_)
+    {
+        session_key_ = TlsSessionCache::make_key(
+            settings.host, settings.port, settings.sni, settings.verify, settings.client_cert.get());
+    }
+
     // replace previous socket and ensure it's a tcp socket
+    set_ktls(false, false);
     auto& socket = stream_.reset();
 
     // If we're going to use SOCKS then the TCP connection host is actually the socks
@@ -217,62 +509,67 @@ auto connection::connect(Settings settings) -> boost::asio::awaitable<std::strin
         boost::asio::ssl::context ssl_context{boost::asio::ssl::context::method::tls_client};
         ssl_context.set_default_verify_paths();
 
-        // Upgrade stream_ to use TLS and invalidate socket
-        auto& stream = stream_.upgrade(ssl_context);
-
-        // Set the client certificate, if specified
-        if (auto const client_cert = settings.client_cert.get())
+        // Hand sessions issued by the server to the session cache
+        if (session_cache_)
         {
-            if (1 != SSL_use_certificate(stream.native_handle(), client_cert))
-            {
-                openssl_error("SSL_use_certificate");
-            }
+            SSL_CTX_set_session_cache_mode(
+                ssl_context.native_handle(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+            SSL_CTX_sess_set_new_cb(ssl_context.native_handle(), on_new_session);
         }
 
-        // Set the client private key, if specified
-        if (auto const client_key = settings.client_key.get())
+        if (settings.ktls)
         {
-            if (1 != SSL_use_PrivateKey(stream.native_handle(), client_key))
+            // Kernel offload needs OpenSSL to own the socket, so this bypasses asio's TLS engine
+            auto& stream = stream_.upgrade_ktls(ssl_context);
+            auto const ssl = stream.native_handle();
+            configure_tls(ssl, settings);
+            resume_session(ssl);
+
+            // Configure server certificate verification
+            if (not settings.verify.empty())
             {
-                openssl_error("SSL_use_PrivateKey");
+                SSL_set_verify(ssl, SSL_VERIFY_PEER, nullptr);
+                if (1 != SSL_set1_host(ssl, settings.verify.c_str()))
+                {
+                    openssl_error("SSL_set1_host");
+                }
             }
-        }
 
-        // Update the BIO buffer sizes
-        set_buffer_size(stream, irc_buffer_size);
+            // Configuration complete, initiate the handshake
+            co_await stream.async_handshake(boost::asio::use_awaitable);
 
-        // Configure ALPN
-        {
-            auto constexpr protos = alpn_encode("irc");
-            // non-standard return behavior
-            if (0 != SSL_set_alpn_protos(stream.native_handle(), protos.data(), protos.size()))
-            {
-                // not documented to set an error code
-                throw std::runtime_error{"SSL_set_alpn_protos"};
-            }
-        }
+            // Offload engages per direction only if the kernel supports the negotiated cipher
+            auto const send = stream.ktls_send();
+            auto const recv = stream.ktls_recv();
+            set_ktls(send, recv);
 
-        // Configure server certificate verification
-        if (not settings.verify.empty())
-        {
-            stream.set_verify_mode(boost::asio::ssl::verify_peer);
-            stream.set_verify_callback(boost::asio::ssl::host_name_verification(settings.verify));
+            peer_fingerprint(os << " tls=", ssl);
+            count_handshake(os, ssl);
+            os << " ktls=" << (send && recv ? "send,recv" : send ? "send" : recv ? "recv" : "off");
         }
-
-        // Set the SNI hostname, if specified
-        if (not settings.sni.empty())
+        else
         {
-            if (1 != SSL_set_tlsext_host_name(stream.native_handle(), settings.sni.c_str()))
+            // Upgrade stream_ to use TLS and invalidate socket
+            auto& stream = stream_.upgrade(ssl_context);
+            configure_tls(stream.native_handle(), settings);
+            resume_session(stream.native_handle());
+
+            // Update the BIO buffer sizes
+            set_buffer_size(stream, irc_buffer_size);
+
+            // Configure server certificate verification
+            if (not settings.verify.empty())
             {
-                // not documented to set an error code
-                throw std::runtime_error{"SSL_set_tlsext_host_name"};
+                stream.set_verify_mode(boost::asio::ssl::verify_peer);
+                stream.set_verify_callback(boost::asio::ssl::host_name_verification(settings.verify));
             }
-        }
 
-        // Configuration complete, initiate the handshake
-        co_await stream.async_handshake(stream.client, boost::asio::use_awaitable);
+            // Configuration complete, initiate the handshake
+            co_await stream.async_handshake(stream.client, boost::asio::use_awaitable);
 
-        peer_fingerprint(os << " tls=", stream.native_handle());
+            peer_fingerprint(os << " tls=", stream.native_handle());
+            count_handshake(os, stream.native_handle());
+        }
     }
 
     co_return os.str();
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "sendscheduler.hpp"
+#include "sessioncache.hpp"
 #include "stream.hpp"
 
 #include <socks5.hpp>
@@ -9,9 +11,13 @@
 #include <openssl/evp.h>
 #include <openssl/x509.h>
 
+#include <array>
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
 #include <vector>
 
 struct lua_State;
@@ -36,38 +42,138 @@ struct Settings
     Ref<EVP_PKEY, EVP_PKEY_up_ref, EVP_PKEY_free> client_key;
     std::string verify;
     std::string sni;
+    /// Request kernel TLS offload of record encryption and decryption
+    bool ktls;
+    /// Sessions to resume and to update; null to always do a full handshake
+    std::shared_ptr<TlsSessionCache> session_cache;
 
     std::string socks_host;
     std::uint16_t socks_port;
     socks5::Auth socks_auth;
+
+    /// Capture file read in place of connecting; empty to connect normally
+    std::string replay;
+    /// Replay rate relative to the recording; non-positive replays as fast as possible
+    double replay_speed;
+};
+
+/// @brief Counters describing the outgoing message queue
+struct SendStats
+{
+    /// Bytes queued and not yet written
+    std::size_t queued_bytes;
+    /// Messages queued and not yet written
+    std::size_t queued_messages;
+    /// Bytes written to the stream
+    std::size_t sent_bytes;
+    /// Messages written to the stream
+    std::size_t sent_messages;
+    /// Gathered writes issued to the stream
+    std::size_t writes;
+};
+
+/// @brief Copy of the send-side counters that any thread can read
+struct SendSnapshot
+{
+    SendStats stats;
+    /// Bytes waiting in the flood-control scheduler
+    std::size_t scheduled_bytes;
+    /// Counters of each scheduler lane
+    std::array<LaneStats, lane_count> lanes;
+
+    /// @brief Bytes scheduled or queued and not yet written
+    auto backlog() const -> std::size_t
+    {
+        return stats.queued_bytes + scheduled_bytes;
+    }
 };
 
 class connection final : public std::enable_shared_from_this<connection>
 {
 public:
     static std::size_t const irc_buffer_size = 131'072;
+    static std::size_t const irc_buffer_max_size = 1'048'576;
+
+    /// @brief Messages smaller than this are coalesced into shared chunks
+    static std::size_t const send_chunk_size = 4'096;
 
 private:
+    boost::asio::io_context::executor_type executor_;
     Stream stream_;
     boost::asio::ip::tcp::resolver resolver_;
 
-    /// @brief The bytes held for async_write
-    std::vector<char> sending_;
+    /// @brief The chunks held for a gathered async_write
+    std::vector<std::string> sending_;
+
+    /// @brief The chunks accumulated for the next write
+    std::vector<std::string> send_;
+
+    /// @brief Chunks kept from completed writes for reuse
+    std::vector<std::string> spare_;
+
+    /// @brief Messages in send_
+    std::size_t send_messages_ = 0;
+
+    /// @brief Messages in sending_
+    std::size_t sending_messages_ = 0;
+
+    /// @brief Queue size in bytes at which writers are told to back off
+    std::size_t high_water_;
+
+    SendStats stats_ {};
+
+    /// @brief Messages waiting for flood-control tokens
+    SendScheduler scheduler_;
+
+    /// @brief Timer waking the scheduler when the next token is available
+    boost::asio::steady_timer pace_timer_;
+
+    /// @brief True while pace_timer_ is armed
+    bool pace_pending_ = false;
 
-    /// @brief The bytes accumulated for the next write
-    std::vector<char> send_;
+    /// @brief Guards snapshot_
+    mutable std::mutex snapshot_mutex_;
+
+    /// @brief Counters published for other threads after each change
+    SendSnapshot snapshot_ {};
+
+    /// @brief Bytes posted by post_send and not yet handed to send
+    std::atomic<std::size_t> posted_bytes_ {0};
+
+    /// @brief True while counted as having kernel TLS send offload
+    bool ktls_send_ = false;
+
+    /// @brief True while counted as having kernel TLS receive offload
+    bool ktls_recv_ = false;
+
+    /// @brief Cache receiving the sessions issued to this connection
+    std::shared_ptr<TlsSessionCache> session_cache_;
+
+    /// @brief Key of this connection in session_cache_
+    std::string session_key_;
 
 public:
-    connection(boost::asio::io_context&);
+    connection(boost::asio::io_context&, std::size_t high_water);
+    ~connection();
 
     auto operator=(connection const&) -> connection& = delete;
     auto operator=(connection&&) -> connection& = delete;
     connection(connection const&) = delete;
     connection(connection&&) = delete;
 
-    auto static create(boost::asio::io_context& io_context) -> std::shared_ptr<connection>
+    auto static create(boost::asio::io_context& io_context, std::size_t const high_water = irc_buffer_max_size) -> std::shared_ptr<connection>
+    {
+        return std::make_shared<connection>(io_context, high_water);
+    }
+
+    /**
+     * @brief Get the executor of the IO context the connection runs on
+     *
+     * Unlike the rest of the connection this is safe to use from any thread.
+     */
+    auto get_executor() const -> boost::asio::io_context::executor_type
     {
-        return std::make_shared<connection>(io_context);
+        return executor_;
     }
 
     auto get_stream() -> Stream&
@@ -79,9 +185,85 @@ public:
     /**
      * @brief Write a message to the output stream
      *
+     * The message is always queued. Small messages are coalesced into
+     * shared chunks and all queued chunks go out in one gathered write.
+     *
+     * @param msg The string to write including any needed line-terminators
+     * @return false when the queue is at or above the high-water mark
+     */
+    auto write(std::string_view msg) -> bool;
+
+    /**
+     * @brief Send a message subject to flood control
+     *
+     * Messages are released to write in lane priority order as the
+     * token bucket allows. Unpaced connections write immediately.
+     *
      * @param msg The string to write including any needed line-terminators
+     * @param lane Priority of the message
+     * @return false when the scheduled and queued bytes reach the high-water mark
      */
-    auto write(std::string_view msg) -> void;
+    auto send(std::string_view msg, Lane lane) -> bool;
+
+    /**
+     * @brief Send a message from a thread other than the connection's
+     *
+     * The message is handed to send on the connection's executor.
+     *
+     * @param msg The string to write including any needed line-terminators
+     * @param lane Priority of the message
+     * @return false when the posted, scheduled, and queued bytes reach the high-water mark
+     */
+    auto post_send(std::string msg, Lane lane) -> bool;
+
+    /**
+     * @brief Configure flood-control pacing
+     *
+     * @param burst Largest number of messages sent back-to-back
+     * @param rate Messages per second; non-positive disables pacing
+     */
+    auto set_pacing(double burst, double rate) -> void;
+
+    /**
+     * @brief Get the flood-control scheduler
+     */
+    auto get_scheduler() const -> SendScheduler const&
+    {
+        return scheduler_;
+    }
+
+    /**
+     * @brief Get the outgoing queue counters
+     */
+    auto send_stats() const -> SendStats
+    {
+        return stats_;
+    }
+
+    /**
+     * @brief Get the bytes scheduled or queued and not yet written
+     */
+    auto backlog() const -> std::size_t
+    {
+        return stats_.queued_bytes + scheduler_.queued_bytes();
+    }
+
+    /**
+     * @brief Get the latest published send counters from any thread
+     *
+     * The counters are published whenever messages are scheduled,
+     * queued, or written. Bytes posted by post_send but not yet sent
+     * count as queued.
+     */
+    auto snapshot() const -> SendSnapshot;
+
+    /**
+     * @brief Get the queue size in bytes at which writes report backpressure
+     */
+    auto high_water() const -> std::size_t
+    {
+        return high_water_;
+    }
 
     /**
      * @brief Abruptly close the connection.
@@ -92,6 +274,10 @@ public:
     /**
      * @brief Initiate a connection to the IRC server
      * 
+     * When settings name a replay file the capture is read in place of
+     * the server and writes are discarded. When settings request kernel
+     * TLS the description reports which directions were offloaded.
+     *
      * @param settings Parameters needed to establish a text stream with the server.
      * @return Space-separated, key=value pairs describing the connection
      */
@@ -100,4 +286,19 @@ public:
 private:
     // There's data now, actually write it
     auto write_actual() -> void;
+
+    // Write every message the scheduler releases and wait for the rest
+    auto pump() -> void;
+
+    // Copy the current counters into snapshot_
+    auto publish() -> void;
+
+    // Update the kernel TLS offload gauges for this connection
+    auto set_ktls(bool send, bool recv) -> void;
+
+    // Offer a cached session and arrange for new sessions to be cached
+    auto resume_session(SSL* ssl) -> void;
+
+    // OpenSSL callback storing a session issued by the server
+    static auto on_new_session(SSL* ssl, SSL_SESSION* session) -> int;
 };
@@ -0,0 +1,226 @@
+#pragma once
+/**
+ * @file ktlsstream.hpp
+ * @author Eric Mertens <emertens@gmail.com>
+ * @brief TLS stream able to hand record processing to the kernel
+ */
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+/**
+ * @brief TLS stream whose SSL object reads and writes the socket directly
+ *
+ * boost::asio::ssl::stream passes records through a memory BIO pair,
+ * which rules out kernel TLS. Here OpenSSL owns the socket's file
+ * descriptor, so with SSL_OP_ENABLE_KTLS it installs the session keys in
+ * the kernel after the handshake. SSL_read and SSL_write then become
+ * plain recvmsg and sendmsg calls on the socket for the offloaded
+ * directions while OpenSSL still handles any post-handshake messages.
+ * Directions that couldn't be offloaded fall back to userspace records.
+ *
+ * The socket is non-blocking and the stream waits for readiness between
+ * attempts, so every operation completes asynchronously.
+ */
+class KtlsStream
+{
+public:
+    using tcp_socket = boost::asio::ip::tcp::socket;
+
+private:
+    struct SslDeleter
+    {
+        auto operator()(SSL* const ssl) const -> void { SSL_free(ssl); }
+    };
+
+    tcp_socket socket_;
+    std::unique_ptr<SSL, SslDeleter> ssl_;
+
+    /**
+     * @brief Run an SSL call until it succeeds, waiting on the socket as directed
+     *
+     * @param op Function calling OpenSSL returning its result and byte count
+     * @param wait_first Readiness to wait for before the first attempt; nullopt to try right away
+     */
+    template <typename Op, typename Token>
+    auto async_ssl(Op op, std::optional<tcp_socket::wait_type> const wait_first, Token&& token) -> decltype(auto)
+    {
+        return boost::asio::async_compose<Token, void(boost::system::error_code, std::size_t)>(
+            [this, op, wait_first, started = false](auto& self, boost::system::error_code const error = {}) mutable {
+                if (not started)
+                {
+                    started = true;
+                    if (wait_first)
+                    {
+                        socket_.async_wait(*wait_first, std::move(self));
+                    }
+                    else
+                    {
+                        boost::asio::post(std::move(self));
+                    }
+                    return;
+                }
+                if (error)
+                {
+                    self.complete(error, 0);
+                    return;
+                }
+
+                ERR_clear_error();
+                std::size_t n = 0;
+                auto const result = op(n);
+                auto const saved_errno = errno;
+                if (0 < result)
+                {
+                    self.complete({}, n);
+                    return;
+                }
+
+                switch (auto const code = SSL_get_error(ssl_.get(), result))
+                {
+                case SSL_ERROR_WANT_READ:
+                    socket_.async_wait(tcp_socket::wait_read, std::move(self));
+                    return;
+                case SSL_ERROR_WANT_WRITE:
+                    socket_.async_wait(tcp_socket::wait_write, std::move(self));
+                    return;
+                case SSL_ERROR_ZERO_RETURN:
+                    self.complete(boost::asio::error::eof, 0);
+                    return;
+                case SSL_ERROR_SYSCALL:
+                    if (0 == ERR_peek_error())
+                    {
+                        self.complete(0 == saved_errno
+                            ? boost::system::error_code{boost::asio::ssl::error::stream_truncated}
+                            : boost::system::error_code{saved_errno, boost::asio::error::get_system_category()}, 0);
+                        return;
+                    }
+                    [[fallthrough]];
+                default:
+                {
+                    auto const err = ERR_get_error();
+                    self.complete({static_cast<int>(0 == err ? code : err), boost::asio::error::get_ssl_category()}, 0);
+                    return;
+                }
+                }
+            },
+            token, socket_
+        );
+    }
+
+public:
+    /**
+     * @brief Wrap a connected socket in a client TLS session
+     *
+     * Kernel offload is requested but only engages when the kernel and
+     * the negotiated cipher support it.
+     *
+     * @param socket Connected socket
+     * @param ctx Context supplying defaults for the session
+     * @throws boost::system::system_error when the session can't be created
+     */
+    KtlsStream(tcp_socket&& socket, boost::asio::ssl::context& ctx)
+        : socket_{std::move(socket)}
+        , ssl_{SSL_new(ctx.native_handle())}
+    {
+        if (not ssl_ || 1 != SSL_set_fd(ssl_.get(), socket_.native_handle()))
+        {
+            throw boost::system::system_error{
+                {static_cast<int>(ERR_get_error()), boost::asio::error::get_ssl_category()}, "KtlsStream"};
+        }
+        SSL_set_options(ssl_.get(), SSL_OP_ENABLE_KTLS);
+        SSL_set_connect_state(ssl_.get());
+        socket_.non_blocking(true);
+    }
+
+    auto native_handle() -> SSL*
+    {
+        return ssl_.get();
+    }
+
+    auto lowest_layer() -> tcp_socket::lowest_layer_type&
+    {
+        return socket_.lowest_layer();
+    }
+
+    auto lowest_layer() const -> tcp_socket::lowest_layer_type const&
+    {
+        return socket_.lowest_layer();
+    }
+
+    /// @brief True when the kernel encrypts outgoing records
+    auto ktls_send() const -> bool
+    {
+        return BIO_get_ktls_send(SSL_get_wbio(ssl_.get()));
+    }
+
+    /// @brief True when the kernel decrypts incoming records
+    auto ktls_recv() const -> bool
+    {
+        return BIO_get_ktls_recv(SSL_get_rbio(ssl_.get()));
+    }
+
+    /**
+     * @brief Perform the client handshake
+     */
+    template <boost::asio::completion_token_for<void(boost::system::error_code, std::size_t)> Token>
+    auto async_handshake(Token&& token) -> decltype(auto)
+    {
+        return async_ssl(
+            [ssl = ssl_.get()](std::size_t&) { return SSL_do_handshake(ssl); },
+            std::nullopt, std::forward<Token>(token)
+        );
+    }
+
+    /**
+     * @brief Read decrypted bytes into the first buffer
+     */
+    template <
+        typename MutableBufferSequence,
+        boost::asio::completion_token_for<void(boost::system::error_code, std::size_t)> Token>
+    auto async_read_some(MutableBufferSequence const& buffers, Token&& token) -> decltype(auto)
+    {
+        boost::asio::mutable_buffer const target = *boost::asio::buffer_sequence_begin(buffers);
+        // Decrypted or buffered bytes are ready without waiting for the socket
+        auto const wait = SSL_has_pending(ssl_.get())
+            ? std::nullopt
+            : std::optional{tcp_socket::wait_read};
+        return async_ssl(
+            [ssl = ssl_.get(), target](std::size_t& n) { return SSL_read_ex(ssl, target.data(), target.size(), &n); },
+            wait, std::forward<Token>(token)
+        );
+    }
+
+    /**
+     * @brief Write the first non-empty buffer
+     */
+    template <
+        typename ConstBufferSequence,
+        boost::asio::completion_token_for<void(boost::system::error_code, std::size_t)> Token>
+    auto async_write_some(ConstBufferSequence const& buffers, Token&& token) -> decltype(auto)
+    {
+        boost::asio::const_buffer source;
+        for (auto it = boost::asio::buffer_sequence_begin(buffers); it != boost::asio::buffer_sequence_end(buffers); ++it)
+        {
+            source = *it;
+            if (0 < source.size())
+            {
+                break;
+            }
+        }
+        return async_ssl(
+            [ssl = ssl_.get(), source](std::size_t& n) {
+                return 0 == source.size() ? 1 : SSL_write_ex(ssl, source.data(), source.size(), &n);
+            },
+            tcp_socket::wait_write, std::forward<Token>(token)
+        );
+    }
+};
@@ -1,31 +1,129 @@
 #include "linebuffer.hpp"
 
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/// @brief Portable search used for short tails and unsupported targets
+auto find_newline_scalar(char* const first, char* const last) -> char*
+{
+    auto const nl = static_cast<char*>(std::memchr(first, '\n', last - first));
+    return nl ? nl : last;
+}
+
+#ifdef __SSE2__
+/// @brief Compare 16 bytes at a time using SSE2
+auto find_newline_sse2(char* first, char* const last) -> char*
+{
+    auto const nl = _mm_set1_epi8('\n');
+    for (; last - first >= 16; first += 16)
+    {
+        auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+        auto const mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, nl)));
+        if (0 != mask)
+        {
+            return first + std::countr_zero(mask);
+        }
+    }
+    return find_newline_scalar(first, last);
+}
+#endif
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#define LINEBUFFER_AVX2
+/// @brief Compare 32 bytes at a time using AVX2
+[[gnu::target("avx2")]]
+auto find_newline_avx2(char* first, char* const last) -> char*
+{
+    auto const nl = _mm256_set1_epi8('\n');
+    for (; last - first >= 32; first += 32)
+    {
+        auto const chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first));
+        auto const mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, nl)));
+        if (0 != mask)
+        {
+            return first + std::countr_zero(mask);
+        }
+    }
+    return find_newline_sse2(first, last);
+}
+#endif
+
+/// @brief Select the widest implementation supported by the running CPU
+auto select_find_newline() -> char* (*)(char*, char*)
+{
+#ifdef LINEBUFFER_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return find_newline_avx2;
+    }
+#endif
+#ifdef __SSE2__
+    return find_newline_sse2;
+#else
+    return find_newline_scalar;
+#endif
+}
+
+auto const find_newline_impl = select_find_newline();
+
+} // namespace
+
+auto find_newline(char* const first, char* const last) -> char*
+{
+    return find_newline_impl(first, last);
+}
+
 auto LineBuffer::next_line() -> char*
 {
-    auto const nl = std::find(search_, end_, '\n');
-    if (nl == end_) // no newline found, line incomplete
+    auto const data = buffer_.data();
+    auto const nl = find_newline(data + search_, data + end_);
+    if (nl == data + end_) // no newline found, line incomplete
     {
         search_ = end_;
         return nullptr;
     }
 
+    auto const result = data + start_;
+
     // Null-terminate the line. Support both \n and \r\n
-    *(start_ < nl && *std::prev(nl) == '\r' ? std::prev(nl) : nl) = '\0';
+    *(result < nl && *std::prev(nl) == '\r' ? std::prev(nl) : nl) = '\0';
 
-    auto const result = start_;
-    start_ = search_ = std::next(nl);
+    start_ = search_ = std::distance(data, nl) + 1;
 
-    return &*result;
+    return result;
 }
 
 auto LineBuffer::shift() -> void
 {
-    auto const first = std::begin(buffer_);
-    auto const gap = std::distance(start_, first);
-    if (gap != 0) // relocate incomplete line to front of buffer
+    // When every line was consumed the buffer can be reused
+    // from the beginning without moving anything.
+    if (start_ == end_)
+    {
+        start_ = search_ = end_ = 0;
+    }
+}
+
+auto LineBuffer::reserve() -> void
+{
+    auto const first = buffer_.begin();
+
+    if (start_ != 0) // relocate incomplete line to front of buffer
+    {
+        std::copy(first + start_, first + end_, first);
+        end_ -= start_;
+        search_ -= start_;
+        start_ = 0;
+    }
+
+    if (end_ == buffer_.size() && buffer_.size() < max_size_) // a single line fills the buffer
     {
-        end_ = std::move(start_, end_, first);
-        start_ = first;
-        std::advance(search_, gap);
+        buffer_.resize(std::min(max_size_, 2 * buffer_.size()));
     }
 }
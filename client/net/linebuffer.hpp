@@ -13,68 +13,94 @@
 #include <boost/asio/buffer.hpp>
 
 #include <algorithm>
-#include <concepts>
+#include <cstddef>
 #include <vector>
 
 /**
- * @brief Fixed-size buffer with line-oriented dispatch
+ * @brief Find the first newline character in a range
  *
+ * Uses AVX2 or SSE2 when available, falling back to a scalar search.
+ *
+ * @param first Beginning of search range
+ * @param last End of search range
+ * @return Pointer to first newline or last if none was found
+ */
+auto find_newline(char* first, char* last) -> char*;
+
+/**
+ * @brief Growable buffer with line-oriented dispatch
+ *
+ * Incomplete lines are left in place after the completed lines are
+ * consumed. They are only moved back to the front of the buffer once
+ * the space at the end of the buffer is exhausted. When a single line
+ * fills the whole buffer the buffer grows, up to a configured limit.
  */
 class LineBuffer
 {
     std::vector<char> buffer_;
 
-    // [std::begin(buffer), end_) contains buffered data
-    // [end_, std::end(buffer)) is available buffer space
-    decltype(buffer_)::iterator start_;
-    decltype(buffer_)::iterator search_;
-    decltype(buffer_)::iterator end_;
+    /// @brief Largest size the buffer is allowed to grow to
+    std::size_t max_size_;
+
+    // [0, start_) contains consumed lines
+    // [start_, end_) contains buffered data
+    // [search_, end_) is known not to contain a newline
+    // [end_, size) is available buffer space
+    std::size_t start_;
+    std::size_t search_;
+    std::size_t end_;
+
+    /// @brief Ensure there is space available at the end of the buffer
+    auto reserve() -> void;
 
 public:
     /**
      * @brief Construct a new Line Buffer object
      *
-     * @param n Buffer size
+     * @param n Initial buffer size
+     * @param max_size Maximum buffer size, defaults to initial size
      */
-    LineBuffer(std::size_t n)
+    LineBuffer(std::size_t const n, std::size_t const max_size = 0)
         : buffer_(n)
-        , start_{buffer_.begin()}
-        , search_{buffer_.begin()}
-        , end_{buffer_.begin()}
+        , max_size_{std::max(n, max_size)}
+        , start_{0}
+        , search_{0}
+        , end_{0}
     {
     }
 
-    // can't copy the iterator member safely
-    LineBuffer(LineBuffer const&) = delete;
-    LineBuffer(LineBuffer&&) = delete;
-    auto operator=(LineBuffer const&) -> LineBuffer& = delete;
-    auto operator=(LineBuffer&&) -> LineBuffer& = delete;
-
     /**
      * @brief Get the available buffer space
      *
+     * This can relocate buffered data invalidating all
+     * previous next_line() results. An empty buffer is returned
+     * when the buffer is full and has reached its maximum size.
+     *
      * @return boost::asio::mutable_buffer
      */
     auto prepare() -> boost::asio::mutable_buffer
     {
-        return boost::asio::buffer(&*end_, std::distance(end_, buffer_.end()));
+        // Only relocate data once the consumed prefix is larger than
+        // the remaining free space so that moves are amortized.
+        if (buffer_.size() - end_ <= start_)
+        {
+            reserve();
+        }
+        return boost::asio::buffer(buffer_.data() + end_, buffer_.size() - end_);
     }
 
     /**
-     * @brief Commit new buffer bytes and dispatch line callback
+     * @brief Commit new buffer bytes
      *
      * The first n bytes of the buffer will be considered to be
-     * populated. The line callback function will be called once
-     * per completed line. Those lines are removed from the buffer
-     * and the is ready for additional calls to prepare and
-     * commit.
+     * populated. Completed lines can then be extracted with
+     * next_line.
      *
      * @param n Bytes written to the last call of prepare
-     * @param line_cb Callback function to run on each completed line
      */
     auto commit(std::size_t const n) -> void
     {
-        std::advance(end_, n);
+        end_ += n;
     }
 
     /**
@@ -91,7 +117,17 @@ public:
     /**
      * @brief Reclaim used buffer space invalidating all previous
      * next_line() results;
-     * 
+     *
      */
     auto shift() -> void;
+
+    /**
+     * @brief Current allocated size of the buffer
+     *
+     * @return size in bytes
+     */
+    auto capacity() const -> std::size_t
+    {
+        return buffer_.size();
+    }
 };
@@ -0,0 +1,97 @@
+#pragma once
+/**
+ * @file mpscqueue.hpp
+ * @author Eric Mertens <emertens@gmail.com>
+ * @brief Lock-free multi-producer single-consumer queue
+ *
+ */
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+/**
+ * @brief Unbounded lock-free queue with many producers and one consumer
+ *
+ * This is Dmitry Vyukov's intrusive MPSC queue. Pushing is wait-free: one
+ * atomic exchange and one store. Popping never blocks, but an element
+ * whose producer is between those two steps isn't visible yet. In that
+ * case pop returns nullopt while empty returns false, and the consumer
+ * should try again later.
+ *
+ * Elements from one producer are popped in the order they were pushed.
+ *
+ * @tparam T Element type
+ */
+template <typename T>
+class MpscQueue
+{
+    struct Node
+    {
+        std::atomic<Node*> next{nullptr};
+        std::optional<T> value;
+    };
+
+    /// @brief Most recently pushed node; shared by producers
+    alignas(64) std::atomic<Node*> head_;
+
+    /// @brief Node preceding the next element to pop; owned by the consumer
+    alignas(64) Node* tail_;
+
+public:
+    MpscQueue()
+        : head_{new Node}
+        , tail_{head_.load(std::memory_order_relaxed)}
+    {
+    }
+
+    MpscQueue(MpscQueue const&) = delete;
+    auto operator=(MpscQueue const&) -> MpscQueue& = delete;
+
+    ~MpscQueue()
+    {
+        while (tail_)
+        {
+            delete std::exchange(tail_, tail_->next.load(std::memory_order_relaxed));
+        }
+    }
+
+    /**
+     * @brief Add an element; safe to call from any thread
+     *
+     * @param value Element to add
+     */
+    auto push(T value) -> void
+    {
+        auto const node = new Node;
+        node->value.emplace(std::move(value));
+        auto const prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /**
+     * @brief Remove the oldest visible element; consumer only
+     *
+     * @return Removed element or nullopt when none is visible
+     */
+    auto pop() -> std::optional<T>
+    {
+        auto const next = tail_->next.load(std::memory_order_acquire);
+        if (nullptr == next)
+        {
+            return std::nullopt;
+        }
+        auto value = std::move(next->value);
+        next->value.reset();
+        delete std::exchange(tail_, next);
+        return value;
+    }
+
+    /**
+     * @brief Check for elements including ones still being pushed; consumer only
+     */
+    auto empty() const -> bool
+    {
+        return tail_ == head_.load(std::memory_order_acquire);
+    }
+};
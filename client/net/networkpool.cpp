@@ -0,0 +1,68 @@
+#include "networkpool.hpp"
+
+#include <algorithm>
+
+NetworkPool::NetworkPool(std::size_t const max_threads)
+    : max_threads_{std::max<std::size_t>(1, max_threads)}
+    , next_{shared_.end()}
+{
+}
+
+NetworkPool::~NetworkPool()
+{
+    for (auto* const workers : {&shared_, &dedicated_})
+    {
+        for (auto& worker : *workers)
+        {
+            worker.io_context.stop();
+        }
+    }
+    for (auto* const workers : {&shared_, &dedicated_})
+    {
+        for (auto& worker : *workers)
+        {
+            worker.thread.join();
+        }
+    }
+}
+
+auto NetworkPool::reap() -> void
+{
+    std::erase_if(dedicated_, [](Worker& worker) {
+        if (not worker.io_context.stopped())
+        {
+            return false;
+        }
+        worker.thread.join();
+        return true;
+    });
+}
+
+auto NetworkPool::acquire() -> boost::asio::io_context&
+{
+    reap();
+
+    if (shared_.size() < max_threads_)
+    {
+        auto& worker = shared_.emplace_back();
+        worker.work.emplace(worker.io_context.get_executor());
+        worker.thread = std::thread{[&io_context = worker.io_context] { io_context.run(); }};
+        return worker.io_context;
+    }
+
+    if (next_ == shared_.end())
+    {
+        next_ = shared_.begin();
+    }
+    return (next_++)->io_context;
+}
+
+auto NetworkPool::dedicated() -> Work
+{
+    reap();
+
+    auto& worker = dedicated_.emplace_back();
+    Work work{worker.io_context.get_executor()};
+    worker.thread = std::thread{[&io_context = worker.io_context] { io_context.run(); }};
+    return work;
+}
@@ -0,0 +1,90 @@
+#pragma once
+/**
+ * @file networkpool.hpp
+ * @author Eric Mertens <emertens@gmail.com>
+ * @brief Threads running network connections off the main thread
+ *
+ */
+
+#include <boost/asio.hpp>
+
+#include <cstddef>
+#include <list>
+#include <optional>
+#include <thread>
+
+/**
+ * @brief Pool of IO contexts each run by its own thread
+ *
+ * Shared threads are started by acquire until the pool reaches its size
+ * limit, so the first connections each get a thread of their own and
+ * later ones share them round-robin. Dedicated threads serve a single
+ * connection and exit when it's done.
+ */
+class NetworkPool
+{
+public:
+    /// @brief Work keeping a dedicated thread running
+    using Work = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+private:
+    struct Worker
+    {
+        boost::asio::io_context io_context;
+        /// Keeps a shared worker running while it has nothing to do
+        std::optional<Work> work;
+        std::thread thread;
+    };
+
+    /// @brief Running shared workers; a list keeps their addresses stable
+    std::list<Worker> shared_;
+
+    /// @brief Dedicated workers, including finished ones not yet joined
+    std::list<Worker> dedicated_;
+
+    /// @brief Largest number of shared threads
+    std::size_t max_threads_;
+
+    /// @brief Worker used by the next acquire once the pool is full
+    std::list<Worker>::iterator next_;
+
+    /// @brief Join and remove dedicated workers whose work is done
+    auto reap() -> void;
+
+public:
+    /**
+     * @brief Construct an empty pool
+     *
+     * @param max_threads Largest number of shared threads to start
+     */
+    explicit NetworkPool(std::size_t max_threads);
+
+    NetworkPool(NetworkPool const&) = delete;
+    auto operator=(NetworkPool const&) -> NetworkPool& = delete;
+
+    /// @brief Stop every IO context, join the threads, and destroy pending work
+    ~NetworkPool();
+
+    /**
+     * @brief Choose a shared IO context for a new connection
+     *
+     * @return IO context run by a pool thread
+     */
+    auto acquire() -> boost::asio::io_context&;
+
+    /**
+     * @brief Start a thread serving a single connection
+     *
+     * The thread keeps running while the returned work is held and
+     * exits once it is released and the IO context runs out of work.
+     *
+     * @return Work on the new thread's IO context
+     */
+    auto dedicated() -> Work;
+
+    /// @brief Number of shared threads started
+    auto size() const -> std::size_t
+    {
+        return shared_.size();
+    }
+};
@@ -0,0 +1,183 @@
+#pragma once
+/**
+ * @file replaystream.hpp
+ * @author Eric Mertens <emertens@gmail.com>
+ * @brief Stream reading captured IRC traffic in place of a socket
+ */
+
+#include "capture.hpp"
+
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+
+/**
+ * @brief Stream replaying a capture file
+ *
+ * Reads deliver the captured lines either as fast as they are consumed
+ * or paced by the recorded timestamps scaled by a speed factor. Writes
+ * are discarded. Every operation completes through the executor so a
+ * fast replay still lets other work on the IO context run between reads.
+ */
+class ReplayStream
+{
+public:
+    using tcp_socket = boost::asio::ip::tcp::socket;
+    using clock = std::chrono::steady_clock;
+
+private:
+    CaptureReader reader_;
+
+    /// @brief Playback rate relative to the recording; non-positive is unpaced
+    double speed_;
+
+    /// @brief Time the replay started
+    clock::time_point start_;
+
+    /// @brief Timer pacing reads
+    boost::asio::steady_timer timer_;
+
+    /// @brief Unconnected socket standing in as the lowest layer
+    tcp_socket socket_;
+
+    /// @brief True once close() has been called
+    bool closed_;
+
+    /// @brief Time the next record is due
+    auto due() const -> clock::time_point
+    {
+        auto const next = reader_.next_time();
+        if (speed_ <= 0 || not next)
+        {
+            return clock::time_point::min();
+        }
+        return start_ + std::chrono::duration_cast<clock::duration>(*next / speed_);
+    }
+
+    /// @brief Latest record time that can be delivered now
+    auto until() const -> CaptureReader::duration
+    {
+        auto const next = reader_.next_time();
+        if (speed_ <= 0 || not next)
+        {
+            return CaptureReader::duration::max();
+        }
+        auto const elapsed = std::chrono::duration_cast<CaptureReader::duration>((clock::now() - start_) * speed_);
+        return std::max(elapsed, *next);
+    }
+
+public:
+    /**
+     * @brief Construct a replay stream
+     *
+     * @param executor Executor of the stream's operations
+     * @param reader Source of captured records
+     * @param speed Playback rate relative to the recording, non-positive for as fast as possible
+     */
+    ReplayStream(boost::asio::any_io_executor const& executor, CaptureReader reader, double const speed)
+        : reader_{std::move(reader)}
+        , speed_{speed}
+        , start_{clock::now()}
+        , timer_{executor}
+        , socket_{executor}
+        , closed_{false}
+    {
+    }
+
+    auto lowest_layer() -> tcp_socket::lowest_layer_type&
+    {
+        return socket_.lowest_layer();
+    }
+
+    auto lowest_layer() const -> tcp_socket::lowest_layer_type const&
+    {
+        return socket_.lowest_layer();
+    }
+
+    /**
+     * @brief Read the next captured bytes
+     *
+     * Completes with boost::asio::error::eof at the end of the capture
+     * and with bad_message when a later record is malformed.
+     */
+    template <
+        typename MutableBufferSequence,
+        boost::asio::completion_token_for<void(boost::system::error_code, std::size_t)> Token>
+    auto async_read_some(MutableBufferSequence const& buffers, Token&& token) -> decltype(auto)
+    {
+        boost::asio::mutable_buffer const target = *boost::asio::buffer_sequence_begin(buffers);
+        return boost::asio::async_compose<Token, void(boost::system::error_code, std::size_t)>(
+            [this, target, waited = false](auto& self, boost::system::error_code const error = {}) mutable {
+                if (not waited)
+                {
+                    waited = true;
+                    timer_.expires_at(due());
+                    timer_.async_wait(std::move(self));
+                    return;
+                }
+
+                if (closed_)
+                {
+                    self.complete(boost::asio::error::operation_aborted, 0);
+                }
+                else if (error)
+                {
+                    self.complete(error, 0);
+                }
+                else if (not reader_.next_time())
+                {
+                    self.complete(boost::asio::error::eof, 0);
+                }
+                else
+                {
+                    auto const out = std::span{static_cast<char*>(target.data()), target.size()};
+                    std::size_t n;
+                    try
+                    {
+                        n = reader_.read(out, until());
+                    }
+                    catch (std::runtime_error const&)
+                    {
+                        self.complete(make_error_code(boost::system::errc::bad_message), 0);
+                        return;
+                    }
+                    self.complete({}, n);
+                }
+            },
+            token, timer_
+        );
+    }
+
+    /**
+     * @brief Discard bytes written to the stream
+     */
+    template <
+        typename ConstBufferSequence,
+        boost::asio::completion_token_for<void(boost::system::error_code, std::size_t)> Token>
+    auto async_write_some(ConstBufferSequence const& buffers, Token&& token) -> decltype(auto)
+    {
+        return boost::asio::async_compose<Token, void(boost::system::error_code, std::size_t)>(
+            [n = boost::asio::buffer_size(buffers), posted = false](auto& self) mutable {
+                if (not posted)
+                {
+                    posted = true;
+                    boost::asio::post(std::move(self));
+                    return;
+                }
+                self.complete({}, n);
+            },
+            token, timer_
+        );
+    }
+
+    /// @brief Stop the replay and abort the pending read
+    auto close() -> void
+    {
+        closed_ = true;
+        timer_.cancel();
+    }
+};
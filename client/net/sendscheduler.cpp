@@ -0,0 +1,150 @@
+#include "sendscheduler.hpp"
+
+#include <algorithm>
+
+namespace {
+
+/// @brief Command sent outside the normal lane
+struct CommandLane
+{
+    std::string_view command;
+    Lane lane;
+};
+
+CommandLane const command_lanes[]{
+    {"PONG", Lane::Urgent},
+    {"LINKS", Lane::Bulk},
+    {"LIST", Lane::Bulk},
+    {"MAP", Lane::Bulk},
+    {"STATS", Lane::Bulk},
+    {"TESTLINE", Lane::Bulk},
+    {"TESTMASK", Lane::Bulk},
+    {"VERSION", Lane::Bulk},
+    {"WHO", Lane::Bulk},
+};
+
+auto ascii_toupper(char const c) -> char
+{
+    return 'a' <= c && c <= 'z' ? c - 'a' + 'A' : c;
+}
+
+} // namespace
+
+auto message_lane(std::string_view msg) -> Lane
+{
+    auto const next_word = [&msg] {
+        msg.remove_prefix(std::min(msg.find_first_not_of(' '), msg.size()));
+        auto const word = msg.substr(0, msg.find_first_of(" \r\n"));
+        msg.remove_prefix(word.size());
+        return word;
+    };
+
+    auto word = next_word();
+    if (word.starts_with('@'))
+    {
+        word = next_word();
+    }
+    if (word.starts_with(':'))
+    {
+        word = next_word();
+    }
+
+    for (auto const& [command, lane] : command_lanes)
+    {
+        if (std::ranges::equal(word, command, {}, ascii_toupper))
+        {
+            return lane;
+        }
+    }
+    return Lane::Normal;
+}
+
+SendScheduler::SendScheduler()
+    : queued_bytes_{0}
+    , burst_{0}
+    , rate_{0}
+    , tokens_{0}
+    , last_refill_{}
+{
+}
+
+auto SendScheduler::configure(double const burst, double const rate, clock::time_point const now) -> void
+{
+    burst_ = std::max(1.0, burst);
+    rate_ = rate;
+    tokens_ = burst_;
+    last_refill_ = now;
+}
+
+auto SendScheduler::refill(clock::time_point const now) -> void
+{
+    if (now > last_refill_)
+    {
+        std::chrono::duration<double> const elapsed = now - last_refill_;
+        tokens_ = std::min(burst_, tokens_ + elapsed.count() * rate_);
+        last_refill_ = now;
+    }
+}
+
+auto SendScheduler::push(Lane const lane, std::string_view const msg) -> void
+{
+    auto const i = static_cast<std::size_t>(lane);
+    lanes_[i].emplace_back(msg);
+    queued_bytes_ += msg.size();
+    auto& stats = stats_[i];
+    stats.depth++;
+    stats.peak = std::max(stats.peak, stats.depth);
+}
+
+auto SendScheduler::pop(clock::time_point const now) -> std::optional<std::string>
+{
+    if (not unpaced())
+    {
+        refill(now);
+        if (tokens_ < 1)
+        {
+            return std::nullopt;
+        }
+    }
+
+    for (std::size_t i = 0; i < lane_count; i++)
+    {
+        auto& lane = lanes_[i];
+        if (not lane.empty())
+        {
+            auto msg = std::move(lane.front());
+            lane.pop_front();
+            queued_bytes_ -= msg.size();
+            stats_[i].depth--;
+            stats_[i].sent++;
+            if (not unpaced())
+            {
+                tokens_ -= 1;
+            }
+            return msg;
+        }
+    }
+    return std::nullopt;
+}
+
+auto SendScheduler::delay(clock::time_point const now) -> clock::duration
+{
+    if (unpaced() || empty())
+    {
+        return clock::duration::zero();
+    }
+
+    refill(now);
+    if (tokens_ >= 1)
+    {
+        return clock::duration::zero();
+    }
+
+    std::chrono::duration<double> const wait{(1 - tokens_) / rate_};
+    return std::chrono::ceil<clock::duration>(wait);
+}
+
+auto SendScheduler::empty() const -> bool
+{
+    return std::ranges::all_of(lanes_, [](auto const& lane) { return lane.empty(); });
+}
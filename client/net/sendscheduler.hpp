@@ -0,0 +1,143 @@
+#pragma once
+/**
+ * @file sendscheduler.hpp
+ * @author Eric Mertens <emertens@gmail.com>
+ * @brief Token-bucket pacing of outgoing messages
+ *
+ */
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Priority class of an outgoing message
+ *
+ * Lanes are drained in declaration order.
+ */
+enum class Lane
+{
+    /// Protocol replies like PONG that keep the connection alive
+    Urgent,
+    /// Interactive commands and oper actions
+    Normal,
+    /// Bulk queries that can wait, like TESTMASK and STATS
+    Bulk,
+};
+
+/// @brief Number of lanes in a SendScheduler
+inline constexpr std::size_t lane_count = 3;
+
+/**
+ * @brief Default lane of an outgoing message chosen by its command
+ *
+ * PONG is urgent, server queries like STATS and TESTMASK are bulk, and
+ * every other command is normal.
+ *
+ * @param msg Message with optional tags and source
+ * @return Lane for the message's command
+ */
+auto message_lane(std::string_view msg) -> Lane;
+
+/// @brief Counters for one lane of a SendScheduler
+struct LaneStats
+{
+    /// Messages waiting in the lane
+    std::size_t depth;
+    /// Largest depth the lane has reached
+    std::size_t peak;
+    /// Messages released from the lane
+    std::size_t sent;
+};
+
+/**
+ * @brief Priority queue of messages released by a token bucket
+ *
+ * Each released message costs one token. The bucket holds at most
+ * burst tokens and refills at rate tokens per second. A scheduler
+ * with a non-positive rate is unpaced and releases everything
+ * immediately.
+ */
+class SendScheduler
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+private:
+    std::array<std::deque<std::string>, lane_count> lanes_;
+    std::array<LaneStats, lane_count> stats_ {};
+
+    /// Bytes of all queued messages
+    std::size_t queued_bytes_;
+
+    double burst_;
+    double rate_;
+    double tokens_;
+    clock::time_point last_refill_;
+
+    /// @brief Add the tokens accumulated since the last refill
+    auto refill(clock::time_point now) -> void;
+
+public:
+    SendScheduler();
+
+    /**
+     * @brief Change the pacing parameters
+     *
+     * The bucket starts full after reconfiguration.
+     *
+     * @param burst Largest number of messages released back-to-back
+     * @param rate Tokens added per second; non-positive disables pacing
+     * @param now Current time
+     */
+    auto configure(double burst, double rate, clock::time_point now) -> void;
+
+    /**
+     * @brief Queue a message
+     *
+     * @param lane Priority of the message
+     * @param msg Message including line terminator
+     */
+    auto push(Lane lane, std::string_view msg) -> void;
+
+    /**
+     * @brief Release the highest priority message if a token is available
+     *
+     * @param now Current time
+     * @return Released message
+     */
+    auto pop(clock::time_point now) -> std::optional<std::string>;
+
+    /**
+     * @brief Time until the next queued message can be released
+     *
+     * @param now Current time
+     * @return Zero when a message is ready or nothing is queued
+     */
+    auto delay(clock::time_point now) -> clock::duration;
+
+    /// @brief True when no messages are queued
+    auto empty() const -> bool;
+
+    /// @brief Bytes of all queued messages
+    auto queued_bytes() const -> std::size_t
+    {
+        return queued_bytes_;
+    }
+
+    /// @brief True when messages are released without pacing
+    auto unpaced() const -> bool
+    {
+        return rate_ <= 0;
+    }
+
+    /// @brief Get the counters for a lane
+    auto lane_stats(Lane const lane) const -> LaneStats const&
+    {
+        return stats_[static_cast<std::size_t>(lane)];
+    }
+};
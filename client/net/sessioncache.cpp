@@ -0,0 +1,203 @@
+#include "sessioncache.hpp"
+
+#include <openssl/evp.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+/// @brief True when a session can still be offered to the server
+auto usable(SSL_SESSION* const session) -> bool
+{
+    return SSL_SESSION_is_resumable(session)
+        && std::time(nullptr) < SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session);
+}
+
+auto hex_digit(char const c) -> int
+{
+    if ('0' <= c && c <= '9') return c - '0';
+    if ('a' <= c && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/// @brief Decode a session from its hex DER encoding
+auto decode(std::string_view const hex) -> TlsSessionCache::Session
+{
+    if (hex.size() % 2 != 0)
+    {
+        return nullptr;
+    }
+
+    std::vector<unsigned char> der;
+    der.reserve(hex.size() / 2);
+    for (std::size_t i = 0; i < hex.size(); i += 2)
+    {
+        auto const hi = hex_digit(hex[i]);
+        auto const lo = hex_digit(hex[i + 1]);
+        if (hi < 0 || lo < 0)
+        {
+            return nullptr;
+        }
+        der.push_back(hi << 4 | lo);
+    }
+
+    unsigned char const* cursor = der.data();
+    return TlsSessionCache::Session{d2i_SSL_SESSION(nullptr, &cursor, der.size())};
+}
+
+/// @brief Write all of a buffer to a file descriptor
+auto write_all(int const fd, std::string_view text) -> bool
+{
+    while (not text.empty())
+    {
+        auto const n = ::write(fd, text.data(), text.size());
+        if (n < 0)
+        {
+            return false;
+        }
+        text.remove_prefix(n);
+    }
+    return true;
+}
+
+} // namespace
+
+TlsSessionCache::TlsSessionCache(std::string path)
+    : path_{std::move(path)}
+{
+    if (path_.empty())
+    {
+        return;
+    }
+
+    std::ifstream in{path_};
+    for (std::string line; std::getline(in, line);)
+    {
+        auto const space = line.find(' ');
+        if (space == line.npos)
+        {
+            continue;
+        }
+        if (auto session = decode(std::string_view{line}.substr(space + 1)); session && usable(session.get()))
+        {
+            sessions_.insert_or_assign(line.substr(0, space), std::move(session));
+        }
+    }
+}
+
+auto TlsSessionCache::make_key(
+    std::string_view const host,
+    std::uint16_t const port,
+    std::string_view const sni,
+    std::string_view const verify,
+    X509* const client_cert
+) -> std::string
+{
+    // Sessions from unverified connections must not resume verified ones
+    std::ostringstream os;
+    os << host << ':' << port << '/' << sni << "/verify=" << verify << '/';
+    if (client_cert)
+    {
+        unsigned char md[EVP_MAX_MD_SIZE];
+        unsigned int md_len = 0;
+        X509_digest(client_cert, EVP_sha256(), md, &md_len);
+        os << std::hex << std::setfill('0');
+        for (unsigned i = 0; i < md_len; i++)
+        {
+            os << std::setw(2) << int{md[i]};
+        }
+    }
+    return os.str();
+}
+
+auto TlsSessionCache::get(std::string_view const key) -> Session
+{
+    std::lock_guard const lock{mutex_};
+
+    auto const it = sessions_.find(key);
+    if (it == sessions_.end())
+    {
+        return nullptr;
+    }
+    if (not usable(it->second.get()))
+    {
+        sessions_.erase(it);
+        return nullptr;
+    }
+
+    SSL_SESSION_up_ref(it->second.get());
+    return Session{it->second.get()};
+}
+
+auto TlsSessionCache::put(std::string key, Session session) -> void
+{
+    if (not session || not usable(session.get()))
+    {
+        return;
+    }
+
+    std::lock_guard const lock{mutex_};
+    sessions_.insert_or_assign(std::move(key), std::move(session));
+    save();
+}
+
+auto TlsSessionCache::size() const -> std::size_t
+{
+    std::lock_guard const lock{mutex_};
+    return sessions_.size();
+}
+
+auto TlsSessionCache::save() const -> void
+{
+    if (path_.empty())
+    {
+        return;
+    }
+
+    std::ostringstream out;
+    out << std::hex << std::setfill('0');
+    for (auto const& [key, session] : sessions_)
+    {
+        auto const len = i2d_SSL_SESSION(session.get(), nullptr);
+        if (len <= 0)
+        {
+            continue;
+        }
+        std::vector<unsigned char> der(len);
+        auto cursor = der.data();
+        i2d_SSL_SESSION(session.get(), &cursor);
+
+        out << key << ' ';
+        for (auto const byte : der)
+        {
+            out << std::setw(2) << int{byte};
+        }
+        out << '\n';
+    }
+
+    // Write a new file and rename it over the old one so readers never
+    // see a partial file. mkstemp creates the file with an unpredictable
+    // name that only the owner can open, so the secrets are never
+    // readable by others. A cache that can't be saved is still usable in
+    // memory, so failures are ignored.
+    auto temp = path_ + ".XXXXXX";
+    auto const fd = mkstemp(temp.data());
+    if (fd < 0)
+    {
+        return;
+    }
+
+    auto const written = write_all(fd, std::move(out).str());
+    if (0 != ::close(fd) || not written || 0 != std::rename(temp.c_str(), path_.c_str()))
+    {
+        ::unlink(temp.c_str());
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+/**
+ * @file sessioncache.hpp
+ * @author Eric Mertens <emertens@gmail.com>
+ * @brief TLS sessions kept for resumption on reconnect
+ *
+ * A session file holds one session per line:
+ *
+ *     KEY HEX
+ *
+ * where KEY identifies the server, how it was verified, and the client
+ * identity, and HEX is the DER encoding of the session. The file grants
+ * access to the sessions and is only readable by its owner.
+ */
+
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Thread-safe cache of resumable TLS client sessions
+ */
+class TlsSessionCache
+{
+public:
+    struct SessionDeleter
+    {
+        auto operator()(SSL_SESSION* const session) const -> void { SSL_SESSION_free(session); }
+    };
+    using Session = std::unique_ptr<SSL_SESSION, SessionDeleter>;
+
+private:
+    mutable std::mutex mutex_;
+    std::map<std::string, Session, std::less<>> sessions_;
+
+    /// @brief File the sessions are saved to; empty to keep them in memory
+    std::string path_;
+
+    /// @brief Rewrite the session file; called with mutex_ held
+    auto save() const -> void;
+
+public:
+    /**
+     * @brief Construct a cache, loading any sessions saved at path
+     *
+     * Missing files, malformed lines, and expired sessions are skipped.
+     *
+     * @param path Session file; empty to keep sessions only in memory
+     */
+    explicit TlsSessionCache(std::string path = {});
+
+    /**
+     * @brief Build the cache key of a connection
+     *
+     * @param host IRC server hostname
+     * @param port IRC server port
+     * @param sni Hostname sent for TLS SNI
+     * @param verify Hostname the server certificate is verified against; empty when unverified
+     * @param client_cert Client certificate, if any
+     * @return Key distinguishing the server, how it was verified, and the identity presented to it
+     */
+    static auto make_key(
+        std::string_view host, std::uint16_t port, std::string_view sni, std::string_view verify, X509* client_cert
+    ) -> std::string;
+
+    /**
+     * @brief Find a resumable session
+     *
+     * @param key Connection key
+     * @return New reference to the session or nullptr when none is usable
+     */
+    auto get(std::string_view key) -> Session;
+
+    /**
+     * @brief Remember the latest session for a key, replacing any older one
+     *
+     * @param key Connection key
+     * @param session Session to store; the reference is taken over
+     */
+    auto put(std::string key, Session session) -> void;
+
+    /// @brief Number of cached sessions
+    auto size() const -> std::size_t;
+};
@@ -1,12 +1,15 @@
 #pragma once
 
+#include "ktlsstream.hpp"
+#include "replaystream.hpp"
+
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 
 #include <cstddef>
 #include <variant>
 
-/// @brief Abstraction over plain-text and TLS streams.
+/// @brief Abstraction over plain-text, TLS, kernel TLS, and replayed streams.
 class Stream
 {
 public:
@@ -21,7 +24,7 @@ public:
 
 private:
     /// @brief The underlying stream object
-    std::variant<tcp_socket, tls_stream> base;
+    std::variant<tcp_socket, tls_stream, KtlsStream, ReplayStream> base;
 
 public:
 
@@ -48,6 +51,25 @@ public:
         return base.emplace<tls_stream>(std::move(socket), ctx);
     }
 
+    /// @brief Upgrade a plain TCP socket into a TLS stream eligible for kernel offload.
+    /// @param ctx TLS context used for handshake
+    /// @return Reference to internal stream object
+    auto upgrade_ktls(boost::asio::ssl::context& ctx) -> KtlsStream&
+    {
+        auto socket = std::move(std::get<tcp_socket>(base));
+        return base.emplace<KtlsStream>(std::move(socket), ctx);
+    }
+
+    /// @brief Replace the stream with a replay of captured traffic
+    /// @param reader Source of captured records
+    /// @param speed Playback rate relative to the recording, non-positive for as fast as possible
+    /// @return Reference to internal stream object
+    auto replay(CaptureReader reader, double const speed) -> ReplayStream&
+    {
+        auto const executor = get_executor(); // copied before the old stream is destroyed
+        return base.emplace<ReplayStream>(executor, std::move(reader), speed);
+    }
+
     /// @brief Get underlying basic socket
     /// @return Reference to underlying socket
     auto lowest_layer() -> lowest_layer_type&
@@ -104,6 +126,11 @@ public:
     /// @brief Tear down the network stream
     auto close() -> void
     {
+        if (auto const replay = std::get_if<ReplayStream>(&base))
+        {
+            replay->close();
+        }
+
         boost::system::error_code err;
         auto& socket = lowest_layer();
         socket.shutdown(socket.shutdown_both, err);
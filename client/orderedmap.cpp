@@ -0,0 +1,542 @@
+#include "orderedmap.hpp"
+
+#include "irccase.hpp"
+#include "strings.hpp"
+#include "userdata.hpp"
+
+extern "C" {
+#include <lauxlib.h>
+#include <lua.h>
+}
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+/// @brief Key stored outside of Lua: nil, boolean, or string
+struct Key
+{
+    int type = LUA_TNIL;
+    std::string bytes;
+
+    auto operator==(Key const&) const -> bool = default;
+};
+
+auto hash_key(Key const& key) -> std::size_t
+{
+    return std::hash<std::string_view>{}(key.bytes) ^ static_cast<std::size_t>(key.type);
+}
+
+/// @brief Ring buffer of normalized keys with an open-addressing index
+///
+/// Values and the keys as given are kept by Lua in preallocated arrays
+/// in uservalues, at the position matching the entry's slot, so only
+/// the normalized key is copied out of Lua.
+class OrderedMap
+{
+    struct Slot
+    {
+        /// Normalized key
+        Key key;
+        std::size_t hash;
+    };
+
+    std::vector<Slot> slots_;
+    /// slot + 1 of each indexed entry, 0 for empty buckets
+    std::vector<std::uint32_t> buckets_;
+    std::size_t n_;
+    lua_Integer ticker_;
+
+    auto mask() const -> std::size_t { return buckets_.size() - 1; }
+
+    /// @brief Find the bucket holding key or the empty bucket ending its probe sequence
+    auto probe(Key const& key, std::size_t const hash) const -> std::size_t
+    {
+        auto b = hash & mask();
+        while (0 != buckets_[b])
+        {
+            auto const& slot = slots_[buckets_[b] - 1];
+            if (slot.hash == hash && slot.key == key)
+            {
+                break;
+            }
+            b = (b + 1) & mask();
+        }
+        return b;
+    }
+
+    /// @brief Remove a bucket shifting later entries back to close the gap
+    auto erase_bucket(std::size_t hole) -> void
+    {
+        buckets_[hole] = 0;
+        for (auto b = (hole + 1) & mask(); 0 != buckets_[b]; b = (b + 1) & mask())
+        {
+            auto const home = slots_[buckets_[b] - 1].hash & mask();
+            if (((b - home) & mask()) >= ((b - hole) & mask()))
+            {
+                buckets_[hole] = buckets_[b];
+                buckets_[b] = 0;
+                hole = b;
+            }
+        }
+    }
+
+    /// @brief Point the slot's normalized key at the slot
+    auto index(std::size_t const i) -> void
+    {
+        auto const& slot = slots_[i];
+        if (LUA_TNIL != slot.key.type)
+        {
+            buckets_[probe(slot.key, slot.hash)] = i + 1;
+        }
+    }
+
+    /// @brief Remove the slot from the index if its key points at it
+    auto unindex(std::size_t const i) -> void
+    {
+        auto const& slot = slots_[i];
+        if (LUA_TNIL != slot.key.type)
+        {
+            auto const b = probe(slot.key, slot.hash);
+            if (buckets_[b] == i + 1)
+            {
+                erase_bucket(b);
+            }
+        }
+    }
+
+public:
+    explicit OrderedMap(std::size_t const max)
+        : slots_(max)
+        , buckets_(std::bit_ceil(2 * max))
+        , n_{0}
+        , ticker_{0}
+    {
+    }
+
+    auto max() const -> std::size_t { return slots_.size(); }
+    auto n() const -> std::size_t { return n_; }
+    auto ticker() const -> lua_Integer { return ticker_; }
+    auto tick() -> void { ticker_++; }
+
+    /// @brief Find the slot of the newest entry with the normalized key
+    auto find(Key const& norm) const -> std::optional<std::size_t>
+    {
+        if (LUA_TNIL == norm.type)
+        {
+            return std::nullopt;
+        }
+        auto const b = probe(norm, hash_key(norm));
+        if (0 == buckets_[b])
+        {
+            return std::nullopt;
+        }
+        return buckets_[b] - 1;
+    }
+
+    /// @brief Claim the next slot in the ring, evicting its old entry
+    /// @return Slot now holding the key
+    auto insert(Key norm) -> std::size_t
+    {
+        auto const i = n_ % max();
+        n_++;
+        rekey(i, std::move(norm));
+        return i;
+    }
+
+    auto rekey(std::size_t const i, Key norm) -> void
+    {
+        unindex(i);
+        auto& slot = slots_[i];
+        slot.hash = hash_key(norm);
+        slot.key = std::move(norm);
+        index(i);
+    }
+
+    auto reset() -> void
+    {
+        std::fill(slots_.begin(), slots_.end(), Slot{});
+        std::fill(buckets_.begin(), buckets_.end(), 0);
+        n_ = 0;
+        ticker_ = 0;
+    }
+};
+
+/// Uservalue holding the array of values
+constexpr int values_uv = 1;
+/// Uservalue holding the table of assigned fields
+constexpr int fields_uv = 2;
+/// Uservalue holding the key function called through Lua
+constexpr int keyfn_uv = 3;
+/// Uservalue holding the array of keys as given
+constexpr int keys_uv = 4;
+
+/// Uservalue 3 marker for keys normalized natively with irccase
+char irccase_marker;
+
+auto is_key_type(int const type) -> bool
+{
+    return LUA_TNIL == type || LUA_TBOOLEAN == type || LUA_TSTRING == type;
+}
+
+/// @brief Raise an argument error unless arg is a nil, boolean, or string key
+auto check_key(lua_State* const L, int const arg) -> void
+{
+    luaL_argexpected(L, is_key_type(lua_type(L, arg)), arg, "nil, boolean, or string");
+}
+
+/// @brief Copy a key that has already been checked
+auto to_key(lua_State* const L, int const idx) -> Key
+{
+    switch (lua_type(L, idx))
+    {
+    case LUA_TBOOLEAN:
+        return {LUA_TBOOLEAN, lua_toboolean(L, idx) ? "t" : "f"};
+    case LUA_TSTRING:
+        return {LUA_TSTRING, std::string{check_string_view(L, idx)}};
+    default:
+        return {};
+    }
+}
+
+/// @brief Compute the form of the checked key at idx used by the index
+///
+/// Maps without a key function index keys as they are. The result is
+/// only built after the key function returns, as an error would skip
+/// its destructor.
+auto normalize(lua_State* const L, int const map, int const idx) -> Key
+{
+    if (lua_isnil(L, idx))
+    {
+        return {};
+    }
+
+    switch (lua_getiuservalue(L, map, keyfn_uv))
+    {
+    case LUA_TLIGHTUSERDATA:
+        lua_pop(L, 1);
+        if (LUA_TSTRING == lua_type(L, idx))
+        {
+            auto const str = check_string_view(L, idx);
+            Key key{LUA_TSTRING, std::string(str.size(), '\0')};
+            irccase(str, key.bytes.data());
+            return key;
+        }
+        luaL_error(L, "irccase keys must be strings");
+        return {};
+
+    case LUA_TNIL:
+        lua_pop(L, 1);
+        return to_key(L, idx);
+
+    default:
+    {
+        lua_pushvalue(L, idx);
+        lua_call(L, 1, 1);
+        if (not is_key_type(lua_type(L, -1)))
+        {
+            luaL_error(L, "key function must return nil, boolean, or string");
+        }
+        auto key = to_key(L, -1);
+        lua_pop(L, 1);
+        return key;
+    }
+    }
+}
+
+auto check_map(lua_State* const L) -> OrderedMap*
+{
+    return check_udata<OrderedMap>(L, 1);
+}
+
+/// @brief Push the element of an array uservalue at a 0-based slot
+auto push_slot(lua_State* const L, int const map, int const uv, std::size_t const i) -> void
+{
+    lua_getiuservalue(L, map, uv);
+    lua_rawgeti(L, -1, lua_Integer(i) + 1);
+    lua_remove(L, -2);
+}
+
+/// @brief Store the value on top of the stack in an array uservalue at a 0-based slot
+auto set_slot(lua_State* const L, int const map, int const uv, std::size_t const i) -> void
+{
+    lua_getiuservalue(L, map, uv);
+    lua_insert(L, -2);
+    lua_rawseti(L, -2, lua_Integer(i) + 1);
+    lua_pop(L, 1);
+}
+
+/// @brief Push the value stored in a 0-based slot
+auto push_value(lua_State* const L, int const map, std::size_t const i) -> void
+{
+    push_slot(L, map, values_uv, i);
+}
+
+/// @brief Push the value and key stored in a 0-based slot
+auto push_entry(lua_State* const L, int const map, std::size_t const i) -> int
+{
+    push_value(L, map, i);
+    push_slot(L, map, keys_uv, i);
+    return 2;
+}
+
+auto l_insert(lua_State* const L) -> int
+{
+    auto const m = check_map(L);
+    check_key(L, 2);
+    lua_settop(L, 3);
+
+    auto const i = m->insert(normalize(L, 1, 2));
+
+    lua_pushvalue(L, 3);
+    set_slot(L, 1, values_uv, i);
+    lua_pushvalue(L, 2);
+    set_slot(L, 1, keys_uv, i);
+
+    lua_getiuservalue(L, 1, fields_uv);
+    if (LUA_TNIL == lua_getfield(L, -1, "predicate"))
+    {
+        m->tick();
+    }
+    else
+    {
+        lua_pushvalue(L, 3);
+        lua_call(L, 1, 1);
+        if (lua_toboolean(L, -1))
+        {
+            m->tick();
+        }
+    }
+    return 0;
+}
+
+auto l_lookup(lua_State* const L) -> int
+{
+    auto const m = check_map(L);
+    check_key(L, 2);
+    lua_settop(L, 2);
+
+    if (auto const i = m->find(normalize(L, 1, 2)))
+    {
+        push_value(L, 1, *i);
+    }
+    else
+    {
+        lua_pushnil(L);
+    }
+    return 1;
+}
+
+auto l_rekey(lua_State* const L) -> int
+{
+    auto const m = check_map(L);
+    check_key(L, 2);
+    check_key(L, 3);
+    lua_settop(L, 3);
+
+    if (auto const i = m->find(normalize(L, 1, 2)))
+    {
+        m->rekey(*i, normalize(L, 1, 3));
+        lua_pushvalue(L, 3);
+        set_slot(L, 1, keys_uv, *i);
+    }
+    return 0;
+}
+
+/// @brief Iterator over entries newest first
+/// upvalues: map, entries visited, insertion count when iteration started
+auto each_next(lua_State* const L) -> int
+{
+    auto const m = check_udata<OrderedMap>(L, lua_upvalueindex(1));
+    auto i = lua_Unsigned(lua_tointeger(L, lua_upvalueindex(2)));
+    auto const n = lua_Unsigned(lua_tointeger(L, lua_upvalueindex(3)));
+    auto const max = lua_Unsigned(m->max());
+
+    if (i >= std::min(n, max))
+    {
+        return 0;
+    }
+
+    i++;
+    lua_pushinteger(L, i);
+    lua_replace(L, lua_upvalueindex(2));
+    return push_entry(L, lua_upvalueindex(1), (n - i) % max);
+}
+
+/// @brief Iterator over entries oldest first
+/// upvalues: map, entries visited, insertion count when iteration started
+auto reveach_next(lua_State* const L) -> int
+{
+    auto const m = check_udata<OrderedMap>(L, lua_upvalueindex(1));
+    auto const i = lua_Unsigned(lua_tointeger(L, lua_upvalueindex(2)));
+    auto const n = lua_Unsigned(lua_tointeger(L, lua_upvalueindex(3)));
+    auto const t = std::min(n, lua_Unsigned(m->max()));
+
+    if (i >= t)
+    {
+        return 0;
+    }
+
+    lua_pushinteger(L, i + 1);
+    lua_replace(L, lua_upvalueindex(2));
+    return push_entry(L, lua_upvalueindex(1), (n + i) % t);
+}
+
+auto push_iterator(lua_State* const L, lua_CFunction const next, lua_Integer const offset) -> int
+{
+    auto const m = check_map(L);
+    lua_settop(L, 1);
+    lua_pushinteger(L, offset);
+    lua_pushinteger(L, m->n());
+    lua_pushcclosure(L, next, 3);
+    return 1;
+}
+
+auto l_each(lua_State* const L) -> int
+{
+    return push_iterator(L, each_next, std::max(lua_Integer{0}, luaL_optinteger(L, 2, 0)));
+}
+
+auto l_reveach(lua_State* const L) -> int
+{
+    return push_iterator(L, reveach_next, 0);
+}
+
+auto l_get_oldest(lua_State* const L) -> int
+{
+    auto const m = check_map(L);
+    push_value(L, 1, m->n() <= m->max() ? 0 : m->n() % m->max());
+    return 1;
+}
+
+auto l_reset(lua_State* const L) -> int
+{
+    auto const m = check_map(L);
+    m->reset();
+    lua_createtable(L, m->max(), 0);
+    lua_setiuservalue(L, 1, values_uv);
+    lua_createtable(L, m->max(), 0);
+    lua_setiuservalue(L, 1, keys_uv);
+    return 0;
+}
+
+luaL_Reg const Methods[]{
+    {"insert", l_insert},
+    {"lookup", l_lookup},
+    {"rekey", l_rekey},
+    {"each", l_each},
+    {"reveach", l_reveach},
+    {"get_oldest", l_get_oldest},
+    {"reset", l_reset},
+    {}
+};
+
+/// upvalue 1: methods table
+auto l_index(lua_State* const L) -> int
+{
+    auto const m = check_map(L);
+    lua_settop(L, 2);
+
+    if (LUA_TNIL != lua_rawget(L, lua_upvalueindex(1)))
+    {
+        return 1;
+    }
+    lua_pop(L, 1);
+
+    if (LUA_TSTRING == lua_type(L, 2))
+    {
+        auto const key = check_string_view(L, 2);
+        if (key == "n")
+        {
+            lua_pushinteger(L, m->n());
+            return 1;
+        }
+        if (key == "max")
+        {
+            lua_pushinteger(L, m->max());
+            return 1;
+        }
+        if (key == "ticker")
+        {
+            lua_pushinteger(L, m->ticker());
+            return 1;
+        }
+    }
+
+    lua_getiuservalue(L, 1, fields_uv);
+    lua_pushvalue(L, 2);
+    lua_rawget(L, -2);
+    return 1;
+}
+
+auto l_newindex(lua_State* const L) -> int
+{
+    check_map(L);
+    lua_settop(L, 3);
+    lua_getiuservalue(L, 1, fields_uv);
+    lua_insert(L, 2);
+    lua_rawset(L, 2);
+    return 0;
+}
+
+auto l_gc(lua_State* const L) -> int
+{
+    std::destroy_at(check_map(L));
+    return 0;
+}
+
+luaL_Reg const MT[]{
+    {"__newindex", l_newindex},
+    {"__gc", l_gc},
+    {}
+};
+
+} // namespace
+
+template <>
+char const* udata_name<OrderedMap> = "ordered_map";
+
+auto l_new_ordered_map(lua_State* const L) -> int
+{
+    auto const max = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, 0 < max && max <= 0x1000'0000, 1, "capacity out of range");
+    auto const native_irccase = lua_tocfunction(L, 2) == l_irccase;
+    lua_settop(L, 2);
+
+    auto const m = new_udata<OrderedMap>(L, 4, [L] {
+        luaL_setfuncs(L, MT, 0);
+        luaL_newlibtable(L, Methods);
+        luaL_setfuncs(L, Methods, 0);
+        lua_pushcclosure(L, l_index, 1);
+        lua_setfield(L, -2, "__index");
+    });
+    std::construct_at(m, max);
+
+    lua_createtable(L, max, 0);
+    lua_setiuservalue(L, -2, values_uv);
+    lua_createtable(L, max, 0);
+    lua_setiuservalue(L, -2, keys_uv);
+    lua_createtable(L, 0, 2);
+    lua_setiuservalue(L, -2, fields_uv);
+
+    if (native_irccase)
+    {
+        lua_pushlightuserdata(L, &irccase_marker);
+    }
+    else
+    {
+        lua_pushvalue(L, 2);
+    }
+    lua_setiuservalue(L, -2, keyfn_uv);
+
+    return 1;
+}
@@ -0,0 +1,39 @@
+#pragma once
+/**
+ * @file orderedmap.hpp
+ * @author Eric Mertens (emertens@gmail.com)
+ * @brief Fixed-capacity insertion-ordered maps
+ *
+ */
+
+struct lua_State;
+
+/**
+ * @brief Construct a new ordered map
+ *
+ * The map holds the most recent max entries in a ring buffer with a
+ * hash index from keys to their newest entry. Keys are nil, booleans,
+ * or strings, and other keys raise an argument error. The optional key
+ * function normalizes keys before they are indexed; snowcone.irccase is
+ * applied without calling into Lua.
+ *
+ * param:   integer   max     Capacity of the map
+ * param:   function? keyfn   Key normalization function
+ *
+ * Lua object methods:
+ * * insert(key, value)
+ * * lookup(key)
+ * * rekey(old, new)
+ * * each(offset) - newest entries first
+ * * reveach() - oldest entries first
+ * * get_oldest()
+ * * reset()
+ *
+ * Lua object fields: n (total insertions), max, ticker (insertions
+ * accepted by the optional predicate field). Other fields can be
+ * assigned freely.
+ *
+ * @param L Lua state
+ * @return 1
+ */
+auto l_new_ordered_map(lua_State* L) -> int;
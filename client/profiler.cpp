@@ -0,0 +1,265 @@
+#include "profiler.hpp"
+
+#include "app.hpp"
+#include "strings.hpp"
+
+extern "C" {
+#include <lauxlib.h>
+#include <lua.h>
+}
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <new>
+#include <span>
+#include <string>
+#include <utility>
+
+namespace profiler {
+
+using clock = std::chrono::steady_clock;
+
+/// @brief Wall-clock timing of one callback location
+struct CallbackStats
+{
+    /// Location name; refers to the key of the owning map entry
+    std::string_view location;
+    std::uint64_t calls;
+    clock::duration total;
+    clock::duration max;
+};
+
+namespace {
+
+/// @brief Sampled time of one Lua function under one callback location
+struct FunctionStats
+{
+    std::uint64_t samples;
+    clock::duration time;
+};
+
+struct State
+{
+    bool enabled = false;
+    std::map<std::string, CallbackStats, std::less<>> callbacks;
+    std::map<std::pair<std::string_view, std::string>, FunctionStats> functions;
+
+    /// Location of the innermost active scope
+    CallbackStats* current = nullptr;
+    /// Time the last sample was taken or the current scope was entered
+    clock::time_point last_sample;
+};
+
+auto state() -> State&
+{
+    static State instance;
+    return instance;
+}
+
+/// @brief Describe a function as name@source:line
+auto describe(lua_Debug const& ar) -> std::string
+{
+    std::string result;
+    if (ar.name)
+    {
+        result += ar.name;
+    }
+    else if (*ar.what == 'm')
+    {
+        result += "(main)";
+    }
+    else
+    {
+        result += '?';
+    }
+    result += '@';
+    result += ar.short_src;
+    if (ar.linedefined > 0)
+    {
+        result += ':';
+        result += std::to_string(ar.linedefined);
+    }
+    return result;
+}
+
+auto hook(lua_State* const L, lua_Debug* const ar) -> void
+{
+    auto& s = state();
+    if (nullptr == s.current || not lua_getinfo(L, "Sn", ar))
+    {
+        return;
+    }
+
+    auto const now = clock::now();
+
+    // Exceptions must not unwind through the Lua VM, and luaL_error must
+    // not skip the destructors of the sample key.
+    try
+    {
+        auto& stats = s.functions[{s.current->location, describe(*ar)}];
+        stats.samples++;
+        stats.time += now - s.last_sample;
+        s.last_sample = now;
+        return;
+    }
+    catch (std::bad_alloc const&)
+    {
+    }
+    luaL_error(L, "profiler: not enough memory");
+}
+
+auto seconds(clock::duration const d) -> lua_Number
+{
+    return std::chrono::duration<lua_Number>{d}.count();
+}
+
+} // namespace
+
+Scope::Scope(std::string_view const location)
+    : stats_{nullptr}
+    , outer_{nullptr}
+{
+    auto& s = state();
+    if (s.enabled)
+    {
+        auto it = s.callbacks.find(location);
+        if (it == s.callbacks.end())
+        {
+            it = s.callbacks.emplace(std::string{location}, CallbackStats{}).first;
+            it->second.location = it->first;
+        }
+        stats_ = &it->second;
+        outer_ = std::exchange(s.current, stats_);
+        start_ = clock::now();
+        s.last_sample = start_;
+    }
+}
+
+Scope::~Scope()
+{
+    if (nullptr != stats_)
+    {
+        auto& s = state();
+        auto const now = clock::now();
+        auto const elapsed = now - start_;
+        stats_->calls++;
+        stats_->total += elapsed;
+        stats_->max = std::max(stats_->max, elapsed);
+        s.current = outer_;
+        s.last_sample = now; // nested time isn't charged to the outer samples
+    }
+}
+
+} // namespace profiler
+
+using namespace profiler;
+
+auto l_profile_start(lua_State* const L) -> int
+{
+    auto const interval = luaL_optinteger(L, 1, 1000);
+    luaL_argcheck(L, 0 < interval && interval <= INT32_MAX, 1, "interval out of range");
+
+    state().enabled = true;
+    lua_sethook(App::from_lua(L)->get_lua(), hook, LUA_MASKCOUNT, static_cast<int>(interval));
+    return 0;
+}
+
+auto l_profile_stop(lua_State* const L) -> int
+{
+    state().enabled = false;
+    lua_sethook(App::from_lua(L)->get_lua(), nullptr, 0, 0);
+    return 0;
+}
+
+auto l_profile_reset(lua_State*) -> int
+{
+    // Active scopes refer to the callback entries, so they are zeroed in place
+    auto& s = state();
+    for (auto& [_, stats] : s.callbacks)
+    {
+        stats.calls = 0;
+        stats.total = stats.max = clock::duration::zero();
+    }
+    s.functions.clear();
+    return 0;
+}
+
+/// @brief Sort pointers to the kept map entries in descending order of proj
+///
+/// The pointers live in a userdata pushed onto the stack so that a later
+/// Lua error has nothing to destroy.
+template <typename Map, typename Keep, typename Proj>
+auto push_sorted(lua_State* const L, Map const& map, Keep const keep, Proj const proj)
+    -> std::span<typename Map::value_type const*>
+{
+    using Entry = typename Map::value_type;
+    auto const data = static_cast<Entry const**>(lua_newuserdatauv(L, map.size() * sizeof(Entry const*), 0));
+    std::size_t n = 0;
+    for (auto const& entry : map)
+    {
+        if (keep(entry))
+        {
+            data[n++] = &entry;
+        }
+    }
+    std::span<Entry const*> const entries{data, n};
+    std::ranges::sort(entries, std::greater{}, proj);
+    return entries;
+}
+
+auto l_profile_report(lua_State* const L) -> int
+{
+    auto& s = state();
+
+    auto const callbacks = push_sorted(
+        L, s.callbacks,
+        [](auto const& x) { return 0 < x.second.calls; },
+        [](auto const* const x) { return x->second.total; });
+    auto const functions = push_sorted(
+        L, s.functions,
+        [](auto const&) { return true; },
+        [](auto const* const x) { return x->second.time; });
+
+    lua_createtable(L, 0, 3);
+
+    lua_pushboolean(L, s.enabled);
+    lua_setfield(L, -2, "enabled");
+
+    lua_createtable(L, callbacks.size(), 0);
+    lua_Integer i = 0;
+    for (auto const* const entry : callbacks)
+    {
+        auto const* const stats = &entry->second;
+        lua_createtable(L, 0, 4);
+        push_string(L, stats->location);
+        lua_setfield(L, -2, "location");
+        lua_pushinteger(L, stats->calls);
+        lua_setfield(L, -2, "calls");
+        lua_pushnumber(L, seconds(stats->total));
+        lua_setfield(L, -2, "total");
+        lua_pushnumber(L, seconds(stats->max));
+        lua_setfield(L, -2, "max");
+        lua_rawseti(L, -2, ++i);
+    }
+    lua_setfield(L, -2, "callbacks");
+
+    lua_createtable(L, functions.size(), 0);
+    i = 0;
+    for (auto const* const entry : functions)
+    {
+        lua_createtable(L, 0, 4);
+        push_string(L, entry->first.first);
+        lua_setfield(L, -2, "location");
+        push_string(L, entry->first.second);
+        lua_setfield(L, -2, "func");
+        lua_pushinteger(L, entry->second.samples);
+        lua_setfield(L, -2, "samples");
+        lua_pushnumber(L, seconds(entry->second.time));
+        lua_setfield(L, -2, "time");
+        lua_rawseti(L, -2, ++i);
+    }
+    lua_setfield(L, -2, "functions");
+
+    return 1;
+}
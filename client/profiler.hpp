@@ -0,0 +1,85 @@
+#pragma once
+/**
+ * @file profiler.hpp
+ * @author Eric Mertens (emertens@gmail.com)
+ * @brief Opt-in sampling profiler for Lua callbacks
+ *
+ * Every entry into Lua through safecall opens a profiler scope named
+ * by the callback location. While profiling is enabled each scope
+ * records its wall-clock time and a count hook periodically samples
+ * the running Lua function. Each sample is weighted by the time since
+ * the previous one, so the function totals approximate CPU time.
+ */
+
+#include <chrono>
+#include <string_view>
+
+struct lua_State;
+
+namespace profiler {
+
+struct CallbackStats;
+
+/**
+ * @brief Attribute Lua execution to a callback location
+ */
+class Scope
+{
+    /// Statistics for this location; null when profiling is disabled
+    CallbackStats* stats_;
+    /// Statistics of the enclosing scope when callbacks nest
+    CallbackStats* outer_;
+    std::chrono::steady_clock::time_point start_;
+
+public:
+    Scope(std::string_view location);
+    ~Scope();
+
+    Scope(Scope const&) = delete;
+    auto operator=(Scope const&) -> Scope& = delete;
+};
+
+} // namespace profiler
+
+/**
+ * @brief Start profiling
+ *
+ * Coroutines created before profiling starts are not sampled.
+ *
+ * param:   integer? interval   VM instructions between samples, default 1000
+ *
+ * @param L Lua state
+ * @return 0
+ */
+auto l_profile_start(lua_State* L) -> int;
+
+/**
+ * @brief Stop profiling and keep the results collected so far
+ *
+ * @param L Lua state
+ * @return 0
+ */
+auto l_profile_stop(lua_State* L) -> int;
+
+/**
+ * @brief Discard the results collected so far
+ *
+ * @param L Lua state
+ * @return 0
+ */
+auto l_profile_reset(lua_State* L) -> int;
+
+/**
+ * @brief Get the profiler results
+ *
+ * The callbacks array has entries with location, calls, total, and
+ * max fields sorted by total. The functions array has entries with
+ * location, func, samples, and time fields sorted by time. Times
+ * are in seconds.
+ *
+ * return: table  {enabled=boolean, callbacks=table, functions=table}
+ *
+ * @param L Lua state
+ * @return 1
+ */
+auto l_profile_report(lua_State* L) -> int;
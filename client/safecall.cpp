@@ -1,5 +1,8 @@
 #include "safecall.hpp"
 
+#include "metrics.hpp"
+#include "profiler.hpp"
+
 extern "C" {
 #include <lauxlib.h>
 #include <lua.h>
@@ -12,6 +15,11 @@ extern "C" {
 
 int safecall(lua_State* const L, std::string_view const location, int const args)
 {
+    static auto& calls = metrics::histogram("lua_safecall_seconds", "Time spent in protected Lua callbacks");
+    static auto& errors = metrics::counter("lua_safecall_errors_total", "Protected Lua callbacks that raised errors");
+    metrics::ScopedTimer const timer{calls};
+    profiler::Scope const scope{location};
+
     lua_pushcfunction(L, [](auto const L) {
         auto const msg = luaL_tolstring(L, 1, nullptr);
         luaL_traceback(L, L, msg, 1);
@@ -29,6 +37,7 @@ int safecall(lua_State* const L, std::string_view const location, int const args
     }
     else
     {
+        errors.add();
         auto const err = lua_tolstring(L, -1, nullptr);
         endwin();
         std::cerr << "error in " << location << ": " << err << std::endl;
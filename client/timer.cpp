@@ -1,6 +1,7 @@
 #include "timer.hpp"
 
 #include "app.hpp"
+#include "metrics.hpp"
 #include "safecall.hpp"
 #include "userdata.hpp"
 
@@ -53,6 +54,11 @@ luaL_Reg const Methods[]{
          timer->expires_after(std::chrono::milliseconds{start});
          timer->async_wait([L = app->get_lua(), timer](auto const error) {
             if (not error) {
+                static auto& fired = metrics::counter("timer_callbacks_total", "Lua timer callbacks run");
+                static auto& lateness = metrics::histogram("timer_lateness_seconds", "Delay between timer expiry and its callback");
+                fired.add();
+                lateness.record(Timer::clock_type::now() - timer->expiry());
+
                 // get the callback
                 lua_rawgetp(L, LUA_REGISTRYINDEX, timer);
                 // forget the callback
@@ -14,7 +14,6 @@ function M:_init(network, prefix)
         self.tailbyte = string.byte(network, bytes+1) & mask
         self.tailix = bytes+1
     end
-    self.count = 0
 end
 
 function M:match(address)
@@ -24,10 +23,6 @@ function M:match(address)
             or (string.byte(address,self.tailix) & self.tailmask) == self.tailbyte)
 end
 
-function M:delta(i)
-    self.count = self.count + i
-end
-
 assert(M('1234',32):match('1234'))
 assert(not M('1234',32):match('1235'))
 assert(M('123\0',24):match('1234'))
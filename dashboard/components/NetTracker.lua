@@ -6,35 +6,30 @@ M._name = 'NetTracker'
 local MaskTracker = require_ 'components.MaskTracker'
 
 function M:_init()
-    self.masks = {}
+    self.masks = {} -- label to MaskTracker, used for listing and ordering
+    self.counters = mylpm.new() -- longest-prefix match of addresses to labels
 end
 
 function M:track(label, address, prefix)
     self.masks[label] = MaskTracker(address, prefix)
+    self.counters:track(label, address, prefix)
+end
+
+function M:untrack(label)
+    self.masks[label] = nil
+    self.counters:untrack(label)
 end
 
 function M:set(label, count)
-    local mask = self.masks[label]
-    if mask then
-        mask.count = count
-    end
+    self.counters:set(label, count)
 end
 
 function M:delta(address, i)
-    for _, mask in pairs(self.masks) do
-        if mask:match(address) then
-            mask:delta(i)
-            return
-        end
-    end
+    return self.counters:delta(address, i)
 end
 
-function M:count()
-    local n = 0
-    for _, mask in pairs(self.masks) do
-        n = n + mask.count
-    end
-    return n
+function M:count(label)
+    return self.counters:count(label)
 end
 
 return M
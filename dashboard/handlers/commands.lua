@@ -165,6 +165,7 @@ add_command('addwatch', '$r', function(args)
         watch.hits = 0
 
         table.insert(watches, watch)
+        matching.watches_changed()
         status('addwatch', 'Added watch #%d', #watches)
 
     -- Updating an old watch
@@ -172,6 +173,7 @@ add_command('addwatch', '$r', function(args)
         local previous = watches[id]
         if previous then
             tablex.update(previous, watch)
+            matching.watches_changed()
             status('addwatch', 'Updated watch #%d', id)
         else
             status('addwatch', 'So such watch')
@@ -182,6 +184,7 @@ end)
 add_command('delwatch', '$i', function(i)
     if watches[i] then
         table.remove(watches, i)
+        matching.watches_changed()
     elseif i == nil then
         status('delwatch', 'delwatch requires integer argument')
     else
@@ -56,16 +56,16 @@ function M.connect(ev)
         population[ev.server] = pop + 1
     end
 
-    local safematch = matching.safematch
-    for _, watch in ipairs(watches) do
-        if watch.active then
-            if
-                safematch(entry.mask, watch.regexp) or
-                entry.org and safematch(entry.org, watch.regexp) or
-                entry.asn and safematch('AS'..entry.asn, watch.regexp) or
-                entry.account and safematch(entry.account, watch.regexp) or
-                entry.ip  and safematch(ev.nick .. '!' .. ev.user .. '@' .. ev.ip .. '#' .. ev.gecos, watch.regexp)
-            then
+    if next(watches) then
+        local hits = matching.match_watches(
+            entry.mask,
+            entry.org,
+            entry.asn and 'AS'..entry.asn,
+            entry.account,
+            entry.ip and ev.nick .. '!' .. ev.user .. '@' .. ev.ip .. '#' .. ev.gecos)
+
+        for i, watch in ipairs(watches) do
+            if hits[i] then
                 watch.hits = watch.hits + 1
                 entry.mark = watch.color or ncurses.COLOR_RED
                 if watch.beep  then ncurses.beep () end
@@ -12,6 +12,9 @@ if not uptime then
     app.require_here()
 end
 
+-- Frames are drawn into a retained screen and only changed rows reach the terminal
+ncurses.settarget(ncurses.newscreen())
+
 addstr = ncurses.addstr
 mvaddstr = ncurses.mvaddstr
 
@@ -58,15 +61,28 @@ local configuration_tools = require_ 'utils.configuration_tools'
 
 -- Load configuration =================================================
 
+local replay       -- {file=, speed=} when replaying a capture in place of the server
+local capture_file -- records the server traffic when set
+
 do
     local config_home = os.getenv 'XDG_CONFIG_HOME'
                     or path.join(assert(os.getenv 'HOME', 'HOME not set'), '.config')
     config_dir = path.join(config_home, 'snowcone')
 
-    local flags = app.parse_args(arg, {config=true})
+    local flags = app.parse_args(arg, {config=true, capture=true, replay=true, ['replay-speed']=true})
     if not flags then
         error("Failed to parse command line flags")
     end
+
+    capture_file = flags.capture
+    if flags.replay then
+        local speed = tonumber(flags['replay-speed'] or 0)
+        if type(flags.replay) ~= 'string' or not speed then
+            error("Usage: --replay=FILE [--replay-speed=N]", 0)
+        end
+        replay = {file = flags.replay, speed = speed}
+    end
+
     local settings_filename = nil
     local settings_file = nil
     if flags.config then
@@ -126,6 +142,10 @@ if configuration.challenge and string.match(configuration.challenge.username, '[
     error 'Invalid character in challenge username'
 end
 
+if configuration.display and configuration.display.frame_interval then
+    snowcone.set_frame_interval(configuration.display.frame_interval)
+end
+
 -- Load network configuration =========================================
 
 do
@@ -599,6 +619,7 @@ views = {
     netcount = require_ 'view.netcount',
     bans = require_ 'view.bans',
     stats = require_ 'view.stats',
+    profile = require_ 'view.profile',
     repeats = require_ 'view.repeats',
     banload = view_simple_load('banload', 'K-Liner', 'KLINES', 'K-Line History', kline_tracker),
     spamload = view_simple_load('spamload', 'Server', 'FILTERS', 'Filter History', filter_tracker),
@@ -647,7 +668,8 @@ function resume_tty()
     end
 end
 
-function draw()
+-- Called by the client at most once per frame interval
+local function render()
     if 0 < drawing_suspended then return end
     clicks = {}
     ncurses.erase()
@@ -656,6 +678,11 @@ function draw()
     ncurses.refresh()
 end
 
+-- Requests coalesce, so handlers can call this after every change
+function draw()
+    snowcone.redraw()
+end
+
 -- Network Tracker Logic ==============================================
 
 function add_network_tracker(name, mask)
@@ -731,7 +758,7 @@ if not tick_timer then
         tick_timer:start(1000, cb)
         uptime = uptime + 1
 
-        if irc_state then
+        if irc_state and not replay then
             if irc_state.phase == 'connected' and uptime == irc_state.liveness + 30 then
                 send('PING', 'snowcone')
             elseif uptime == irc_state.liveness + 60 then
@@ -788,9 +815,33 @@ local connect
 
 local irc_event = {}
 
+-- Summarize replay throughput and per-stage latency from the native metrics
+local function replay_summary()
+    local s, ns = snowcone.time()
+    local elapsed = s + ns / 1e9 - replay.started
+    local metrics = snowcone.metrics()
+    local n = metrics.irc_lines_parsed_total - replay.baseline
+
+    local function us(name, q)
+        return metrics[name][q] * 1e6
+    end
+
+    return string.format(
+        '%d messages in %.3fs (%.0f msg/s); p50/p99 us: parse %.1f/%.1f push %.1f/%.1f callback %.1f/%.1f',
+        n, elapsed, n / math.max(elapsed, 1e-9),
+        us('irc_parse_seconds', 'p50'), us('irc_parse_seconds', 'p99'),
+        us('irc_push_seconds', 'p50'), us('irc_push_seconds', 'p99'),
+        us('irc_callback_seconds', 'p50'), us('irc_callback_seconds', 'p99'))
+end
+
 function irc_event.CON()
     irc_state = Irc()
     status('irc', 'connected')
+    if replay then
+        local s, ns = snowcone.time()
+        replay.started = s + ns / 1e9
+        replay.baseline = snowcone.metrics().irc_lines_parsed_total
+    end
     if exiting then
         disconnect()
     else
@@ -803,7 +854,14 @@ function irc_event.END(txt)
     conn = nil
     status('irc', 'disconnected %s', txt)
 
-    if exiting then
+    if replay then
+        if replay.started then
+            status('replay', '%s', replay_summary())
+        end
+        if exiting then
+            snowcone.shutdown()
+        end
+    elseif exiting then
         snowcone.shutdown()
     else
         reconnect_timer = snowcone.newtimer()
@@ -854,6 +912,16 @@ function irc_event.MSG(irc)
     end
 end
 
+function irc_event.MSGS(ircs)
+    for _, irc in ipairs(ircs) do
+        irc_event.MSG(irc)
+    end
+end
+
+function irc_event.BAD(message)
+    status('irc', 'skipped line: %s', message)
+end
+
 local function on_irc(event, irc)
     irc_event[event](irc)
 end
@@ -861,6 +929,8 @@ end
 
 local M = {}
 
+M.on_frame = render
+
 
 local key_handlers = require_ 'handlers.keyboard'
 local input_handlers = require_ 'handlers.input'
@@ -931,7 +1001,11 @@ end)
 
 function disconnect(msg)
     if conn then
-        send('QUIT', msg or 'closing')
+        if replay then
+            conn:close() -- there is no server to end the session
+        else
+            send('QUIT', msg or 'closing')
+        end
         conn = nil
     end
 end
@@ -940,8 +1014,8 @@ end
 function connect()
     Task(client_tasks, function(task) -- passwords might need to suspend connecting
 
-        local use_tls = nil ~= configuration.tls
-        local use_socks = nil ~= configuration.socks
+        local use_tls = nil ~= configuration.tls and not replay
+        local use_socks = nil ~= configuration.socks and not replay
 
         local ok, tls_client_password, socks_password, tls_client_cert, tls_client_key
 
@@ -1003,7 +1077,7 @@ function connect()
         local conn_, errmsg =
             snowcone.connect(
             use_tls,
-            configuration.server.host,
+            replay and replay.file or configuration.server.host,
             configuration.server.port or use_tls and 6697 or 6667,
             tls_client_cert,
             tls_client_key,
@@ -1013,7 +1087,16 @@ function connect()
             use_socks and configuration.socks.port or nil,
             use_socks and configuration.socks.username or nil,
             socks_password,
-            on_irc)
+            on_irc,
+            {lazy = true, batch = true,
+             send_burst = configuration.server.send_burst,
+             send_rate = configuration.server.send_rate,
+             thread = configuration.server.thread,
+             ktls = use_tls and configuration.tls.ktls,
+             session_cache = use_tls and configuration.tls.session_cache,
+             capture = capture_file,
+             replay = replay and replay.file,
+             replay_speed = replay and replay.speed})
 
         if conn_ then
             conn = conn_
@@ -1025,6 +1108,6 @@ function connect()
     end)
 end
 
-if not conn and configuration.server.host then
+if not conn and (configuration.server.host or replay) then
     connect()
 end
@@ -40,6 +40,84 @@ function M.safematch(str, pat)
     return not not pat:exec(str)
 end
 
+-- Watches that are matched together by a single Hyperscan database.
+-- Watches whose expressions Hyperscan rejects are checked one at a time.
+local watch_generation = 0
+local built_generation
+local built_watches
+local watch_db
+local watch_slow = {}
+
+-- Must be called after adding, removing, editing, or toggling a watch
+function M.watches_changed()
+    watch_generation = watch_generation + 1
+end
+
+local function refresh_watches()
+    -- initialize() replaces the watches table when the script is reloaded
+    if built_generation == watch_generation and built_watches == watches then return end
+
+    built_generation = watch_generation
+    built_watches = watches
+    watch_db = nil
+    watch_slow = {}
+
+    local active = {}
+    for i, watch in ipairs(watches) do
+        if watch.active then
+            active[#active + 1] = i
+        end
+    end
+
+    if not hsfilter then
+        watch_slow = active
+        return
+    end
+
+    local base_flags = hsfilter.flags.HS_FLAG_SINGLEMATCH | hsfilter.flags.HS_FLAG_ALLOWEMPTY
+    while next(active) do
+        local exprs, flags = {}, {}
+        for j, i in ipairs(active) do
+            local mask = watches[i].mask
+            exprs[j] = mask
+            flags[j] = mask:find '%u' and base_flags or base_flags | hsfilter.flags.HS_FLAG_CASELESS
+        end
+
+        local db, _, bad = hsfilter.compile(exprs, flags, active)
+        if db then
+            watch_db = db
+            return
+        end
+        table.insert(watch_slow, table.remove(active, bad))
+    end
+end
+
+-- Find the active watches matching any of the given strings. Nil
+-- arguments are ignored. Returns a set of indexes into watches.
+function M.match_watches(...)
+    refresh_watches()
+
+    local strs = {}
+    for i = 1, select('#', ...) do
+        local str = select(i, ...)
+        if str then strs[#strs + 1] = str end
+    end
+
+    local hits = watch_db and watch_db:scan(table.unpack(strs)) or {}
+
+    for _, i in ipairs(watch_slow) do
+        local regexp = watches[i].regexp
+        for _, str in ipairs(strs) do
+            if regexp:exec(str) then
+                hits[i] = true
+                break
+            end
+        end
+    end
+
+    return hits
+end
+
 function M.current_pattern()
     if input_mode == 'filter' then
         return editor:content()
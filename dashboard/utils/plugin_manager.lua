@@ -7,6 +7,10 @@ Plugin API:
 .irc      - table    - mapping from IRC commands to functions
 .widget   - function - called to render plugin state during /plugins view
 
+IRC messages are delivered as userdata that build their fields on
+demand. They support indexing, #, ipairs, and pairs like a table, but
+type(msg) is 'userdata' and next and rawget do not see their fields.
+
 ]]
 
 local path = require 'pl.path'
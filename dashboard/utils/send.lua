@@ -51,7 +51,11 @@ return function(cmd, ...)
         error('message too long: ' .. #raw, 2)
     end
 
-    conn:send(raw)
+    -- false when the connection's send queue is past its high-water mark;
+    -- the flood-control lane is chosen natively from the command
+    local below_high_water, queued = conn:send(raw)
 
     messages:insert(true, msg)
+
+    return below_high_water, queued
 end
@@ -1,5 +1,6 @@
 local tablex = require 'pl.tablex'
 local drawing = require 'utils.drawing'
+local matching = require 'utils.matching'
 
 local M = {
     title = 'netcount',
@@ -49,11 +50,13 @@ local function toggle(watch, field, on, off)
         green()
         add_button(on, function()
             watch[field] = nil
+            matching.watches_changed()
         end)
     else
         yellow()
         add_button(off, function()
             watch[field] = true
+            matching.watches_changed()
         end)
     end
 end
@@ -84,11 +87,11 @@ function M:render()
                 y = y + 1
                 if y+1 >= tty_height then break end
                 blue()
-                render_entry(y, label, entry.count, true)
+                render_entry(y, label, tracker:count(label), true)
 
                 red()
                 add_button('(x)', function()
-                    tracker.masks[label] = nil
+                    tracker:untrack(label)
                 end)
             end
         else
@@ -114,6 +117,7 @@ function M:render()
         red()
         add_button('(x)', function()
             table.remove(watches, i)
+            matching.watches_changed()
         end)
 
         toggle(watch, 'active', '(A)', '(a)')
@@ -0,0 +1,64 @@
+local M = {
+    title = 'profile',
+    keypress = function() end,
+    draw_status = function() end,
+}
+
+local function ms(seconds)
+    return string.format('%10.1f', seconds * 1000)
+end
+
+function M:render()
+    local report = snowcone.profile_report()
+
+    green()
+    addstr('          -= profile =-  ')
+    normal()
+    if report.enabled then
+        red()
+        add_button('[STOP]', snowcone.profile_stop)
+    else
+        green()
+        add_button('[START]', function() snowcone.profile_start() end)
+    end
+    addstr(' ')
+    yellow()
+    add_button('[RESET]', snowcone.profile_reset)
+    normal()
+    addstr '\n\n'
+
+    -- Split the screen between callbacks and the functions they ran
+    local rows = math.max(0, (tty_height - 6) // 2)
+
+    magenta()
+    bold()
+    addstr('     calls   total ms     max ms  callback\n')
+    normal()
+    for i = 1, math.min(rows, #report.callbacks) do
+        local entry = report.callbacks[i]
+        addstr(string.format('%10d %s %s  ', entry.calls, ms(entry.total), ms(entry.max)))
+        cyan()
+        addstr(entry.location)
+        normal()
+        addstr '\n'
+    end
+
+    addstr '\n'
+    magenta()
+    bold()
+    addstr('   samples    time ms  callback             function\n')
+    normal()
+    for i = 1, math.min(rows, #report.functions) do
+        local entry = report.functions[i]
+        addstr(string.format('%10d %s  ', entry.samples, ms(entry.time)))
+        cyan()
+        addstr(string.format('%-20.20s ', entry.location))
+        normal()
+        addstr(entry.func)
+        addstr '\n'
+    end
+
+    draw_global_load('cliconn', conn_tracker)
+end
+
+return M
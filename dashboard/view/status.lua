@@ -32,7 +32,11 @@ local safematch = matching.safematch
 
 local function show_entry(entry)
     local current_filter = matching.current_pattern()
-    return safematch(entry.text, current_filter)
+    if current_filter == nil then
+        return true
+    end
+    -- Match the text as displayed rather than its formatting codes
+    return safematch(snowcone.stripirc(entry.text), current_filter)
 end
 
 function M:render()
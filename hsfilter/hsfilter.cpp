@@ -8,8 +8,13 @@ extern "C"
 
 #include <hs.h>
 
+#include <cstdlib>
+#include <cstring>
 #include <exception>
+#include <memory>
+#include <new>
 #include <optional>
+#include <vector>
 
 namespace
 {
@@ -33,34 +38,48 @@ namespace
     return platform;
   }
 
-  auto compile(
+  /**
+   * @brief Compile a set of expressions into a database
+   *
+   * When an expression is rejected the error message is pushed and
+   * nullptr is returned with bad_expression set to the index of the
+   * offending expression. Other failures raise a Lua error.
+   */
+  auto compile_database(
       lua_State *const L,
       char const *const *const exprs,
       unsigned const *const flags,
       unsigned const *const ids,
       unsigned const N,
-      hs_platform_info_t const *const platform) -> void
+      unsigned const mode,
+      hs_platform_info_t const *const platform,
+      int &bad_expression) -> hs_database_t *
   {
     hs_database_t *db;
     hs_compile_error_t *error;
-    auto const compile_result = hs_compile_multi(exprs, flags, ids, N, HS_MODE_BLOCK, platform, &db, &error);
+    auto const compile_result = hs_compile_multi(exprs, flags, ids, N, mode, platform, &db, &error);
     switch (compile_result)
     {
     case HS_SUCCESS:
       // db allocated
-      break;
+      return db;
     case HS_COMPILER_ERROR:
       // error allocated
       lua_pushfstring(L, "error in regular expression %d: %s", error->expression, error->message);
+      bad_expression = error->expression;
       if (HS_SUCCESS != hs_free_compile_error(error))
       {
         std::terminate();
       }
-      lua_error(L);
+      return nullptr;
     default:
       luaL_error(L, "hs_compile_multi(%d)", int{compile_result});
+      return nullptr;
     }
+  }
 
+  auto serialize(lua_State *const L, hs_database_t *const db) -> void
+  {
     char *serialize_bytes;
     size_t serialize_len;
     auto const serialize_result = hs_serialize_database(db, &serialize_bytes, &serialize_len);
@@ -76,7 +95,7 @@ namespace
     }
 
     lua_pushlstring(L, serialize_bytes, serialize_len);
-    free(serialize_bytes);
+    std::free(serialize_bytes);
   }
 
   template <typename T>
@@ -85,18 +104,29 @@ namespace
     return static_cast<T *>(lua_newuserdatauv(L, sizeof(T) * N, 0));
   }
 
-  auto l_serialize_regexp_db(lua_State *const L) -> int
+  /// @brief Expressions, flags, and ids collected from three parallel tables
+  struct Patterns
+  {
+    char const **exprs;
+    unsigned *flags;
+    unsigned *ids;
+    unsigned N;
+  };
+
+  /**
+   * @brief Collect the expression, flag, and id tables at indexes 1 to 3
+   *
+   * The arrays are allocated as Lua userdata above the arguments because
+   * this code can call lua_error.
+   */
+  auto check_patterns(lua_State *const L) -> Patterns
   {
     luaL_checktype(L, 1, LUA_TTABLE);
     luaL_checktype(L, 2, LUA_TTABLE);
     luaL_checktype(L, 3, LUA_TTABLE);
-    auto const platform = lua_isnoneornil(L, 4) ? std::optional<hs_platform_info>{} : std::optional{get_platform(L, 4)};
-    lua_settop(L, 3);
 
     auto const N = luaL_len(L, 1);
 
-    // We use Lua to allocate these, instead of alloca or std::vector,
-    // because this code can call lua_error
     auto const exprs = calloc_with_lua<char const *>(L, N);
     auto const flags = calloc_with_lua<unsigned>(L, N);
     auto const ids = calloc_with_lua<unsigned>(L, N);
@@ -124,7 +154,460 @@ namespace
       lua_pop(L, 3); // drops the expr, flag, id
     }
 
-    compile(L, exprs, flags, ids, N, platform ? &*platform : nullptr);
+    return {exprs, flags, ids, static_cast<unsigned>(N)};
+  }
+
+  auto l_serialize_regexp_db(lua_State *const L) -> int
+  {
+    auto const platform = lua_isnoneornil(L, 4) ? std::optional<hs_platform_info>{} : std::optional{get_platform(L, 4)};
+    lua_settop(L, 3);
+
+    auto const [exprs, flags, ids, N] = check_patterns(L);
+
+    int bad_expression;
+    auto const db = compile_database(L, exprs, flags, ids, N, HS_MODE_BLOCK, platform ? &*platform : nullptr, bad_expression);
+    if (nullptr == db)
+    {
+      lua_error(L);
+    }
+
+    serialize(L, db);
+    return 1;
+  }
+
+  /// @brief Ids matched during a scan in order of first match
+  struct Matches
+  {
+    std::vector<unsigned> ids;
+    bool failed;
+
+    auto clear() -> void
+    {
+      ids.clear();
+      failed = false;
+    }
+  };
+
+  /// @brief Database ready for scanning along with its scratch space
+  ///
+  /// The matches buffer is reused by every scan. Keeping it in the
+  /// userdata rather than on the C stack means a Lua error raised while
+  /// reporting the matches cannot leak it.
+  struct Database
+  {
+    hs_database_t *db = nullptr;
+    hs_scratch_t *scratch = nullptr;
+    /// HS_MODE_BLOCK, HS_MODE_STREAM, or HS_MODE_VECTORED
+    unsigned mode = HS_MODE_BLOCK;
+    Matches matches{};
+  };
+
+  /// @brief Open stream scanned with its database's scratch space and
+  /// match buffer
+  ///
+  /// The database userdata is kept alive as the stream's user value.
+  /// Closing the database explicitly still frees its scratch space, so
+  /// stream operations check the database each time they run.
+  struct Stream
+  {
+    hs_stream_t *stream;
+  };
+
+  char const database_name[] = "hsfilter.database";
+  char const stream_name[] = "hsfilter.stream";
+
+  /// Stream user value holding its database
+  constexpr int database_uv = 1;
+
+  char const *const mode_names[]{"block", "stream", "vectored", nullptr};
+  unsigned const mode_values[]{HS_MODE_BLOCK, HS_MODE_STREAM, HS_MODE_VECTORED};
+
+  auto check_database(lua_State *const L, int const arg) -> Database &
+  {
+    auto &database = *static_cast<Database *>(luaL_checkudata(L, arg, database_name));
+    luaL_argcheck(L, nullptr != database.db, arg, "database already closed");
+    return database;
+  }
+
+  auto check_stream(lua_State *const L, int const arg) -> Stream &
+  {
+    auto &stream = *static_cast<Stream *>(luaL_checkudata(L, arg, stream_name));
+    luaL_argcheck(L, nullptr != stream.stream, arg, "stream already closed");
+    return stream;
+  }
+
+  /// @brief Get the database of the open stream at index arg
+  auto stream_database(lua_State *const L, int const arg) -> Database &
+  {
+    lua_getiuservalue(L, arg, database_uv);
+    auto &database = *static_cast<Database *>(lua_touserdata(L, -1));
+    // the stream's reference keeps the database alive after the pop
+    lua_pop(L, 1);
+    luaL_argcheck(L, nullptr != database.db, arg, "database already closed");
+    return database;
+  }
+
+  auto l_database_close(lua_State *const L) -> int
+  {
+    auto &database = *static_cast<Database *>(luaL_checkudata(L, 1, database_name));
+    if (nullptr != database.scratch)
+    {
+      hs_free_scratch(database.scratch);
+      database.scratch = nullptr;
+    }
+    if (nullptr != database.db)
+    {
+      hs_free_database(database.db);
+      database.db = nullptr;
+    }
+    database.matches.ids = {};
+    return 0;
+  }
+
+  auto l_database_gc(lua_State *const L) -> int
+  {
+    l_database_close(L);
+    std::destroy_at(static_cast<Database *>(lua_touserdata(L, 1)));
+    return 0;
+  }
+
+  auto on_match(unsigned const id, unsigned long long, unsigned long long, unsigned, void *const context) -> int
+  {
+    auto &matches = *static_cast<Matches *>(context);
+    // Exceptions must not unwind through the scanner
+    try
+    {
+      matches.ids.push_back(id);
+      return 0;
+    }
+    catch (std::bad_alloc const &)
+    {
+      matches.failed = true;
+      return 1; // stop scanning
+    }
+  }
+
+  /// @brief Push the set of matched ids or raise an error if matching failed
+  auto push_matches(lua_State *const L, Matches const &matches) -> void
+  {
+    if (matches.failed)
+    {
+      luaL_error(L, "not enough memory");
+    }
+
+    lua_createtable(L, 0, matches.ids.size());
+    for (auto const id : matches.ids)
+    {
+      lua_pushboolean(L, 1);
+      lua_rawseti(L, -2, id);
+    }
+  }
+
+  auto check_scan_result(lua_State *const L, char const *const what, hs_error_t const result) -> void
+  {
+    if (HS_SUCCESS != result && HS_SCAN_TERMINATED != result)
+    {
+      luaL_error(L, "%s(%d)", what, int{result});
+    }
+  }
+
+  /**
+   * @brief Scan strings against every pattern in the database
+   *
+   * Block mode databases scan each string independently. Vectored mode
+   * databases scan all the strings as one logical block in a single call.
+   * Both use the scratch space allocated when the database was loaded.
+   *
+   * param:     string ...  Strings to scan
+   * return:    table       Set of ids of all matching patterns
+   */
+  auto l_database_scan(lua_State *const L) -> int
+  {
+    auto &database = check_database(L, 1);
+    luaL_argcheck(L, HS_MODE_STREAM != database.mode, 1, "stream database requires open_stream");
+
+    auto const n = lua_gettop(L) - 1;
+    for (int i = 2; i <= n + 1; i++)
+    {
+      luaL_checkstring(L, i);
+    }
+
+    auto &matches = database.matches;
+    matches.clear();
+
+    if (HS_MODE_VECTORED == database.mode && n > 0)
+    {
+      auto const data = calloc_with_lua<char const *>(L, n);
+      auto const lengths = calloc_with_lua<unsigned>(L, n);
+      for (int i = 0; i < n; i++)
+      {
+        size_t len;
+        data[i] = lua_tolstring(L, i + 2, &len);
+        lengths[i] = len;
+      }
+      auto const result = hs_scan_vector(database.db, data, lengths, n, 0, database.scratch, on_match, &matches);
+      check_scan_result(L, "hs_scan_vector", result);
+    }
+    else if (HS_MODE_BLOCK == database.mode)
+    {
+      for (int i = 2; i <= n + 1 && not matches.failed; i++)
+      {
+        size_t len;
+        auto const str = lua_tolstring(L, i, &len);
+        auto const result = hs_scan(database.db, str, len, 0, database.scratch, on_match, &matches);
+        check_scan_result(L, "hs_scan", result);
+      }
+    }
+
+    push_matches(L, matches);
+    return 1;
+  }
+
+  auto l_stream_gc(lua_State *const L) -> int
+  {
+    auto &stream = *static_cast<Stream *>(luaL_checkudata(L, 1, stream_name));
+    if (nullptr != stream.stream)
+    {
+      // discards any matches pending at the end of the stream
+      hs_close_stream(stream.stream, nullptr, nullptr, nullptr);
+      stream.stream = nullptr;
+    }
+    return 0;
+  }
+
+  /**
+   * @brief Scan the next chunk of a stream
+   *
+   * Matching state is carried over from previous chunks so patterns
+   * can match across chunk boundaries.
+   *
+   * param:     string  Next chunk of data
+   * return:    table   Set of ids of patterns with matches ending in this chunk
+   */
+  auto l_stream_scan(lua_State *const L) -> int
+  {
+    auto const &stream = check_stream(L, 1);
+    auto &database = stream_database(L, 1);
+    size_t len;
+    auto const data = luaL_checklstring(L, 2, &len);
+
+    auto &matches = database.matches;
+    matches.clear();
+    auto const result = hs_scan_stream(stream.stream, data, len, 0, database.scratch, on_match, &matches);
+    check_scan_result(L, "hs_scan_stream", result);
+
+    push_matches(L, matches);
+    return 1;
+  }
+
+  /**
+   * @brief Reset a stream to its initial state
+   *
+   * return:    table   Set of ids of patterns matching at the end of the old stream
+   */
+  auto l_stream_reset(lua_State *const L) -> int
+  {
+    auto const &stream = check_stream(L, 1);
+    auto &database = stream_database(L, 1);
+
+    auto &matches = database.matches;
+    matches.clear();
+    auto const result = hs_reset_stream(stream.stream, 0, database.scratch, on_match, &matches);
+    check_scan_result(L, "hs_reset_stream", result);
+
+    push_matches(L, matches);
+    return 1;
+  }
+
+  /**
+   * @brief Close a stream
+   *
+   * return:    table   Set of ids of patterns matching at the end of the stream
+   */
+  auto l_stream_close(lua_State *const L) -> int
+  {
+    auto &stream = check_stream(L, 1);
+    auto &database = stream_database(L, 1);
+
+    auto &matches = database.matches;
+    matches.clear();
+    auto const result = hs_close_stream(stream.stream, database.scratch, on_match, &matches);
+    stream.stream = nullptr;
+    check_scan_result(L, "hs_close_stream", result);
+
+    push_matches(L, matches);
+    return 1;
+  }
+
+  luaL_Reg const StreamMT[]{
+      {"__gc", l_stream_gc},
+      {"__close", l_stream_gc},
+      {},
+  };
+
+  luaL_Reg const StreamMethods[]{
+      {"scan", l_stream_scan},
+      {"reset", l_stream_reset},
+      {"close", l_stream_close},
+      {},
+  };
+
+  /**
+   * @brief Open a new stream on a stream mode database
+   *
+   * return:    stream  Stream handle
+   */
+  auto l_database_open_stream(lua_State *const L) -> int
+  {
+    auto &database = check_database(L, 1);
+    luaL_argcheck(L, HS_MODE_STREAM == database.mode, 1, "not a stream database");
+
+    auto &stream = *static_cast<Stream *>(lua_newuserdatauv(L, sizeof(Stream), 1));
+    stream = {nullptr};
+    if (luaL_newmetatable(L, stream_name))
+    {
+      luaL_setfuncs(L, StreamMT, 0);
+      luaL_newlibtable(L, StreamMethods);
+      luaL_setfuncs(L, StreamMethods, 0);
+      lua_setfield(L, -2, "__index");
+    }
+    lua_setmetatable(L, -2);
+
+    lua_pushvalue(L, 1);
+    lua_setiuservalue(L, -2, database_uv);
+
+    auto const result = hs_open_stream(database.db, 0, &stream.stream);
+    if (HS_SUCCESS != result)
+    {
+      luaL_error(L, "hs_open_stream(%d)", int{result});
+    }
+    return 1;
+  }
+
+  /**
+   * @brief Get the mode of a database
+   *
+   * return:    string  "block", "stream", or "vectored"
+   */
+  auto l_database_mode(lua_State *const L) -> int
+  {
+    auto const &database = check_database(L, 1);
+    for (int i = 0; nullptr != mode_names[i]; i++)
+    {
+      if (mode_values[i] == database.mode)
+      {
+        lua_pushstring(L, mode_names[i]);
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  luaL_Reg const DatabaseMT[]{
+      {"__gc", l_database_gc},
+      {"__close", l_database_close},
+      {},
+  };
+
+  luaL_Reg const DatabaseMethods[]{
+      {"scan", l_database_scan},
+      {"open_stream", l_database_open_stream},
+      {"mode", l_database_mode},
+      {},
+  };
+
+  /// @brief Wrap a database in a userdata and allocate its scratch
+  auto push_database(lua_State *const L, hs_database_t *const db, unsigned const mode) -> void
+  {
+    auto &database = *std::construct_at(static_cast<Database *>(lua_newuserdatauv(L, sizeof(Database), 0)));
+    database.mode = mode;
+    if (luaL_newmetatable(L, database_name))
+    {
+      luaL_setfuncs(L, DatabaseMT, 0);
+      luaL_newlibtable(L, DatabaseMethods);
+      luaL_setfuncs(L, DatabaseMethods, 0);
+      lua_setfield(L, -2, "__index");
+    }
+    lua_setmetatable(L, -2);
+
+    // owned by the userdata from here on
+    database.db = db;
+
+    auto const result = hs_alloc_scratch(db, &database.scratch);
+    if (HS_SUCCESS != result)
+    {
+      luaL_error(L, "hs_alloc_scratch(%d)", int{result});
+    }
+  }
+
+  /**
+   * @brief Compile a database for scanning in this process
+   *
+   * param:     table    Regular expressions
+   * param:     table    Flags for each expression
+   * param:     table    Ids reported for each expression
+   * param:     string?  Mode: "block" (default), "stream", or "vectored"
+   * return[1]: database Compiled database
+   * return[2]: nil      Failure indicator
+   * return[2]: string   Error message for a rejected expression
+   * return[3]: integer  Index of the rejected expression
+   */
+  auto l_compile(lua_State *const L) -> int
+  {
+    auto const mode = mode_values[luaL_checkoption(L, 4, "block", mode_names)];
+    lua_settop(L, 3);
+    auto const [exprs, flags, ids, N] = check_patterns(L);
+
+    int bad_expression;
+    auto const db = compile_database(L, exprs, flags, ids, N, mode, nullptr, bad_expression);
+    if (nullptr == db)
+    {
+      luaL_pushfail(L);
+      lua_insert(L, -2);
+      lua_pushinteger(L, lua_Integer{bad_expression} + 1);
+      return 3;
+    }
+
+    push_database(L, db, mode);
+    return 1;
+  }
+
+  /// @brief Determine the mode of a database from its description
+  auto database_mode(hs_database_t const *const db) -> unsigned
+  {
+    char *info;
+    auto const result = hs_database_info(db, &info);
+    if (HS_SUCCESS != result)
+    {
+      return HS_MODE_BLOCK;
+    }
+
+    auto const mode = std::strstr(info, "Mode: STREAM") ? HS_MODE_STREAM
+                    : std::strstr(info, "Mode: VECTORED") ? HS_MODE_VECTORED
+                    : HS_MODE_BLOCK;
+    std::free(info);
+    return mode;
+  }
+
+  /**
+   * @brief Load a database produced by serialize_regexp_db or another process
+   *
+   * param:     string   Serialized database
+   * return:   database Loaded database
+   */
+  auto l_deserialize(lua_State *const L) -> int
+  {
+    size_t len;
+    auto const bytes = luaL_checklstring(L, 1, &len);
+
+    hs_database_t *db;
+    auto const result = hs_deserialize_database(bytes, len, &db);
+    if (HS_SUCCESS != result)
+    {
+      luaL_error(L, "hs_deserialize_database(%d)", int{result});
+    }
+
+    push_database(L, db, database_mode(db));
     return 1;
   }
 
@@ -145,6 +628,8 @@ namespace
   luaL_Reg const M[]{
       {"serialize_regexp_db", l_serialize_regexp_db},
       {"get_current_platform", l_get_current_platform},
+      {"compile", l_compile},
+      {"deserialize", l_deserialize},
       {},
   };
 
@@ -91,8 +91,8 @@ function M:_init(conn)
     end
 end
 
-function M:rawsend(str)
-    self.conn:send(str)
+function M:rawsend(str, lane)
+    return self.conn:send(str, lane)
 end
 
 function M:close()
@@ -205,7 +205,8 @@ function resume_tty()
     end
 end
 
-local function draw()
+-- Called by the client at most once per frame interval
+local function render()
     if 0 < drawing_suspended then return end;
 
     clicks = {}
@@ -230,10 +231,17 @@ local function draw()
     ncurses.doupdate()
 end
 
+-- Requests coalesce, so handlers can call this after every change
+local function draw()
+    snowcone.redraw()
+end
+
 -- Callback Logic =====================================================
 
 local M = {}
 
+M.on_frame = render
+
 local key_handlers = require 'handlers.keyboard'
 local input_handlers = require 'handlers.input'
 function M.on_keyboard(key)
@@ -424,7 +432,10 @@ function connect()
             socks_password,
             function(event, ...)
                 conn_handlers[event](...)
-            end)
+            end,
+            {batch = true,
+             send_burst = configuration.server.send_burst,
+             send_rate = configuration.server.send_rate})
 
         if conn then
             status('irc', 'connecting')
@@ -499,6 +510,17 @@ function conn_handlers.MSG(irc, flush)
     end
 end
 
+function conn_handlers.MSGS(ircs)
+    local n = #ircs
+    for i, irc in ipairs(ircs) do
+        conn_handlers.MSG(irc, i == n)
+    end
+end
+
+function conn_handlers.BAD(message)
+    status('irc', 'skipped line: %s', message)
+end
+
 function conn_handlers.CON(fingerprint)
     status('irc', 'connected: %s', fingerprint)
 
@@ -710,6 +732,10 @@ local function startup()
     local configuration_schema = require 'utils.configuration_schema'
     schema.check(configuration_schema, configuration)
 
+    if configuration.display and configuration.display.frame_interval then
+        snowcone.set_frame_interval(configuration.display.frame_interval)
+    end
+
     -- Plugins ========================================================
 
     notification_manager:load(
@@ -77,6 +77,8 @@ return table {
         capabilities        = array {type = 'string', pattern = '^[^\n\r\x00 ]+$'},
         username             = {type = 'string', pattern = '^[^\n\r\x00:]*$'},
         password             = password_schema,
+        send_burst          = {type = 'number'},
+        send_rate           = {type = 'number'},
     },
     socks = table {
         host                = {type = 'string'},
@@ -104,6 +106,9 @@ return table {
         password            = password_schema,
         use_store           = {type = 'boolean'},
     },
+    display = table {
+        frame_interval      = {type = 'number'},
+    },
     plugins = table {
         modules             = {type = 'table', elements = {type = 'string'}},
         directory           = {type = 'string'},
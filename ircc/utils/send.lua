@@ -54,6 +54,7 @@ return function(cmd, ...)
         error('message too long: ' .. #raw, 2)
     end
 
+    -- the flood-control lane is chosen natively from the command
     irc_state:rawsend(raw)
 
     messages:insert(true, msg)
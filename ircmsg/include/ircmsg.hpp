@@ -1,8 +1,9 @@
 #pragma once
 
+#include "small_vector.hpp"
+
 #include <iostream>
 #include <string_view>
-#include <vector>
 
 struct irctag
 {
@@ -12,12 +13,18 @@ struct irctag
     friend auto operator==(irctag const&, irctag const&) -> bool = default;
 };
 
+/// @brief Tag storage that avoids allocation for typical messages
+using irctags = small_vector<irctag, 8>;
+
+/// @brief Argument storage covering the RFC 1459 limit of 15 arguments
+using ircargs = small_vector<std::string_view, 15>;
+
 struct ircmsg
 {
-    std::vector<irctag> tags;
+    irctags tags;
     std::string_view source;
     std::string_view command;
-    std::vector<std::string_view> args;
+    ircargs args;
 
     friend bool operator==(ircmsg const&, ircmsg const&) = default;
 };
@@ -54,6 +61,10 @@ struct irc_parse_error final : public std::exception {
  * The original message buffer is mangled to store string fragments
  * that are pointed to by the structured message type.
  *
+ * The message is classified 16 bytes at a time, recording the positions
+ * of every space, ';', '=', and '\\' in bitmasks, and the parse is driven
+ * from those bitmasks.
+ *
  * @param msg null-terminated character buffer with raw IRC message.
  * @return parsed IRC message
  * @throw irc_parse_error on failure
@@ -68,7 +79,28 @@ auto parse_irc_message(char* msg) -> ircmsg;
  * that are pointed to by the structured message type.
  *
  * @param msg null-terminated character buffer with raw IRC tags.
- * @return parsed IRC tags vector
+ * @return parsed IRC tags
+ * @throw irc_parse_error on failure
+ */
+auto parse_irc_tags(char* msg) -> irctags;
+
+/**
+ * @brief Reference byte-at-a-time implementation of parse_irc_message
+ *
+ * Produces the same results as parse_irc_message. This is retained
+ * for differential testing of the vectorized parser.
+ *
+ * @param msg null-terminated character buffer with raw IRC message.
+ * @return parsed IRC message
+ * @throw irc_parse_error on failure
+ */
+auto parse_irc_message_scalar(char* msg) -> ircmsg;
+
+/**
+ * @brief Reference byte-at-a-time implementation of parse_irc_tags
+ *
+ * @param msg null-terminated character buffer with raw IRC tags.
+ * @return parsed IRC tags
  * @throw irc_parse_error on failure
  */
-auto parse_irc_tags(char* msg) -> std::vector<irctag>;
+auto parse_irc_tags_scalar(char* msg) -> irctags;
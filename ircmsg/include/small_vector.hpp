@@ -0,0 +1,168 @@
+#pragma once
+/**
+ * @file small_vector.hpp
+ * @brief Vector with inline storage for a small number of elements
+ *
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+
+/**
+ * @brief Contiguous container that only allocates past N elements
+ *
+ * Elements are stored inside the object until the inline capacity is
+ * exceeded, after which they move to a heap allocation that grows
+ * geometrically. This is restricted to trivially copyable element
+ * types which is all the IRC message representation needs.
+ *
+ * @tparam T Element type
+ * @tparam N Inline capacity
+ */
+template <typename T, std::size_t N>
+class small_vector
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(N > 0);
+
+    T* data_;
+    std::size_t size_;
+    std::size_t capacity_;
+    union
+    {
+        T inline_[N];
+    };
+
+    auto is_inline() const noexcept -> bool { return data_ == inline_; }
+
+    auto grow() -> void
+    {
+        auto const capacity = 2 * capacity_;
+        auto heap = std::make_unique_for_overwrite<T[]>(capacity);
+        std::copy_n(data_, size_, heap.get());
+        release();
+        data_ = heap.release();
+        capacity_ = capacity;
+    }
+
+    auto release() noexcept -> void
+    {
+        if (not is_inline())
+        {
+            delete[] data_;
+        }
+    }
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = T const*;
+
+    small_vector() noexcept
+        : data_{inline_}
+        , size_{0}
+        , capacity_{N}
+    {
+    }
+
+    small_vector(std::initializer_list<T> const elements)
+        : small_vector{}
+    {
+        for (auto&& x : elements)
+        {
+            push_back(x);
+        }
+    }
+
+    small_vector(small_vector const& rhs)
+        : small_vector{}
+    {
+        *this = rhs;
+    }
+
+    small_vector(small_vector&& rhs) noexcept
+        : small_vector{}
+    {
+        *this = std::move(rhs);
+    }
+
+    auto operator=(small_vector const& rhs) -> small_vector&
+    {
+        if (this != &rhs)
+        {
+            clear();
+            while (capacity_ < rhs.size_)
+            {
+                grow();
+            }
+            std::copy_n(rhs.data_, rhs.size_, data_);
+            size_ = rhs.size_;
+        }
+        return *this;
+    }
+
+    auto operator=(small_vector&& rhs) noexcept -> small_vector&
+    {
+        if (this != &rhs)
+        {
+            release();
+            if (rhs.is_inline())
+            {
+                data_ = inline_;
+                capacity_ = N;
+                std::copy_n(rhs.data_, rhs.size_, inline_);
+            }
+            else
+            {
+                // steal the heap allocation
+                data_ = rhs.data_;
+                capacity_ = rhs.capacity_;
+                rhs.data_ = rhs.inline_;
+                rhs.capacity_ = N;
+            }
+            size_ = rhs.size_;
+            rhs.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~small_vector() { release(); }
+
+    template <typename... Args>
+    auto emplace_back(Args&&... args) -> T&
+    {
+        if (size_ == capacity_)
+        {
+            grow();
+        }
+        return *std::construct_at(data_ + size_++, std::forward<Args>(args)...);
+    }
+
+    auto push_back(T const& x) -> void { emplace_back(x); }
+
+    /// @brief Remove all elements retaining the current allocation
+    auto clear() noexcept -> void { size_ = 0; }
+
+    auto data() noexcept -> T* { return data_; }
+    auto data() const noexcept -> T const* { return data_; }
+    auto size() const noexcept -> std::size_t { return size_; }
+    auto capacity() const noexcept -> std::size_t { return capacity_; }
+    auto empty() const noexcept -> bool { return 0 == size_; }
+
+    auto begin() noexcept -> T* { return data_; }
+    auto end() noexcept -> T* { return data_ + size_; }
+    auto begin() const noexcept -> T const* { return data_; }
+    auto end() const noexcept -> T const* { return data_ + size_; }
+
+    auto operator[](std::size_t const i) noexcept -> T& { return data_[i]; }
+    auto operator[](std::size_t const i) const noexcept -> T const& { return data_[i]; }
+
+    friend auto operator==(small_vector const& lhs, small_vector const& rhs) -> bool
+    {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+};
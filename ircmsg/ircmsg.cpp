@@ -1,6 +1,13 @@
+#include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <cstring>
 #include <optional>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "ircmsg.hpp"
 
 namespace {
@@ -115,9 +122,9 @@ std::string_view unescape_tag_value(char* const val)
 
 } // namespace
 
-auto parse_irc_tags(char* str) -> std::vector<irctag>
+auto parse_irc_tags_scalar(char* str) -> irctags
 {
-    std::vector<irctag> tags;
+    irctags tags;
 
     do {
         auto val = strsep(&str, ";");
@@ -144,14 +151,14 @@ auto parse_irc_tags(char* str) -> std::vector<irctag>
 ///
 /// @param msg The raw IRC message to parse
 /// @return ircmsg pointing into the input buffer
-auto parse_irc_message(char* const msg) -> ircmsg
+auto parse_irc_message_scalar(char* const msg) -> ircmsg
 {
     parser p {msg};
     ircmsg out;
 
     /* MESSAGE TAGS */
     if (p.match('@')) {
-        out.tags = parse_irc_tags(p.word());
+        out.tags = parse_irc_tags_scalar(p.word());
     }
 
     /* MESSAGE SOURCE */
@@ -177,6 +184,323 @@ auto parse_irc_message(char* const msg) -> ircmsg
     return out;
 }
 
+namespace {
+
+/// @brief Positions of the delimiter characters in one 16-byte chunk
+///
+/// Bit i of each mask corresponds to byte i of the chunk.
+struct delimiter_chunk
+{
+    std::uint16_t space;
+    std::uint16_t semi;
+    std::uint16_t equals;
+    std::uint16_t backslash;
+};
+
+#ifdef __SSE2__
+/// @brief Classify 16 bytes with one comparison per delimiter
+/// @param chunk Bytes to classify
+/// @param shift Number of leading bytes of chunk to discard
+auto classify_vector(__m128i const chunk, int const shift) -> delimiter_chunk
+{
+    auto const mask = [chunk, shift](char const c) -> std::uint16_t {
+        auto const bits = static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(c))));
+        return bits >> shift;
+    };
+    return {mask(' '), mask(';'), mask('='), mask('\\')};
+}
+
+/// @brief Classify up to 16 bytes using SSE2 comparisons
+///
+/// Never reads outside of [msg, msg + len).
+///
+/// @param msg Message start
+/// @param pos Offset of the chunk to classify
+/// @param len Length of the message
+auto classify_chunk(char const* const msg, std::size_t const pos, std::size_t const len) -> delimiter_chunk
+{
+    if (pos + 16 <= len)
+    {
+        return classify_vector(_mm_loadu_si128(reinterpret_cast<__m128i const*>(msg + pos)), 0);
+    }
+    else if (16 <= len)
+    {
+        // Reload the final 16 bytes of the message and discard the
+        // bytes that were already classified.
+        return classify_vector(_mm_loadu_si128(reinterpret_cast<__m128i const*>(msg + len - 16)), pos + 16 - len);
+    }
+    else
+    {
+        // Short messages are classified from a padded copy
+        char padded[16] {};
+        std::memcpy(padded, msg + pos, len - pos);
+        return classify_vector(_mm_loadu_si128(reinterpret_cast<__m128i const*>(padded)), 0);
+    }
+}
+#else
+/// @brief Classify up to 16 bytes one byte at a time
+/// @param msg Message start
+/// @param pos Offset of the chunk to classify
+/// @param len Length of the message
+auto classify_chunk(char const* const msg, std::size_t const pos, std::size_t const len) -> delimiter_chunk
+{
+    delimiter_chunk result{};
+    auto const n = std::min<std::size_t>(16, len - pos);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        auto const bit = static_cast<std::uint16_t>(1u << i);
+        switch (msg[pos + i])
+        {
+            case ' ' : result.space |= bit; break;
+            case ';' : result.semi |= bit; break;
+            case '=' : result.equals |= bit; break;
+            case '\\': result.backslash |= bit; break;
+            default: break;
+        }
+    }
+    return result;
+}
+#endif
+
+/// @brief Index of every delimiter in a message
+///
+/// Chunks are classified once, in order, the first time the parser
+/// searches into them. Trailing arguments are never searched, so
+/// their chunks are never classified.
+class delimiters
+{
+    char const* msg_;
+    std::size_t len_;
+
+    /// @brief Inline storage covers messages up to 1024 bytes
+    small_vector<delimiter_chunk, 64> chunks_;
+
+    auto chunk(std::size_t const i) -> delimiter_chunk const&
+    {
+        while (chunks_.size() <= i)
+        {
+            chunks_.push_back(classify_chunk(msg_, 16 * chunks_.size(), len_));
+        }
+        return chunks_[i];
+    }
+
+public:
+    using mask = std::uint16_t delimiter_chunk::*;
+
+    delimiters(char const* const msg, std::size_t const len)
+        : msg_{msg}
+        , len_{len}
+    {
+    }
+
+    /// @brief Find the first position in [pos, limit) with a delimiter
+    /// @tparam M Delimiter mask to search
+    /// @tparam Invert Search for positions without the delimiter
+    /// @param pos First position to search
+    /// @param limit End of search range, at most the message length
+    /// @return Position found or limit if none
+    template <mask M, bool Invert = false>
+    auto next(std::size_t pos, std::size_t const limit) -> std::size_t
+    {
+        while (pos < limit)
+        {
+            auto const offset = pos % 16;
+            unsigned bits = chunk(pos / 16).*M;
+            if constexpr (Invert)
+            {
+                bits = ~bits & 0xffff;
+            }
+            bits >>= offset;
+            if (0 != bits)
+            {
+                return std::min(limit, pos + std::countr_zero(bits));
+            }
+            pos += 16 - offset;
+        }
+        return limit;
+    }
+};
+
+/// @brief IRC message parser driven by a delimiter index
+class indexed_parser
+{
+    char* msg_;
+    std::size_t len_;
+    std::size_t pos_;
+    delimiters index_;
+
+    /// @brief Drop leading spaces
+    auto trim() -> void
+    {
+        // Single separating spaces are the common case
+        if (pos_ < len_ && msg_[pos_] == ' ') {
+            pos_ = index_.next<&delimiter_chunk::space, true>(pos_ + 1, len_);
+        }
+    }
+
+public:
+    indexed_parser(char* const msg, std::size_t const len)
+        : msg_{msg}
+        , len_{len}
+        , pos_{0}
+        , index_{msg, len}
+    {
+        trim();
+    }
+
+    indexed_parser(indexed_parser const&) = delete;
+    auto operator=(indexed_parser const&) -> indexed_parser& = delete;
+
+    /// @brief Consume and return the next space-separated token
+    auto word() -> std::string_view
+    {
+        auto const start = pos_;
+        auto const end = index_.next<&delimiter_chunk::space>(pos_, len_);
+        if (end < len_) { // prepare for next token
+            msg_[end] = '\0'; // replace space with terminator
+            pos_ = end + 1;
+            trim();
+        } else {
+            pos_ = end;
+        }
+        return {msg_ + start, end - start};
+    }
+
+    /// @brief Match and consume specified character
+    auto match(char const c) -> bool
+    {
+        if (pos_ < len_ && c == msg_[pos_]) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    /// @brief Predicate for empty string parse target
+    auto isempty() const -> bool
+    {
+        return pos_ == len_;
+    }
+
+    /// @brief Consume and return the remaining unparsed string
+    auto rest() -> std::string_view
+    {
+        auto const start = pos_;
+        pos_ = len_;
+        return {msg_ + start, len_ - start};
+    }
+
+    /// @brief Unescape a tag value in place, see unescape_tag_value
+    auto unescape(std::size_t const start, std::size_t const end) -> std::string_view
+    {
+        auto cursor = index_.next<&delimiter_chunk::backslash>(start, end);
+        auto write = cursor;
+
+        while (cursor < end)
+        {
+            // cursor is at a backslash
+            if (++cursor == end)
+            {
+                break; // drop trailing backslash
+            }
+            switch (msg_[cursor])
+            {
+                default  : msg_[write++] = msg_[cursor]; break;
+                case ':' : msg_[write++] = ';'         ; break;
+                case 's' : msg_[write++] = ' '         ; break;
+                case 'r' : msg_[write++] = '\r'        ; break;
+                case 'n' : msg_[write++] = '\n'        ; break;
+            }
+
+            // copy the run up to the next escape
+            auto const next = index_.next<&delimiter_chunk::backslash>(++cursor, end);
+            std::memmove(msg_ + write, msg_ + cursor, next - cursor);
+            write += next - cursor;
+            cursor = next;
+        }
+
+        if (write < end)
+        {
+            msg_[write] = '\0';
+        }
+        return {msg_ + start, write - start};
+    }
+
+    /// @brief Parse the tags in the range of a previously consumed word
+    auto tags(std::string_view const word) -> irctags
+    {
+        irctags result;
+        auto start = static_cast<std::size_t>(word.data() - msg_);
+        auto const end = start + word.size();
+
+        for (;;) {
+            auto const seg_end = index_.next<&delimiter_chunk::semi>(start, end);
+            auto const key_end = index_.next<&delimiter_chunk::equals>(start, seg_end);
+            if (key_end == start) {
+                throw irc_parse_error(irc_error_code::MISSING_TAG);
+            }
+
+            std::string_view const key {msg_ + start, key_end - start};
+            if (key_end == seg_end) {
+                result.emplace_back(key);
+            } else {
+                msg_[key_end] = '\0';
+                result.emplace_back(key, unescape(key_end + 1, seg_end));
+            }
+
+            if (seg_end == end) {
+                return result;
+            }
+            msg_[seg_end] = '\0';
+            start = seg_end + 1;
+        }
+    }
+};
+
+} // namespace
+
+auto parse_irc_tags(char* const str) -> irctags
+{
+    auto const len = strlen(str);
+    indexed_parser p {str, len};
+    return p.tags({str, len});
+}
+
+auto parse_irc_message(char* const msg) -> ircmsg
+{
+    static char empty[1];
+    auto const str = msg == nullptr ? empty : msg;
+    indexed_parser p {str, strlen(str)};
+    ircmsg out;
+
+    /* MESSAGE TAGS */
+    if (p.match('@')) {
+        out.tags = p.tags(p.word());
+    }
+
+    /* MESSAGE SOURCE */
+    if (p.match(':')) {
+        out.source = p.word();
+    }
+
+    /* MESSAGE COMMANDS */
+    out.command = p.word();
+    if (out.command.empty()) {
+        throw irc_parse_error{irc_error_code::MISSING_COMMAND};
+    }
+
+    /* MESSAGE ARGUMENTS */
+    while (!p.isempty()) {
+        if (p.match(':')) {
+            out.args.emplace_back(p.rest());
+            break;
+        }
+        out.args.emplace_back(p.word());
+    }
+
+    return out;
+}
+
 auto operator<<(std::ostream& out, irc_error_code const code) -> std::ostream&
 {
     switch(code) {
@@ -0,0 +1,75 @@
+/**
+ * @file lpm.hpp
+ * @author Eric Mertens (emertens@gmail.com)
+ * @brief Longest-prefix matching of network addresses
+ *
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace lpm {
+
+/**
+ * @brief Binary trie mapping network prefixes to values
+ *
+ * Networks and addresses are given in network byte order as produced by
+ * inet_pton: 4 bytes for IPv4 and 16 bytes for IPv6. The two address
+ * families are kept in separate subtries so a prefix never matches an
+ * address of the other family.
+ */
+class Trie
+{
+    struct Node
+    {
+        /// Indexes of the 0 and 1 children; 0 when absent as roots are never children
+        std::array<std::uint32_t, 2> children {};
+        std::optional<std::uint32_t> value;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<std::uint32_t> free_;
+
+    auto new_node() -> std::uint32_t;
+
+public:
+    Trie();
+
+    /**
+     * @brief Associate a value with a network prefix
+     *
+     * Bits of the network beyond the prefix length are ignored.
+     *
+     * @param network Network address bytes
+     * @param prefix Number of leading bits of network to match
+     * @return false when the address length or prefix length is invalid
+     */
+    auto insert(std::string_view network, std::size_t prefix, std::uint32_t value) -> bool;
+
+    /**
+     * @brief Remove the value associated with a network prefix
+     *
+     * @param network Network address bytes
+     * @param prefix Number of leading bits of network to match
+     * @return Value that was removed, if any
+     */
+    auto erase(std::string_view network, std::size_t prefix) -> std::optional<std::uint32_t>;
+
+    /**
+     * @brief Find the value of the most specific prefix covering an address
+     *
+     * @param address Address bytes
+     * @return Value of longest matching prefix, if any
+     */
+    auto match(std::string_view address) const -> std::optional<std::uint32_t>;
+
+    /// @brief Remove all prefixes
+    auto clear() -> void;
+};
+
+} // namespace lpm
@@ -0,0 +1,143 @@
+#include "lpm.hpp"
+
+#include <utility>
+
+namespace lpm {
+
+namespace {
+
+/// Node index of the IPv4 subtrie root
+constexpr std::uint32_t ipv4_root = 0;
+/// Node index of the IPv6 subtrie root
+constexpr std::uint32_t ipv6_root = 1;
+
+/// Longest path from a root to a node: one IPv6 address
+constexpr std::size_t max_depth = 128;
+
+auto root_of(std::string_view const address) -> std::optional<std::uint32_t>
+{
+    switch (address.size())
+    {
+        case 4: return ipv4_root;
+        case 16: return ipv6_root;
+        default: return std::nullopt;
+    }
+}
+
+auto bit_at(std::string_view const address, std::size_t const i) -> unsigned
+{
+    return (static_cast<unsigned char>(address[i / 8]) >> (7 - i % 8)) & 1;
+}
+
+} // namespace
+
+Trie::Trie()
+    : nodes_(2)
+{
+}
+
+auto Trie::new_node() -> std::uint32_t
+{
+    if (free_.empty())
+    {
+        nodes_.emplace_back();
+        return nodes_.size() - 1;
+    }
+    auto const i = free_.back();
+    free_.pop_back();
+    return i;
+}
+
+auto Trie::insert(std::string_view const network, std::size_t const prefix, std::uint32_t const value) -> bool
+{
+    auto const root = root_of(network);
+    if (not root || prefix > 8 * network.size())
+    {
+        return false;
+    }
+
+    auto cursor = *root;
+    for (std::size_t i = 0; i < prefix; i++)
+    {
+        auto const b = bit_at(network, i);
+        auto next = nodes_[cursor].children[b];
+        if (0 == next)
+        {
+            next = new_node(); // invalidates references into nodes_
+            nodes_[cursor].children[b] = next;
+        }
+        cursor = next;
+    }
+    nodes_[cursor].value = value;
+    return true;
+}
+
+auto Trie::erase(std::string_view const network, std::size_t const prefix) -> std::optional<std::uint32_t>
+{
+    auto const root = root_of(network);
+    if (not root || prefix > 8 * network.size())
+    {
+        return std::nullopt;
+    }
+
+    std::array<std::uint32_t, max_depth + 1> path;
+    path[0] = *root;
+    for (std::size_t i = 0; i < prefix; i++)
+    {
+        path[i + 1] = nodes_[path[i]].children[bit_at(network, i)];
+        if (0 == path[i + 1])
+        {
+            return std::nullopt;
+        }
+    }
+
+    auto const result = std::exchange(nodes_[path[prefix]].value, std::nullopt);
+
+    // Release the chain of nodes that no longer lead to any value
+    for (auto depth = prefix; depth > 0; depth--)
+    {
+        auto& node = nodes_[path[depth]];
+        if (node.value || node.children[0] || node.children[1])
+        {
+            break;
+        }
+        nodes_[path[depth - 1]].children[bit_at(network, depth - 1)] = 0;
+        free_.push_back(path[depth]);
+    }
+
+    return result;
+}
+
+auto Trie::match(std::string_view const address) const -> std::optional<std::uint32_t>
+{
+    auto const root = root_of(address);
+    if (not root)
+    {
+        return std::nullopt;
+    }
+
+    auto const* node = &nodes_[*root];
+    auto result = node->value;
+    for (std::size_t i = 0; i < 8 * address.size(); i++)
+    {
+        auto const next = node->children[bit_at(address, i)];
+        if (0 == next)
+        {
+            break;
+        }
+        node = &nodes_[next];
+        if (node->value)
+        {
+            result = node->value;
+        }
+    }
+    return result;
+}
+
+auto Trie::clear() -> void
+{
+    nodes_.assign(2, Node{});
+    free_.clear();
+}
+
+} // namespace lpm
@@ -0,0 +1,11 @@
+/**
+ * @file mylpm.hpp
+ * @author Eric Mertens (emertens@gmail.com)
+ * @brief Network prefix counters for Lua
+ *
+ */
+#pragma once
+
+struct lua_State;
+
+extern "C" auto luaopen_mylpm(lua_State* const L) -> int;
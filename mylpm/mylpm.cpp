@@ -0,0 +1,315 @@
+#include "mylpm.hpp"
+
+#include "lpm.hpp"
+
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+char const tracker_name[] = "mylpm.tracker";
+
+/**
+ * @brief Counter attached to a labeled network prefix
+ */
+struct Entry
+{
+    std::string label;
+    /// Network with the bits beyond the prefix cleared
+    std::string network;
+    std::size_t prefix;
+    lua_Integer count;
+};
+
+/**
+ * @brief Collection of counters selected by longest prefix match
+ */
+struct Tracker
+{
+    lpm::Trie trie;
+    std::vector<std::optional<Entry>> entries;
+    std::vector<std::uint32_t> unused;
+    std::map<std::string, std::uint32_t, std::less<>> labels;
+    lua_Integer total = 0;
+
+    auto find(std::string_view const label) -> Entry*
+    {
+        auto const it = labels.find(label);
+        return it == labels.end() ? nullptr : &*entries[it->second];
+    }
+
+    /// @brief Forget the entry and restore any other entry sharing its prefix
+    auto remove(std::uint32_t const id) -> void
+    {
+        auto const entry = std::move(*entries[id]);
+        entries[id].reset();
+        unused.push_back(id);
+        labels.erase(entry.label);
+        total -= entry.count;
+
+        auto const active = trie.erase(entry.network, entry.prefix);
+        if (active == id)
+        {
+            for (std::uint32_t i = 0; i < entries.size(); i++)
+            {
+                if (entries[i] && entries[i]->prefix == entry.prefix && entries[i]->network == entry.network)
+                {
+                    trie.insert(entry.network, entry.prefix, i);
+                    break;
+                }
+            }
+        }
+        else if (active)
+        {
+            // Another label with the same prefix was the active one
+            trie.insert(entry.network, entry.prefix, *active);
+        }
+    }
+};
+
+auto check_tracker(lua_State* const L, int const arg) -> Tracker&
+{
+    return *static_cast<Tracker*>(luaL_checkudata(L, arg, tracker_name));
+}
+
+/// @brief Clear the bits of network beyond prefix
+auto mask_network(std::string_view const network, std::size_t const prefix) -> std::string
+{
+    std::string result(network.size(), '\0');
+    auto const bytes = prefix / 8;
+    network.copy(result.data(), bytes);
+    if (auto const bits = prefix % 8)
+    {
+        result[bytes] = network[bytes] & static_cast<char>(0xff00 >> bits);
+    }
+    return result;
+}
+
+/**
+ * @brief Start counting addresses within a network
+ *
+ * Tracking an existing label replaces its network and resets its count.
+ *
+ * param:     string  label    Name of the counter
+ * param:     string  network  Network address as returned by snowcone.pton
+ * param:     integer prefix   Prefix length in bits
+ *
+ * @param L Lua state
+ * @return int 0
+ */
+auto l_track(lua_State* const L) -> int
+{
+    auto& tracker = check_tracker(L, 1);
+    std::size_t label_len, network_len;
+    auto const label = luaL_checklstring(L, 2, &label_len);
+    auto const network = luaL_checklstring(L, 3, &network_len);
+    auto const prefix = luaL_checkinteger(L, 4);
+
+    luaL_argcheck(L, network_len == 4 || network_len == 16, 3, "expected IPv4 or IPv6 address");
+    luaL_argcheck(L, 0 <= prefix && prefix <= lua_Integer(8 * network_len), 4, "prefix length out of range");
+
+    if (auto const it = tracker.labels.find(std::string_view{label, label_len}); it != tracker.labels.end())
+    {
+        tracker.remove(it->second);
+    }
+
+    std::uint32_t id;
+    if (tracker.unused.empty())
+    {
+        id = tracker.entries.size();
+        tracker.entries.emplace_back();
+    }
+    else
+    {
+        id = tracker.unused.back();
+        tracker.unused.pop_back();
+    }
+
+    auto& entry = tracker.entries[id].emplace(
+        std::string{label, label_len},
+        mask_network({network, network_len}, prefix),
+        prefix,
+        0
+    );
+    tracker.labels.emplace(entry.label, id);
+    tracker.trie.insert(entry.network, entry.prefix, id);
+    return 0;
+}
+
+/**
+ * @brief Stop counting the network with the given label
+ *
+ * param:     string  label    Name of the counter
+ *
+ * @param L Lua state
+ * @return int 0
+ */
+auto l_untrack(lua_State* const L) -> int
+{
+    auto& tracker = check_tracker(L, 1);
+    std::size_t len;
+    auto const label = luaL_checklstring(L, 2, &len);
+
+    if (auto const it = tracker.labels.find(std::string_view{label, len}); it != tracker.labels.end())
+    {
+        tracker.remove(it->second);
+    }
+    return 0;
+}
+
+/**
+ * @brief Overwrite the count of a label
+ *
+ * param:     string  label    Name of the counter
+ * param:     integer count    New count
+ *
+ * @param L Lua state
+ * @return int 0
+ */
+auto l_set(lua_State* const L) -> int
+{
+    auto& tracker = check_tracker(L, 1);
+    std::size_t len;
+    auto const label = luaL_checklstring(L, 2, &len);
+    auto const count = luaL_checkinteger(L, 3);
+
+    if (auto const entry = tracker.find({label, len}))
+    {
+        tracker.total += count - entry->count;
+        entry->count = count;
+    }
+    return 0;
+}
+
+/**
+ * @brief Adjust the count of the most specific network containing an address
+ *
+ * param:     string  address  Address as returned by snowcone.pton
+ * param:     integer delta    Amount to add to the count
+ * return[1]: string  label    Label of the adjusted counter
+ * return[2]: nil              No tracked network contains the address
+ *
+ * @param L Lua state
+ * @return int 1
+ */
+auto l_delta(lua_State* const L) -> int
+{
+    auto& tracker = check_tracker(L, 1);
+    std::size_t len;
+    auto const address = luaL_checklstring(L, 2, &len);
+    auto const delta = luaL_checkinteger(L, 3);
+
+    if (auto const id = tracker.trie.match({address, len}))
+    {
+        auto& entry = *tracker.entries[*id];
+        entry.count += delta;
+        tracker.total += delta;
+        lua_pushlstring(L, entry.label.data(), entry.label.size());
+    }
+    else
+    {
+        luaL_pushfail(L);
+    }
+    return 1;
+}
+
+/**
+ * @brief Get the count of one label or of all labels combined
+ *
+ * param:     string? label    Name of the counter
+ * return[1]: integer count
+ * return[2]: nil              Label is not tracked
+ *
+ * @param L Lua state
+ * @return int 1
+ */
+auto l_count(lua_State* const L) -> int
+{
+    auto& tracker = check_tracker(L, 1);
+    if (lua_isnoneornil(L, 2))
+    {
+        lua_pushinteger(L, tracker.total);
+        return 1;
+    }
+
+    std::size_t len;
+    auto const label = luaL_checklstring(L, 2, &len);
+    if (auto const entry = tracker.find({label, len}))
+    {
+        lua_pushinteger(L, entry->count);
+    }
+    else
+    {
+        luaL_pushfail(L);
+    }
+    return 1;
+}
+
+auto l_gc(lua_State* const L) -> int
+{
+    std::destroy_at(&check_tracker(L, 1));
+    return 0;
+}
+
+/**
+ * @brief Construct an empty tracker
+ *
+ * return: tracker
+ *
+ * @param L Lua state
+ * @return int 1
+ */
+auto l_new(lua_State* const L) -> int
+{
+    static luaL_Reg const MT[] {
+        {"__gc", l_gc},
+        {}
+    };
+
+    static luaL_Reg const Methods[] {
+        {"track", l_track},
+        {"untrack", l_untrack},
+        {"set", l_set},
+        {"delta", l_delta},
+        {"count", l_count},
+        {}
+    };
+
+    auto const tracker = static_cast<Tracker*>(lua_newuserdatauv(L, sizeof(Tracker), 0));
+
+    if (luaL_newmetatable(L, tracker_name))
+    {
+        luaL_setfuncs(L, MT, 0);
+        luaL_newlib(L, Methods);
+        lua_setfield(L, -2, "__index");
+    }
+    lua_setmetatable(L, -2);
+
+    std::construct_at(tracker);
+    return 1;
+}
+
+} // namespace
+
+extern "C" auto luaopen_mylpm(lua_State* const L) -> int
+{
+    static luaL_Reg const M[] {
+        {"new", l_new},
+        {}
+    };
+
+    luaL_newlib(L, M);
+    return 1;
+}
@@ -0,0 +1,344 @@
+#define _XOPEN_SOURCE 600
+
+#include "grid.h"
+
+#include <ncurses.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+static struct cell const blank = {L' ', WA_NORMAL, 0};
+
+/// @brief Sentinel that never matches a drawn cell
+static struct cell const unknown = {(wchar_t)-1, WA_NORMAL, 0};
+
+static bool cell_eq(struct cell const* const a, struct cell const* const b)
+{
+    return a->ch == b->ch && a->attr == b->attr && a->pair == b->pair;
+}
+
+static struct cell* back_row(struct grid* const grid, int const y)
+{
+    return grid->back + (size_t)y * grid->cols;
+}
+
+static struct cell* front_row(struct grid* const grid, int const y)
+{
+    return grid->front + (size_t)y * grid->cols;
+}
+
+static void* alloc(size_t const n, size_t const size)
+{
+    // calloc(0) may return NULL; keep that distinct from failure
+    return calloc(n ? n : 1, size);
+}
+
+bool grid_resize(struct grid* const grid, int rows, int cols)
+{
+    if (rows <= 0 || cols <= 0)
+    {
+        rows = cols = 0;
+    }
+
+    size_t const cells = (size_t)rows * cols;
+    struct cell* const back = alloc(cells, sizeof *back);
+    struct cell* const front = alloc(cells, sizeof *front);
+    bool* const dirty = alloc(rows, sizeof *dirty);
+    cchar_t* const line = alloc(cols, sizeof *line);
+
+    if (!back || !front || !dirty || !line)
+    {
+        free(back);
+        free(front);
+        free(dirty);
+        free(line);
+        return false;
+    }
+
+    grid_free(grid);
+    grid->rows = rows;
+    grid->cols = cols;
+    grid->back = back;
+    grid->front = front;
+    grid->dirty = dirty;
+    grid->line = line;
+
+    for (size_t i = 0; i < cells; i++)
+    {
+        back[i] = blank;
+    }
+    grid_invalidate(grid);
+    grid->y = grid->x = 0;
+    return true;
+}
+
+void grid_free(struct grid* const grid)
+{
+    free(grid->back);
+    free(grid->front);
+    free(grid->dirty);
+    free(grid->line);
+    grid->back = grid->front = NULL;
+    grid->dirty = NULL;
+    grid->line = NULL;
+    grid->rows = grid->cols = 0;
+}
+
+void grid_erase(struct grid* const grid)
+{
+    for (int y = 0; y < grid->rows; y++)
+    {
+        struct cell* const row = back_row(grid, y);
+        for (int x = 0; x < grid->cols; x++)
+        {
+            if (!cell_eq(&row[x], &blank))
+            {
+                row[x] = blank;
+                grid->dirty[y] = true;
+            }
+        }
+    }
+    grid->y = grid->x = 0;
+}
+
+void grid_invalidate(struct grid* const grid)
+{
+    size_t const cells = (size_t)grid->rows * grid->cols;
+    for (size_t i = 0; i < cells; i++)
+    {
+        grid->front[i] = unknown;
+    }
+    for (int y = 0; y < grid->rows; y++)
+    {
+        grid->dirty[y] = true;
+    }
+}
+
+bool grid_move(struct grid* const grid, int const y, int const x)
+{
+    if (y < 0 || x < 0 || y >= grid->rows || x >= grid->cols)
+    {
+        return false;
+    }
+    grid->y = y;
+    grid->x = x;
+    return true;
+}
+
+void grid_getyx(struct grid const* const grid, int* const y, int* const x)
+{
+    *y = grid->y < grid->rows ? grid->y : grid->rows - 1;
+    *x = grid->x < grid->cols ? grid->x : grid->cols - 1;
+}
+
+/// @brief True while the drawing position is inside the grid
+static bool can_draw(struct grid const* const grid)
+{
+    return grid->y < grid->rows && grid->x < grid->cols;
+}
+
+/// @brief Blank cells from the drawing position to the end of the row
+static void clear_to_eol(struct grid* const grid)
+{
+    if (!can_draw(grid))
+    {
+        return;
+    }
+
+    struct cell* const row = back_row(grid, grid->y);
+    int x = grid->x;
+
+    // A wide character starting to the left loses its right half
+    if (0 < x && 0 == row[x].ch)
+    {
+        x--;
+    }
+    for (; x < grid->cols; x++)
+    {
+        row[x] = blank;
+    }
+    grid->dirty[grid->y] = true;
+}
+
+/// @brief Advance to the start of the next row, sticking at the bottom edge
+static void next_row(struct grid* const grid)
+{
+    if (grid->y + 1 < grid->rows)
+    {
+        grid->y++;
+        grid->x = 0;
+    }
+    else
+    {
+        grid->x = grid->cols;
+    }
+}
+
+static void put(struct grid* const grid, wchar_t const ch, int const width)
+{
+    // Wide characters that don't fit wrap as a whole
+    if (can_draw(grid) && grid->cols < grid->x + width)
+    {
+        clear_to_eol(grid);
+        next_row(grid);
+    }
+    if (!can_draw(grid) || grid->cols < grid->x + width)
+    {
+        return;
+    }
+
+    struct cell* const row = back_row(grid, grid->y);
+    int const x = grid->x;
+    int const end = x + width;
+
+    // Don't leave half of an overwritten wide character behind
+    if (0 < x && 0 == row[x].ch)
+    {
+        row[x - 1] = blank;
+    }
+    if (end < grid->cols && 0 == row[end].ch)
+    {
+        row[end] = blank;
+    }
+
+    row[x] = (struct cell){ch, grid->attr, grid->pair};
+    for (int i = x + 1; i < end; i++)
+    {
+        row[i] = (struct cell){L'\0', grid->attr, grid->pair};
+    }
+    grid->dirty[grid->y] = true;
+
+    grid->x = end;
+    if (grid->x == grid->cols)
+    {
+        next_row(grid);
+    }
+}
+
+static void put_char(struct grid* const grid, wchar_t const ch)
+{
+    switch (ch)
+    {
+    case L'\n':
+        clear_to_eol(grid);
+        next_row(grid);
+        return;
+    case L'\r':
+        grid->x = 0;
+        return;
+    case L'\b':
+        if (0 < grid->x)
+        {
+            grid->x--;
+        }
+        return;
+    case L'\t':
+        do
+        {
+            put(grid, L' ', 1);
+        }
+        while (can_draw(grid) && 0 != grid->x % 8);
+        return;
+    }
+
+    if (ch < 0x20 || 0x7f == ch)
+    {
+        put(grid, L'^', 1);
+        put(grid, 0x7f == ch ? L'?' : ch + 0x40, 1);
+        return;
+    }
+
+    int const width = wcwidth(ch);
+    if (0 < width)
+    {
+        put(grid, ch, width);
+    }
+    else if (width < 0)
+    {
+        put(grid, L'?', 1);
+    }
+    // Combining characters are dropped
+}
+
+void grid_addnstr(struct grid* const grid, char const* str, size_t len)
+{
+    mbstate_t state;
+    memset(&state, 0, sizeof state);
+
+    while (0 < len && can_draw(grid))
+    {
+        wchar_t ch;
+        size_t const n = mbrtowc(&ch, str, len, &state);
+        if ((size_t)-1 == n || (size_t)-2 == n)
+        {
+            // Show undecodable bytes one at a time
+            put(grid, L'?', 1);
+            memset(&state, 0, sizeof state);
+            str++;
+            len--;
+        }
+        else if (0 == n)
+        {
+            // waddnstr stops at a NUL byte
+            return;
+        }
+        else
+        {
+            put_char(grid, ch);
+            str += n;
+            len -= n;
+        }
+    }
+}
+
+int grid_flush(struct grid* const grid, WINDOW* const win)
+{
+    int written = 0;
+
+    for (int y = 0; y < grid->rows; y++)
+    {
+        if (!grid->dirty[y])
+        {
+            continue;
+        }
+        grid->dirty[y] = false;
+
+        struct cell* const back = back_row(grid, y);
+        struct cell* const front = front_row(grid, y);
+
+        int x = 0;
+        while (x < grid->cols && cell_eq(&back[x], &front[x]))
+        {
+            x++;
+        }
+        if (x == grid->cols)
+        {
+            continue;
+        }
+
+        // Wide characters occupy one entry covering both of their cells
+        int n = 0;
+        for (x = 0; x < grid->cols; x++)
+        {
+            if (0 != back[x].ch)
+            {
+                wchar_t const wch[2] = {back[x].ch, L'\0'};
+                setcchar(&grid->line[n++], wch, back[x].attr, back[x].pair, NULL);
+            }
+        }
+        mvwadd_wchnstr(win, y, 0, grid->line, n);
+
+        memcpy(front, back, (size_t)grid->cols * sizeof *back);
+        written++;
+    }
+
+    if (0 < grid->rows)
+    {
+        int y, x;
+        grid_getyx(grid, &y, &x);
+        wmove(win, y, x);
+    }
+
+    return written;
+}
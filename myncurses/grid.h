@@ -0,0 +1,115 @@
+#ifndef MYNCURSES_GRID_H
+#define MYNCURSES_GRID_H
+
+#include <ncurses.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief One character cell
+ *
+ * The right half of a wide character is stored as a cell with a zero
+ * character.
+ */
+struct cell
+{
+    wchar_t ch;
+    attr_t attr;
+    short pair;
+};
+
+/**
+ * @brief Retained screen contents with per-row damage tracking
+ *
+ * Drawing follows the stdscr rules of waddnstr and writes into the back
+ * buffer, marking each row it touches as dirty. Flushing only looks at
+ * dirty rows and only rewrites the ones that differ from the front
+ * buffer, which holds what was last written to the window. Redrawing a
+ * mostly unchanged frame then costs little more than producing it.
+ */
+struct grid
+{
+    int rows;
+    int cols;
+
+    /// @brief Contents being drawn, rows * cols cells
+    struct cell* back;
+
+    /// @brief Contents last written to the window, rows * cols cells
+    struct cell* front;
+
+    /// @brief Rows written since the last flush
+    bool* dirty;
+
+    /// @brief Scratch row handed to ncurses while flushing
+    cchar_t* line;
+
+    /// @brief Drawing position
+    int y, x;
+
+    /// @brief Drawing attributes and color pair
+    attr_t attr;
+    short pair;
+};
+
+/**
+ * @brief Change the grid dimensions
+ *
+ * The contents are erased and the front buffer is invalidated. A grid
+ * that starts zeroed can be resized into use.
+ *
+ * @return false when memory could not be allocated, leaving the grid unchanged
+ */
+bool grid_resize(struct grid* grid, int rows, int cols);
+
+/// @brief Release the grid's buffers
+void grid_free(struct grid* grid);
+
+/// @brief Blank the back buffer and move to the top-left corner
+void grid_erase(struct grid* grid);
+
+/// @brief Forget the window's contents so the next flush rewrites every row
+void grid_invalidate(struct grid* grid);
+
+/**
+ * @brief Set the drawing position
+ *
+ * @return false when the position is outside the grid
+ */
+bool grid_move(struct grid* grid, int y, int x);
+
+/**
+ * @brief Get the cursor position
+ *
+ * Like getyx, this reports the last cell after drawing into the
+ * bottom-right corner.
+ */
+void grid_getyx(struct grid const* grid, int* y, int* x);
+
+/**
+ * @brief Draw multibyte text with the current attributes
+ *
+ * Text wraps at the right edge and stops at the bottom-right corner.
+ * Control characters are drawn in ^X notation as waddnstr does.
+ */
+void grid_addnstr(struct grid* grid, char const* str, size_t len);
+
+/**
+ * @brief Write changed rows to a window the size of the grid
+ *
+ * The window's cursor is left at the drawing position.
+ *
+ * @return Number of rows written
+ */
+int grid_flush(struct grid* grid, WINDOW* win);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -9,6 +11,34 @@ struct lua_State;
 int luaopen_myncurses(struct lua_State* L);
 void l_ncurses_resize(struct lua_State* L);
 
+/**
+ * @brief Find the color pair for a foreground and background, assigning one on first use
+ *
+ * @param fore Foreground color from -1 to 7
+ * @param back Background color from -1 to 7
+ * @return Color pair, or 0 when every pair is assigned
+ */
+int myncurses_colorpair(int fore, int back);
+
+/// @brief Run of text drawn with one set of attributes
+struct myncurses_span
+{
+    char const* text;
+    size_t len;
+    unsigned int attr;
+    short pair;
+};
+
+/**
+ * @brief Draw spans at the cursor as ncurses.addspans does
+ *
+ * @param L Lua state
+ * @param win_arg Stack index of an optional window argument
+ * @param spans Spans to draw
+ * @param n Number of spans
+ */
+void myncurses_addspans(struct lua_State* L, int win_arg, struct myncurses_span const* spans, size_t n);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,6 +1,8 @@
 #define _XOPEN_SOURCE 600
 
 #include "myncurses.h"
+#include "grid.h"
+#include "screen.h"
 #include "window.h"
 
 #include <lauxlib.h>
@@ -12,6 +14,14 @@
 
 static int l_erase(lua_State* const L)
 {
+    struct grid* const grid = drawtarget(L, 1);
+    if (grid)
+    {
+        screen_fit(L, grid);
+        grid_erase(grid);
+        return 0;
+    }
+
     WINDOW* const win = optwindow(L, 1);
 
     if (ERR == werase(win))
@@ -23,19 +33,35 @@ static int l_erase(lua_State* const L)
 
 static int l_clear(lua_State* const L)
 {
+    struct grid* const grid = drawtarget(L, 1);
     WINDOW* const win = optwindow(L, 1);
 
     if (ERR == wclear(win))
     {
         return luaL_error(L, "clear: ncurses error");
     }
+
+    // The window was blanked behind the screen's back
+    if (grid)
+    {
+        screen_fit(L, grid);
+        grid_erase(grid);
+        grid_invalidate(grid);
+    }
     return 0;
 }
 
 static int l_refresh(lua_State* const L)
 {
+    struct grid* const grid = drawtarget(L, 1);
     WINDOW* const win = optwindow(L, 1);
 
+    if (grid)
+    {
+        screen_fit(L, grid);
+        grid_flush(grid, win);
+    }
+
     if (ERR == wrefresh(win))
     {
         return luaL_error(L, "refresh: ncurses error");
@@ -45,8 +71,15 @@ static int l_refresh(lua_State* const L)
 
 static int l_noutrefresh(lua_State* const L)
 {
+    struct grid* const grid = drawtarget(L, 1);
     WINDOW* const win = optwindow(L, 1);
 
+    if (grid)
+    {
+        screen_fit(L, grid);
+        grid_flush(grid, win);
+    }
+
     if (ERR == wnoutrefresh(win))
     {
         return luaL_error(L, "wnoutrefresh: ncurses error");
@@ -57,6 +90,14 @@ static int l_noutrefresh(lua_State* const L)
 static int l_attron(lua_State* const L)
 {
     lua_Integer const a = luaL_checkinteger(L, 1);
+
+    struct grid* const grid = drawtarget(L, 2);
+    if (grid)
+    {
+        grid->attr |= a & ~A_COLOR;
+        return 0;
+    }
+
     WINDOW* const win = optwindow(L, 2);
 
     if (ERR == wattr_on(win, a, NULL))
@@ -69,6 +110,14 @@ static int l_attron(lua_State* const L)
 static int l_attroff(lua_State* const L)
 {
     lua_Integer const a = luaL_checkinteger(L, 1);
+
+    struct grid* const grid = drawtarget(L, 2);
+    if (grid)
+    {
+        grid->attr &= ~(a & ~A_COLOR);
+        return 0;
+    }
+
     WINDOW* const win = optwindow(L, 2);
 
     if (ERR == wattr_off(win, a, NULL))
@@ -80,6 +129,14 @@ static int l_attroff(lua_State* const L)
 
 static int l_attrget(lua_State* const L)
 {
+    struct grid* const grid = drawtarget(L, 1);
+    if (grid)
+    {
+        lua_pushinteger(L, grid->attr);
+        lua_pushinteger(L, grid->pair);
+        return 2;
+    }
+
     WINDOW* const win = optwindow(L, 1);
 
     attr_t attrs;
@@ -98,6 +155,15 @@ static int l_attrset(lua_State* const L)
 {
     int const a = luaL_checkinteger(L, 1);
     int const color = luaL_checkinteger(L, 2);
+
+    struct grid* const grid = drawtarget(L, 3);
+    if (grid)
+    {
+        grid->attr = a & ~A_COLOR;
+        grid->pair = color;
+        return 0;
+    }
+
     WINDOW* const win = optwindow(L, 3);
 
     if (ERR == wattr_set(win, a, color, NULL))
@@ -109,12 +175,20 @@ static int l_attrset(lua_State* const L)
 
 static int l_addstr(lua_State* const L)
 {
+    struct grid* const grid = drawtarget(L, 0);
     int const n = lua_gettop(L);
     for (int i = 1; i <= n; i++)
     {
         size_t len;
         char const* const str = luaL_checklstring(L, i, &len);
-        addnstr(str, len);
+        if (grid)
+        {
+            grid_addnstr(grid, str, len);
+        }
+        else
+        {
+            addnstr(str, len);
+        }
     }
     return 0;
 }
@@ -126,6 +200,20 @@ static int l_mvaddstr(lua_State* const L)
     size_t len;
     int const n = lua_gettop(L);
 
+    struct grid* const grid = drawtarget(L, 0);
+    if (grid)
+    {
+        if (grid_move(grid, y, x))
+        {
+            for (int i = 3; i <= n; i++)
+            {
+                char const* const str = luaL_checklstring(L, i, &len);
+                grid_addnstr(grid, str, len);
+            }
+        }
+        return 0;
+    }
+
     int wy, wx;
     getmaxyx(stdscr, wy, wx);
 
@@ -150,8 +238,171 @@ static int l_mvaddstr(lua_State* const L)
     return 0;
 }
 
+/// @brief Destination of a run of spans and the attributes to restore afterward
+struct span_writer
+{
+    struct grid* grid;
+    WINDOW* win;
+    attr_t saved_attr;
+    short saved_pair;
+};
+
+static void spans_begin(lua_State* const L, int const win_arg, struct span_writer* const w)
+{
+    w->grid = drawtarget(L, win_arg);
+    w->win = optwindow(L, win_arg);
+    if (w->grid)
+    {
+        w->saved_attr = w->grid->attr;
+        w->saved_pair = w->grid->pair;
+    }
+    else
+    {
+        wattr_get(w->win, &w->saved_attr, &w->saved_pair, NULL);
+    }
+}
+
+static void span_draw(
+    struct span_writer const* const w, char const* const str, size_t const len, attr_t const attr, short const pair)
+{
+    if (w->grid)
+    {
+        w->grid->attr = attr & ~A_COLOR;
+        w->grid->pair = pair;
+        grid_addnstr(w->grid, str, len);
+    }
+    else
+    {
+        wattr_set(w->win, attr, pair, NULL);
+        (void)waddnstr(w->win, str, len);
+        // waddnstr emits spurious errors writing to the end of a line
+    }
+}
+
+static void spans_end(struct span_writer const* const w, int* const y, int* const x)
+{
+    if (w->grid)
+    {
+        w->grid->attr = w->saved_attr;
+        w->grid->pair = w->saved_pair;
+        grid_getyx(w->grid, y, x);
+    }
+    else
+    {
+        wattr_set(w->win, w->saved_attr, w->saved_pair, NULL);
+        getyx(w->win, *y, *x);
+    }
+}
+
+void myncurses_addspans(lua_State* const L, int const win_arg, struct myncurses_span const* const spans, size_t const n)
+{
+    struct span_writer w;
+    spans_begin(L, win_arg, &w);
+    for (size_t i = 0; i < n; i++)
+    {
+        span_draw(&w, spans[i].text, spans[i].len, spans[i].attr, spans[i].pair);
+    }
+    int y, x;
+    spans_end(&w, &y, &x);
+}
+
+/**
+ * @brief Draw a row of attributed text in one call
+ *
+ * Lua arguments:
+ * 1. row, or nil to continue from the cursor
+ * 2. column, or nil to continue from the cursor
+ * 3. spans: flat sequence of text, attributes and color pair triples
+ * 4. window (optional)
+ *
+ * Each span is drawn with exactly its own attributes and the drawing
+ * attributes are restored afterward. Like mvaddstr, nothing is drawn
+ * when the position is off the window.
+ *
+ * Returns the cursor position after drawing.
+ */
+static int l_addspans(lua_State* const L)
+{
+    bool const positioned = !lua_isnoneornil(L, 1) || !lua_isnoneornil(L, 2);
+    lua_Integer const y = positioned ? luaL_checkinteger(L, 1) : 0;
+    lua_Integer const x = positioned ? luaL_checkinteger(L, 2) : 0;
+    luaL_checktype(L, 3, LUA_TTABLE);
+    lua_Integer const n = luaL_len(L, 3);
+    luaL_argcheck(L, 0 == n % 3, 3, "expected text, attributes and color triples");
+
+    struct span_writer w;
+    spans_begin(L, 4, &w);
+
+    if (positioned)
+    {
+        int wy, wx;
+        if (w.grid)
+        {
+            wy = w.grid->rows;
+            wx = w.grid->cols;
+        }
+        else
+        {
+            getmaxyx(w.win, wy, wx);
+        }
+
+        if (y < 0 || x < 0 || wy <= y || wx <= x)
+        {
+            lua_pushinteger(L, y);
+            lua_pushinteger(L, x);
+            return 2;
+        }
+
+        if (w.grid)
+        {
+            grid_move(w.grid, y, x);
+        }
+        else
+        {
+            wmove(w.win, y, x);
+        }
+    }
+
+    int cy, cx;
+    for (lua_Integer i = 1; i <= n; i += 3)
+    {
+        lua_rawgeti(L, 3, i);
+        lua_rawgeti(L, 3, i + 1);
+        lua_rawgeti(L, 3, i + 2);
+
+        size_t len;
+        char const* const str = lua_tolstring(L, -3, &len);
+        int attr_ok, pair_ok;
+        lua_Integer const attr = lua_tointegerx(L, -2, &attr_ok);
+        lua_Integer const pair = lua_tointegerx(L, -1, &pair_ok);
+        if (!str || !attr_ok || !pair_ok)
+        {
+            spans_end(&w, &cy, &cx);
+            return luaL_error(L, "addspans: malformed span at index %d", (int)i);
+        }
+
+        span_draw(&w, str, len, attr, pair);
+        lua_pop(L, 3);
+    }
+
+    spans_end(&w, &cy, &cx);
+    lua_pushinteger(L, cy);
+    lua_pushinteger(L, cx);
+    return 2;
+}
+
 static int l_getyx(lua_State* const L)
 {
+    struct grid* const grid = drawtarget(L, 1);
+    if (grid)
+    {
+        int y, x;
+        grid_getyx(grid, &y, &x);
+        lua_pushinteger(L, y);
+        lua_pushinteger(L, x);
+        return 2;
+    }
+
     WINDOW* const win = optwindow(L, 1);
 
     int y, x;
@@ -181,20 +432,12 @@ static int l_doupdate(lua_State* const L)
     return 0;
 }
 
-static int l_colorset(lua_State* const L)
+int myncurses_colorpair(int const fore, int const back)
 {
     // map [fore][back] to a pair number - zero for unassigned (except for [-1][-1])
     static int color_map[9][9]; // colors range from -1 to 7
     static int assigned = 1;
 
-    lua_Integer fore = luaL_optinteger(L, 1, -1);
-    luaL_argcheck(L, -1 <= fore && fore <= 7, 1, "out of range");
-
-    lua_Integer back = luaL_optinteger(L, 2, -1);
-    luaL_argcheck(L, -1 <= back && back <= 7, 2, "out of range");
-
-    WINDOW* const win = optwindow(L, 3);
-
     int* pair = &color_map[fore + 1][back + 1];
     if (0 == *pair && (fore >= 0 || back >= 0))
     {
@@ -204,8 +447,41 @@ static int l_colorset(lua_State* const L)
             init_pair(*pair, fore, back);
         }
     }
+    return *pair;
+}
+
+static int l_colorpair(lua_State* const L)
+{
+    lua_Integer fore = luaL_optinteger(L, 1, -1);
+    luaL_argcheck(L, -1 <= fore && fore <= 7, 1, "out of range");
+
+    lua_Integer back = luaL_optinteger(L, 2, -1);
+    luaL_argcheck(L, -1 <= back && back <= 7, 2, "out of range");
+
+    lua_pushinteger(L, myncurses_colorpair(fore, back));
+    return 1;
+}
+
+static int l_colorset(lua_State* const L)
+{
+    lua_Integer fore = luaL_optinteger(L, 1, -1);
+    luaL_argcheck(L, -1 <= fore && fore <= 7, 1, "out of range");
+
+    lua_Integer back = luaL_optinteger(L, 2, -1);
+    luaL_argcheck(L, -1 <= back && back <= 7, 2, "out of range");
+
+    int const pair = myncurses_colorpair(fore, back);
+
+    struct grid* const grid = drawtarget(L, 3);
+    if (grid)
+    {
+        grid->pair = pair;
+        return 0;
+    }
+
+    WINDOW* const win = optwindow(L, 3);
 
-    if (ERR == wcolor_set(win, *pair, NULL))
+    if (ERR == wcolor_set(win, pair, NULL))
     {
         return luaL_error(L, "color_set: ncurses error");
     }
@@ -217,6 +493,17 @@ static int l_move(lua_State* const L)
 {
     lua_Integer y = luaL_checkinteger(L, 1);
     lua_Integer x = luaL_checkinteger(L, 2);
+
+    struct grid* const grid = drawtarget(L, 3);
+    if (grid)
+    {
+        if (!grid_move(grid, y, x))
+        {
+            return luaL_error(L, "move");
+        }
+        return 0;
+    }
+
     WINDOW* const win = optwindow(L, 3);
     if (ERR == wmove(win, y, x))
     {
@@ -252,6 +539,7 @@ static int l_beep(lua_State* const L)
 static luaL_Reg lib[] = {
     {"addstr", l_addstr},
     {"mvaddstr", l_mvaddstr},
+    {"addspans", l_addspans},
     {"getyx", l_getyx},
     {"getmaxyx", l_getmaxyx},
 
@@ -265,6 +553,7 @@ static luaL_Reg lib[] = {
     {"attrset", l_attrset},
     {"attrget", l_attrget},
     {"colorset", l_colorset},
+    {"colorpair", l_colorpair},
 
     {"cursset", l_cursset},
     {"move", l_move},
@@ -273,6 +562,8 @@ static luaL_Reg lib[] = {
 
     {"newwin", l_newwin},
     {"newpad", l_newpad},
+    {"newscreen", l_newscreen},
+    {"settarget", l_settarget},
     {"doupdate", l_doupdate},
     {0},
 };
@@ -0,0 +1,104 @@
+#define _XOPEN_SOURCE 600
+
+#include "screen.h"
+
+#include "grid.h"
+
+#include <lauxlib.h>
+#include <lua.h>
+
+#include <ncurses.h>
+
+#include <string.h>
+
+static char const screen_name[] = "screen";
+
+/// @brief Registry key holding the current target screen
+static char const target_key[] = "myncurses.target";
+
+/// @brief Grid of the screen stored under target_key
+static struct grid* target;
+
+struct grid* checkscreen(lua_State* const L, int const arg)
+{
+    return luaL_checkudata(L, arg, screen_name);
+}
+
+struct grid* drawtarget(lua_State* const L, int const arg)
+{
+    return 0 == arg || lua_isnoneornil(L, arg) ? target : NULL;
+}
+
+void screen_fit(lua_State* const L, struct grid* const grid)
+{
+    int rows, cols;
+    getmaxyx(stdscr, rows, cols);
+    if ((rows != grid->rows || cols != grid->cols) && !grid_resize(grid, rows, cols))
+    {
+        luaL_error(L, "screen: out of memory");
+    }
+}
+
+static int l_gc(lua_State* const L)
+{
+    grid_free(checkscreen(L, 1));
+    return 0;
+}
+
+static int l_invalidate(lua_State* const L)
+{
+    grid_invalidate(checkscreen(L, 1));
+    return 0;
+}
+
+static int l_flush(lua_State* const L)
+{
+    struct grid* const grid = checkscreen(L, 1);
+    screen_fit(L, grid);
+    lua_pushinteger(L, grid_flush(grid, stdscr));
+    return 1;
+}
+
+static luaL_Reg const MT[] = {
+    {"__gc", l_gc},
+    {0}
+};
+
+static luaL_Reg const Methods[] = {
+    {"invalidate", l_invalidate},
+    {"flush", l_flush},
+    {0}
+};
+
+int l_newscreen(lua_State* const L)
+{
+    struct grid* const grid = lua_newuserdatauv(L, sizeof *grid, 0);
+    memset(grid, 0, sizeof *grid);
+    screen_fit(L, grid);
+
+    if (luaL_newmetatable(L, screen_name))
+    {
+        luaL_setfuncs(L, MT, 0);
+        luaL_newlibtable(L, Methods);
+        luaL_setfuncs(L, Methods, 0);
+        lua_setfield(L, -2, "__index");
+    }
+    lua_setmetatable(L, -2);
+    return 1;
+}
+
+int l_settarget(lua_State* const L)
+{
+    struct grid* const grid = lua_isnoneornil(L, 1) ? NULL : checkscreen(L, 1);
+
+    // The registry keeps the target alive while C holds its address
+    lua_settop(L, 1);
+    lua_setfield(L, LUA_REGISTRYINDEX, target_key);
+    target = grid;
+
+    if (grid)
+    {
+        grid_invalidate(grid);
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+#ifndef MYNCURSES_SCREEN_H
+#define MYNCURSES_SCREEN_H
+
+struct grid;
+struct lua_State;
+
+/**
+ * @brief Match a screen argument
+ *
+ * @param L Lua state
+ * @param arg Stack index
+ * @return Pointer to the screen's grid
+ */
+struct grid* checkscreen(struct lua_State* L, int arg);
+
+/**
+ * @brief Find the screen receiving stdscr drawing
+ *
+ * Functions that take an optional window draw into this screen when
+ * the window is omitted.
+ *
+ * @param L Lua state
+ * @param arg Stack index of the optional window argument, 0 when there is none
+ * @return Target screen's grid or NULL to draw on the window
+ */
+struct grid* drawtarget(struct lua_State* L, int arg);
+
+/**
+ * @brief Match the grid to the size of stdscr
+ *
+ * @param L Lua state
+ * @param grid Grid to resize
+ */
+void screen_fit(struct lua_State* L, struct grid* grid);
+
+int l_newscreen(struct lua_State*);
+
+int l_settarget(struct lua_State*);
+
+#endif
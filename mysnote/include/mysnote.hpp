@@ -0,0 +1,11 @@
+/**
+ * @file mysnote.hpp
+ * @author Eric Mertens (emertens@gmail.com)
+ * @brief Server notice classification for Lua
+ *
+ */
+#pragma once
+
+struct lua_State;
+
+extern "C" auto luaopen_mysnote(lua_State* const L) -> int;
@@ -0,0 +1,128 @@
+#include "mysnote.hpp"
+
+#include "snote.hpp"
+
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+#include <cctype>
+#include <charconv>
+#include <string>
+#include <string_view>
+
+namespace {
+
+auto push_string_view(lua_State* const L, std::string_view const str) -> void
+{
+    lua_pushlstring(L, str.data(), str.size());
+}
+
+/**
+ * @brief Push a field value converted according to its notice type
+ *
+ * Numeric conversions that fail push nothing.
+ *
+ * @param L Lua state
+ * @param field Field to push
+ * @return true when a value was pushed
+ */
+auto push_field(lua_State* const L, snote::Field const& field) -> bool
+{
+    switch (field.conversion)
+    {
+        case snote::Conversion::Text:
+            push_string_view(L, field.value);
+            return true;
+
+        case snote::Conversion::Lower:
+        {
+            luaL_Buffer B;
+            auto const output = luaL_buffinitsize(L, &B, field.value.size());
+            for (std::size_t i = 0; i < field.value.size(); i++)
+            {
+                output[i] = std::tolower(static_cast<unsigned char>(field.value[i]));
+            }
+            luaL_pushresultsize(&B, field.value.size());
+            return true;
+        }
+
+        case snote::Conversion::Integer:
+        {
+            lua_Integer n;
+            auto const [last, ec] = std::from_chars(field.value.data(), field.value.data() + field.value.size(), n);
+            if (ec == std::errc{} && last == field.value.data() + field.value.size())
+            {
+                lua_pushinteger(L, n);
+                return true;
+            }
+            return false;
+        }
+
+        case snote::Conversion::Number:
+            return 0 != lua_stringtonumber(L, std::string{field.value}.c_str());
+    }
+    return false;
+}
+
+/**
+ * @brief Classify a server notice
+ *
+ * The resulting table has a name field identifying the notice type,
+ * the given server and time fields, and the fields specific to that
+ * notice type.
+ *
+ * param:     string? time    Timestamp to store in the event
+ * param:     string  server  Server that sent the notice
+ * param:     string  text    Notice text with the "*** Notice -- " prefix removed
+ * return[1]: table   event
+ * return[2]: nil     unrecognized notice
+ *
+ * @param L Lua state
+ * @return int 1
+ */
+auto l_parse(lua_State* const L) -> int
+{
+    std::size_t len;
+    auto const text = luaL_checklstring(L, 3, &len);
+
+    auto const notice = snote::parse({text, len});
+    if (not notice)
+    {
+        luaL_pushfail(L);
+        return 1;
+    }
+
+    auto const fields = notice->fields();
+    lua_createtable(L, 0, fields.size() + 3);
+
+    push_string_view(L, notice->name);
+    lua_setfield(L, -2, "name");
+    lua_pushvalue(L, 2);
+    lua_setfield(L, -2, "server");
+    lua_pushvalue(L, 1);
+    lua_setfield(L, -2, "time");
+
+    for (auto&& field : fields)
+    {
+        if (push_field(L, field))
+        {
+            lua_setfield(L, -2, std::string{field.key}.c_str());
+        }
+    }
+    return 1;
+}
+
+} // namespace
+
+extern "C" auto luaopen_mysnote(lua_State* const L) -> int
+{
+    static const luaL_Reg M[] {
+        {"parse", l_parse},
+        {}
+    };
+
+    luaL_newlib(L, M);
+    return 1;
+}
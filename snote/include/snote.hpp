@@ -0,0 +1,71 @@
+/**
+ * @file snote.hpp
+ * @author Eric Mertens (emertens@gmail.com)
+ * @brief Classification of IRC server notices
+ *
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace snote {
+
+/**
+ * @brief Interpretation of a captured field value
+ */
+enum class Conversion
+{
+    /// Value is used as-is
+    Text,
+    /// Value is lowercased
+    Lower,
+    /// Value is an integer
+    Integer,
+    /// Value is any number
+    Number,
+};
+
+/**
+ * @brief Named field extracted from a server notice
+ */
+struct Field
+{
+    std::string_view key;
+    std::string_view value;
+    Conversion conversion;
+};
+
+/**
+ * @brief Result of classifying a server notice
+ *
+ * Field values refer either into the notice text or into static storage.
+ */
+struct Notice
+{
+    /// Maximum number of fields any notice type produces
+    static constexpr std::size_t max_fields = 8;
+
+    std::string_view name;
+    std::array<Field, max_fields> storage;
+    std::size_t n_fields;
+
+    auto fields() const -> std::span<Field const> { return {storage.data(), n_fields}; }
+};
+
+/**
+ * @brief Classify a server notice and extract its fields
+ *
+ * All notice types are compiled once into a dispatch table keyed on the
+ * leading word of the notice so that only the few candidate formats
+ * sharing that word are attempted.
+ *
+ * @param text Server notice text with the "*** Notice -- " prefix removed
+ * @return Classified notice, or nullopt when the notice is not recognized
+ */
+auto parse(std::string_view text) -> std::optional<Notice>;
+
+} // namespace snote
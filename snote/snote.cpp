@@ -0,0 +1,564 @@
+#include "snote.hpp"
+
+#include <array>
+#include <bitset>
+#include <cctype>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace snote {
+
+namespace {
+
+/// @brief How a capture is turned into a notice field
+enum class Capture
+{
+    Text,
+    Lower,
+    Integer,
+    Number,
+    /// IP address where "0" means unknown and omits the field
+    Ip,
+    /// Ban type that selects the notice name
+    BanKind,
+};
+
+struct FieldSpec
+{
+    std::string_view key;
+    Capture capture;
+};
+
+/// @brief Notice format written as an anchored Lua pattern
+struct Rule
+{
+    std::string_view name;
+    std::string_view pattern;
+    std::vector<FieldSpec> fields;
+    std::string_view constant_key = {};
+    std::string_view constant_value = {};
+};
+
+// Listed in priority order; the first matching rule wins.
+std::vector<Rule> const rules{
+    {"connect", "^Client connecting: (%S+) %(([^@ ]+)@([^) ]+)%) %[(.*)%] {(%S*)} <(%S*)> %[(.*)%]$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"ip", Capture::Ip},
+         {"class", Capture::Text}, {"account", Capture::Text}, {"gecos", Capture::Text}}},
+    {"disconnect", "^Client exiting: (%S+) %(([^@ ]+)@([^) ]+)%) %[(.*)%] %[(.*)%]$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"reason", Capture::Text},
+         {"ip", Capture::Ip}}},
+    {"", "^([^!]+)!([^@]+)@([^{]+){([^}]*)} added %S+ (%d+) min%. (%S+) for %[(%S*)%] %[(.*)%]$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"oper", Capture::Text},
+         {"duration", Capture::Integer}, {"kind", Capture::BanKind}, {"mask", Capture::Text},
+         {"reason", Capture::Text}}},
+    {"nick", "^Nick change: From (%S+) to (%S+) %[([^@ ]+)@(%S+)%]$",
+        {{"old", Capture::Text}, {"new", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}}},
+    {"filter", "^FILTER: ([^! ]+)!([^@ ]+)@(%S+) %[(.*)%]$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"ip", Capture::Ip}}},
+    {"kline_active", "^KLINE active for (%S+)%[([^@ ]+)@(%S+)%] %((.*)%)$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"mask", Capture::Text}}},
+    {"kline_active", "^Disconnecting K%-Lined user (%S+)%[([^@ ]+)@(%S+)%] %((.*)%)$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"mask", Capture::Text}}},
+    {"dline_active", "^Disconnecting D%-Lined user (%S+)%[([^@ ]+)@(%S+)%] %((.*)%)$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"mask", Capture::Text}}},
+    {"expired", "^Temporary (%S+) for %[(.*)%] expired$",
+        {{"kind", Capture::Lower}, {"mask", Capture::Text}}},
+    {"expired", "^Propagated ban for %[(.*)%] expired$",
+        {{"mask", Capture::Text}}, "kind", "k-line"},
+    {"removed", "^([^! ]+)!([^@ ]+)@([^{ ]+){(%S*)} has removed the %S+ (%S+) for: %[(.*)%]$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"oper", Capture::Text},
+         {"kind", Capture::Lower}, {"mask", Capture::Text}}},
+    {"rejected", "^Rejecting (%S+)d user (%S+)%[([^@ ]+)@(%S+)%] %[(.*)%]$",
+        {{"kind", Capture::Lower}, {"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text},
+         {"mask", Capture::Text}}},
+    {"rejected", "^Rejecting (%S+)d user (%S+)%[([^@ ]+)@(%S+)%] %[(%S*)%] %((.*)%)$",
+        {{"kind", Capture::Lower}, {"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text},
+         {"ip", Capture::Ip}, {"mask", Capture::Text}}},
+    {"netsplit", "^Netsplit (%S+) <%-> (%S+) %((%S+) (%S+)%) %((.*)%)$",
+        {{"server1", Capture::Text}, {"server2", Capture::Text}, {"sid1", Capture::Text}, {"sid2", Capture::Text},
+         {"reason", Capture::Text}}},
+    {"netjoin", "^Netjoin (%S+) <%-> (%S+) %((%S+) (%S+)%)$",
+        {{"server1", Capture::Text}, {"server2", Capture::Text}, {"sid1", Capture::Text}, {"sid2", Capture::Text}}},
+    {"kill", "^Received KILL message for ([^! ]+)!([^@ ]+)@(%S+)%. From (%S+) Path: %S+ %((.*)%)$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"from", Capture::Text},
+         {"reason", Capture::Text}}},
+    // some kills don't have paths
+    {"kill", "^Received KILL message for ([^! ]+)!([^@ ]+)@(%S+)%. From (%S+) %((.*)%)$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"from", Capture::Text},
+         {"reason", Capture::Text}}},
+    {"newmaxlocal", "^New Max Local Clients: (%d+)$",
+        {{"clients", Capture::Integer}}},
+    {"flooder", "^Possible Flooder (%S+)%[([^@ ]+)@(%S+)%] on %S+ target: (%S+)$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"target", Capture::Text}}},
+    {"spambot", "^User (%S+) %(([^@ ]+)@(%S*)%) trying to join (%S+) is a possible spambot$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"target", Capture::Text}}},
+    {"targetchange", "^Excessive target change from (%S+) %(([^@ ]+)@(.*)%)$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}}},
+    {"create_channel", "^(%S+) is creating new channel (%S+)$",
+        {{"nick", Capture::Text}, {"channel", Capture::Text}}},
+    {"operspy", "^OPERSPY ([^! ]+)!([^@ ]+)@([^{ ]+){([^} ]*)} (%S+) (.*)$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"oper", Capture::Text},
+         {"token", Capture::Text}, {"arg", Capture::Text}}},
+    {"override", "^([^! ]+)!([^@ ]+)@([^{]+){([^}]*)} is using oper%-override on (%S+) %((.*)%)$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"oper", Capture::Text},
+         {"target", Capture::Text}, {"kind", Capture::Text}}},
+    {"toomany", "^Too many (%S+) connections for ([^! ]+)!([^@ ]+)@(%S+)$",
+        {{"kind", Capture::Text}, {"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}}},
+    {"toomany", "^Too many (%S+) connections for (%S+)%[([^@ ]+)@(%S+)%] %[(.*)%]$",
+        {{"kind", Capture::Text}, {"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text},
+         {"ip", Capture::Ip}}},
+    // SASL login failure
+    {"badlogin", "^Warning: \x02([^\x02]+)\x02 failed login attempts to \x02([^\x02]+)\x02%. Last attempt received from \x02<Unknown user on %S+ %(via SASL%):([^\x02]+)>\x02",
+        {{"count", Capture::Number}, {"account", Capture::Text}, {"host", Capture::Text}}},
+    // NickServ login failure
+    {"badlogin", "^Warning: \x02([^\x02]+)\x02 failed login attempts to \x02([^\x02]+)\x02%. Last attempt received from \x02([^!]+)!([^@]+)@([^\x02]+)\x02",
+        {{"count", Capture::Number}, {"account", Capture::Text}, {"nick", Capture::Text}, {"user", Capture::Text},
+         {"host", Capture::Text}}},
+    {"oper", "^(%S+) %(([^@ ]*)@(%S*)%) is now an operator$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}}},
+    {"grant", "^([^! ]+)!([^@ ]+)@([^{]+){([^}]*)} is opering (%S+) with privilege set (%S+)$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"oper", Capture::Text},
+         {"target", Capture::Text}, {"privset", Capture::Text}}},
+    {"grant", "^([^! ]+)!([^@ ]+)@([^{]+){([^}]*)} is changing the privilege set of (%S+) to (%S+)$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"oper", Capture::Text},
+         {"target", Capture::Text}, {"privset", Capture::Text}}},
+    {"ungrant", "^([^! ]+)!([^@ ]+)@([^{]+){([^}]*)} is deopering (%S+)%.$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"oper", Capture::Text},
+         {"target", Capture::Text}}},
+    // Previous implementation, useful for oftc-hybrid
+    {"connect", "^Client connecting: (%S+) %(([^@ ]+)@(%S+)%) %[(%S*)%] {(%S*)} %[(.*)%]$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"ip", Capture::Ip},
+         {"class", Capture::Text}, {"gecos", Capture::Text}}},
+    {"modload", "^Module ([^ ]+) %[.*%] loaded at [^ ]+$",
+        {{"module", Capture::Text}}},
+    {"modunload", "^Module ([^ ]+) unloaded$",
+        {{"module", Capture::Text}}},
+    {"shedding_on", "^([^!]+)!([^@]+)@([^{]+){([^}]*)} enabled user shedding %(interval: ([0-9]+) seconds, reason: (.*)%)$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"oper", Capture::Text},
+         {"interval", Capture::Number}, {"reason", Capture::Text}}},
+    {"shedding_off", "^([^!]+)!([^@]+)@([^{]+){([^}]*)} disabled user shedding$",
+        {{"nick", Capture::Text}, {"user", Capture::Text}, {"host", Capture::Text}, {"oper", Capture::Text}}},
+};
+
+std::map<std::string_view, std::string_view, std::less<>> const simple{
+    {"Filtering enabled.", "filtering_enabled"},
+    {"Filtering disabled.", "filtering_disabled"},
+    {"New filters loaded.", "filtering_loaded"},
+    {"Got signal SIGUSR1, reloading ircd motd file", "rehash_motd"},
+    {"Got signal SIGHUP, reloading ircd conf. file", "rehash_config"},
+};
+
+std::map<std::string_view, std::string_view, std::less<>> const ban_names{
+    {"K-Line", "kline"},
+    {"X-Line", "xline"},
+    {"D-Line", "dline"},
+    {"RESV", "resv"},
+};
+
+using CharSet = std::bitset<256>;
+
+/// @brief Element of a compiled pattern
+struct Item
+{
+    enum class Kind
+    {
+        Literal, // exact text
+        One,     // one character from set
+        Star,    // zero or more characters from set
+        Plus,    // one or more characters from set
+        Open,    // start of capture
+        Close,   // end of capture
+    };
+
+    Kind kind;
+    std::string literal = {};
+    CharSet set = {};
+    std::size_t capture = 0;
+};
+
+/// @brief Anchored pattern compiled from the subset of Lua pattern syntax used by the rules
+struct Pattern
+{
+    static constexpr std::size_t max_captures = Notice::max_fields;
+
+    std::vector<Item> items;
+    std::size_t n_captures = 0;
+    bool anchored_end = false;
+};
+
+using Captures = std::array<std::string_view, Pattern::max_captures>;
+
+auto class_set(char const c) -> CharSet
+{
+    CharSet set;
+    for (int i = 0; i < 256; i++)
+    {
+        switch (c)
+        {
+            case 'd':
+                set[i] = '0' <= i && i <= '9';
+                break;
+            case 's':
+            case 'S':
+                set[i] = i == ' ' || ('\t' <= i && i <= '\r');
+                break;
+            default:
+                throw std::logic_error{"unsupported character class"};
+        }
+    }
+    return c == 'S' ? ~set : set;
+}
+
+auto char_set(unsigned char const c) -> CharSet
+{
+    CharSet set;
+    set[c] = true;
+    return set;
+}
+
+/// @brief Parse a single-character pattern element
+/// @param[in,out] p Pattern text starting at the element, advanced past it
+/// @param[out] literal Set to true when the element matches exactly one character
+auto parse_single(std::string_view& p, bool& literal) -> CharSet
+{
+    literal = false;
+    auto const c = p.front();
+    p.remove_prefix(1);
+
+    if (c == '.')
+    {
+        return ~CharSet{};
+    }
+
+    if (c == '%')
+    {
+        auto const e = p.front();
+        p.remove_prefix(1);
+        if (std::isalpha(static_cast<unsigned char>(e)))
+        {
+            return class_set(e);
+        }
+        literal = true;
+        return char_set(e);
+    }
+
+    if (c == '[')
+    {
+        CharSet set;
+        auto const negate = p.front() == '^';
+        if (negate)
+        {
+            p.remove_prefix(1);
+        }
+        while (p.front() != ']')
+        {
+            if (p.front() == '%')
+            {
+                auto const e = p[1];
+                set |= std::isalpha(static_cast<unsigned char>(e)) ? class_set(e) : char_set(e);
+                p.remove_prefix(2);
+            }
+            else if (p.size() > 2 && p[1] == '-' && p[2] != ']')
+            {
+                for (int i = static_cast<unsigned char>(p[0]); i <= static_cast<unsigned char>(p[2]); i++)
+                {
+                    set[i] = true;
+                }
+                p.remove_prefix(3);
+            }
+            else
+            {
+                set[static_cast<unsigned char>(p.front())] = true;
+                p.remove_prefix(1);
+            }
+        }
+        p.remove_prefix(1); // ]
+        return negate ? ~set : set;
+    }
+
+    literal = true;
+    return char_set(c);
+}
+
+auto compile(std::string_view p) -> Pattern
+{
+    if (not p.starts_with('^'))
+    {
+        throw std::logic_error{"unanchored pattern"};
+    }
+    p.remove_prefix(1);
+
+    Pattern pattern;
+    std::size_t open = 0;
+
+    while (not p.empty())
+    {
+        if (p.front() == '(')
+        {
+            open = pattern.n_captures++;
+            if (pattern.n_captures > Pattern::max_captures)
+            {
+                throw std::logic_error{"too many captures"};
+            }
+            pattern.items.push_back({.kind = Item::Kind::Open, .capture = open});
+            p.remove_prefix(1);
+        }
+        else if (p.front() == ')')
+        {
+            pattern.items.push_back({.kind = Item::Kind::Close, .capture = open});
+            p.remove_prefix(1);
+        }
+        else if (p == "$")
+        {
+            pattern.anchored_end = true;
+            p.remove_prefix(1);
+        }
+        else
+        {
+            auto const first = p;
+            bool literal;
+            auto const set = parse_single(p, literal);
+            auto const quantifier = p.empty() ? '\0' : p.front();
+
+            if (quantifier == '+' || quantifier == '*')
+            {
+                auto const kind = quantifier == '+' ? Item::Kind::Plus : Item::Kind::Star;
+                pattern.items.push_back({.kind = kind, .set = set});
+                p.remove_prefix(1);
+            }
+            else if (quantifier == '-' || quantifier == '?')
+            {
+                throw std::logic_error{"unsupported quantifier"};
+            }
+            else if (literal)
+            {
+                auto const c = first.front() == '%' ? first[1] : first.front();
+                if (pattern.items.empty() || pattern.items.back().kind != Item::Kind::Literal)
+                {
+                    pattern.items.push_back({.kind = Item::Kind::Literal});
+                }
+                pattern.items.back().literal += c;
+            }
+            else
+            {
+                pattern.items.push_back({.kind = Item::Kind::One, .set = set});
+            }
+        }
+    }
+    return pattern;
+}
+
+/// @brief Backtracking matcher with the same semantics as Lua's string.match
+struct Matcher
+{
+    Pattern const& pattern;
+    std::string_view text;
+    std::array<std::size_t, Pattern::max_captures> starts;
+    Captures& captures;
+
+    auto match(std::size_t const i, std::size_t const pos) -> bool
+    {
+        if (i == pattern.items.size())
+        {
+            return not pattern.anchored_end || pos == text.size();
+        }
+
+        auto const& item = pattern.items[i];
+        switch (item.kind)
+        {
+            case Item::Kind::Literal:
+                return text.substr(pos).starts_with(item.literal) && match(i + 1, pos + item.literal.size());
+
+            case Item::Kind::One:
+                return pos < text.size() && item.set[static_cast<unsigned char>(text[pos])] && match(i + 1, pos + 1);
+
+            case Item::Kind::Star:
+            case Item::Kind::Plus:
+            {
+                auto end = pos;
+                while (end < text.size() && item.set[static_cast<unsigned char>(text[end])])
+                {
+                    end++;
+                }
+                auto const min = item.kind == Item::Kind::Plus ? pos + 1 : pos;
+                if (end < min)
+                {
+                    return false;
+                }
+                // Greedy: try the longest run first and give back characters
+                for (;; end--)
+                {
+                    if (match(i + 1, end))
+                    {
+                        return true;
+                    }
+                    if (end == min)
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            case Item::Kind::Open:
+                starts[item.capture] = pos;
+                return match(i + 1, pos);
+
+            case Item::Kind::Close:
+                captures[item.capture] = text.substr(starts[item.capture], pos - starts[item.capture]);
+                return match(i + 1, pos);
+        }
+        return false;
+    }
+};
+
+/// @brief Rules compiled and indexed by the leading word of their format
+struct Dispatch
+{
+    std::vector<Pattern> patterns;
+
+    /// Rules whose format starts with a fixed word, keyed by that word
+    std::map<std::string, std::vector<std::size_t>, std::less<>> by_word;
+
+    /// Rules whose format starts with a capture, with a literal that must appear
+    std::vector<std::pair<std::size_t, std::string>> generic;
+
+    Dispatch()
+    {
+        patterns.reserve(rules.size());
+        for (std::size_t r = 0; r < rules.size(); r++)
+        {
+            auto const& pattern = patterns.emplace_back(compile(rules[r].pattern));
+            if (pattern.n_captures != rules[r].fields.size())
+            {
+                throw std::logic_error{"field count mismatch"};
+            }
+
+            auto const& first = pattern.items.front();
+            auto const prefix = first.kind == Item::Kind::Literal ? std::string_view{first.literal} : std::string_view{};
+            if (auto const space = prefix.find(' '); space != prefix.npos)
+            {
+                by_word[std::string{prefix.substr(0, space)}].push_back(r);
+            }
+            else
+            {
+                std::string required;
+                for (auto&& item : pattern.items)
+                {
+                    if (item.kind == Item::Kind::Literal && item.literal.size() > required.size())
+                    {
+                        required = item.literal;
+                    }
+                }
+                generic.emplace_back(r, std::move(required));
+            }
+        }
+    }
+
+    auto try_rule(std::size_t const r, std::string_view const text) const -> std::optional<Notice>
+    {
+        Captures captures;
+        Matcher matcher{patterns[r], text, {}, captures};
+        if (not matcher.match(0, 0))
+        {
+            return std::nullopt;
+        }
+
+        auto const& rule = rules[r];
+        Notice notice{.name = rule.name, .storage = {}, .n_fields = 0};
+        for (std::size_t i = 0; i < rule.fields.size(); i++)
+        {
+            auto const [key, capture] = rule.fields[i];
+            auto const value = captures[i];
+            switch (capture)
+            {
+                case Capture::Ip:
+                    if (value != "0")
+                    {
+                        notice.storage[notice.n_fields++] = {key, value, Conversion::Text};
+                    }
+                    break;
+                case Capture::BanKind:
+                    if (auto const it = ban_names.find(value); it != ban_names.end())
+                    {
+                        notice.name = it->second;
+                    }
+                    else
+                    {
+                        return std::nullopt;
+                    }
+                    break;
+                case Capture::Text:
+                    notice.storage[notice.n_fields++] = {key, value, Conversion::Text};
+                    break;
+                case Capture::Lower:
+                    notice.storage[notice.n_fields++] = {key, value, Conversion::Lower};
+                    break;
+                case Capture::Integer:
+                    notice.storage[notice.n_fields++] = {key, value, Conversion::Integer};
+                    break;
+                case Capture::Number:
+                    notice.storage[notice.n_fields++] = {key, value, Conversion::Number};
+                    break;
+            }
+        }
+        if (not rule.constant_key.empty())
+        {
+            notice.storage[notice.n_fields++] = {rule.constant_key, rule.constant_value, Conversion::Text};
+        }
+        return notice;
+    }
+
+    auto parse(std::string_view const text) const -> std::optional<Notice>
+    {
+        // Candidates from the word bucket and the generic list are tried
+        // together in rule order to preserve rule priority.
+        static std::vector<std::size_t> const none;
+        auto const word_it = by_word.find(text.substr(0, text.find(' ')));
+        auto const& words = word_it == by_word.end() ? none : word_it->second;
+
+        auto w = words.begin();
+        auto g = generic.begin();
+        while (w != words.end() || g != generic.end())
+        {
+            std::optional<Notice> result;
+            if (g == generic.end() || (w != words.end() && *w < g->first))
+            {
+                result = try_rule(*w++, text);
+            }
+            else
+            {
+                auto const& [r, required] = *g++;
+                if (text.find(required) != text.npos)
+                {
+                    result = try_rule(r, text);
+                }
+            }
+            if (result)
+            {
+                return result;
+            }
+        }
+
+        if (auto const it = simple.find(text); it != simple.end())
+        {
+            return Notice{.name = it->second, .storage = {}, .n_fields = 0};
+        }
+
+        return std::nullopt;
+    }
+};
+
+} // namespace
+
+auto parse(std::string_view const text) -> std::optional<Notice>
+{
+    static Dispatch const dispatch;
+    return dispatch.parse(text);
+}
+
+} // namespace snote
@@ -0,0 +1,133 @@
+/**
+ * @file bench-ircmsg.cpp
+ * @brief Measure parse_irc_message throughput and heap allocations
+ *
+ * Usage: bench-ircmsg [CAPTURE [ITERATIONS]]
+ *
+ * The capture file contains one raw IRC message per line. When no
+ * capture is given a representative mix of messages is used.
+ */
+
+#include <ircmsg.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::size_t allocations = 0;
+
+auto sample_messages() -> std::vector<std::string>
+{
+    return {
+        "@time=2024-01-01T00:00:00.000Z :irc.example.net NOTICE * :*** Notice -- Client connecting: nick (user@192.0.2.1) [192.0.2.1] {users} <*> [Real Name]",
+        "@time=2024-01-01T00:00:00.000Z :irc.example.net NOTICE * :*** Notice -- Client exiting: nick (user@192.0.2.1) [Quit: bye] [192.0.2.1]",
+        ":nick!user@host PRIVMSG #channel :Hello, world.",
+        "@account=someone;msgid=abcdef;time=2024-01-01T00:00:00.000Z :nick!user@host PRIVMSG #channel :tagged",
+        ":irc.example.net 353 me = #channel :one two three four five six seven",
+        "PING :irc.example.net",
+    };
+}
+
+auto read_capture(char const* const path) -> std::vector<std::string>
+{
+    std::ifstream in{path};
+    if (not in)
+    {
+        std::cerr << "failed to open " << path << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);)
+    {
+        if (not line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (not line.empty())
+        {
+            lines.push_back(std::move(line));
+        }
+    }
+    return lines;
+}
+
+} // namespace
+
+auto operator new(std::size_t const n) -> void*
+{
+    allocations++;
+    if (auto const p = std::malloc(n ? n : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+auto operator delete(void* const p) noexcept -> void
+{
+    std::free(p);
+}
+
+auto operator delete(void* const p, std::size_t) noexcept -> void
+{
+    std::free(p);
+}
+
+auto main(int argc, char const* argv[]) -> int
+{
+    auto const messages = argc > 1 ? read_capture(argv[1]) : sample_messages();
+    std::size_t const iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200'000;
+
+    if (messages.empty())
+    {
+        std::cerr << "no messages" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Parsing mangles its input, so each message is copied into this
+    // buffer first. It is sized up front to keep it out of the count.
+    std::vector<char> buffer(1 + std::max_element(
+                                     messages.begin(), messages.end(),
+                                     [](auto&& x, auto&& y) { return x.size() < y.size(); }
+                                 )->size());
+
+    std::size_t parsed = 0;
+    std::size_t errors = 0;
+    auto const before = allocations;
+    auto const start = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+        for (auto&& message : messages)
+        {
+            std::memcpy(buffer.data(), message.c_str(), message.size() + 1);
+            try
+            {
+                auto const msg = parse_irc_message(buffer.data());
+                parsed += not msg.command.empty();
+            }
+            catch (irc_parse_error const&)
+            {
+                errors++;
+            }
+        }
+    }
+
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+    auto const total = iterations * messages.size();
+
+    std::cout << "messages:       " << total << '\n'
+              << "parse errors:   " << errors << '\n'
+              << "seconds:        " << elapsed.count() << '\n'
+              << "messages/s:     " << parsed / elapsed.count() << '\n'
+              << "allocs/message: " << double(allocations - before) / total << std::endl;
+}
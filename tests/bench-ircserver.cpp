@@ -0,0 +1,641 @@
+/**
+ * @file bench-ircserver.cpp
+ * @brief Mock IRC server generating load for end-to-end benchmarks
+ *
+ * Usage: bench-ircserver [--port=N] [--tls] [--rate=N] [--duration=SECONDS]
+ *                        [--mix=NOTICES,NUMERICS,PRIVMSGS] [--ping=MS] [--client] [--ktls]
+ *
+ * The server accepts a client, completes CAP negotiation, SASL, and
+ * registration, and then sends a weighted mix of server notices,
+ * numerics, and PRIVMSGs at the target rate (0 for as fast as the
+ * client reads). A numbered PING is sent every ping interval and the
+ * time until the matching PONG is reported as the client's latency
+ * under load. TLS uses a freshly generated self-signed certificate.
+ *
+ * With --client an in-process client built on connection and LineBuffer
+ * is benchmarked and the program exits after one session. --ktls implies
+ * --tls and has the client request kernel TLS offload; the program exits
+ * with status 77, which ctest reports as skipped, when the kernel can't
+ * offload the connection. Otherwise the
+ * server keeps accepting sessions so snowcone, including its Lua
+ * handlers, can be pointed at the printed port.
+ */
+
+#include <connection.hpp>
+#include <linebuffer.hpp>
+#include <metrics.hpp>
+
+#include <ircmsg.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::literals::chrono_literals;
+using namespace std::literals::string_view_literals;
+
+using clock = std::chrono::steady_clock;
+using tcp = boost::asio::ip::tcp;
+using boost::asio::awaitable;
+using boost::asio::use_awaitable;
+
+char const* const server_name = "mock.server";
+
+/// Exit status ctest treats as a skipped test
+int const exit_skipped = 77;
+
+/// @brief Raised by the client when kernel TLS was requested but not engaged
+struct KtlsUnavailable : std::runtime_error
+{
+    KtlsUnavailable()
+        : std::runtime_error{"kernel TLS offload unavailable"}
+    {
+    }
+};
+
+struct Options
+{
+    std::uint16_t port = 0;
+    bool tls = false;
+    /// Messages per second; non-positive sends as fast as the client reads
+    double rate = 20'000;
+    clock::duration duration = 10s;
+    /// Relative weights of server notices, numerics, and PRIVMSGs
+    std::array<unsigned, 3> mix{8, 1, 1};
+    clock::duration ping = 100ms;
+    bool client = false;
+    /// Client requests kernel TLS offload
+    bool ktls = false;
+};
+
+[[noreturn]] auto usage() -> void
+{
+    std::cerr << "Usage: bench-ircserver [--port=N] [--tls] [--rate=N] [--duration=SECONDS]\n"
+                 "                       [--mix=NOTICES,NUMERICS,PRIVMSGS] [--ping=MS] [--client] [--ktls]\n";
+    std::exit(EXIT_FAILURE);
+}
+
+auto parse_options(int const argc, char const* const argv[]) -> Options
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view const arg = argv[i];
+        auto const value = [arg](std::string_view const name) -> char const* {
+            return arg.starts_with(name) ? arg.data() + name.size() : nullptr;
+        };
+
+        if (arg == "--tls")
+        {
+            options.tls = true;
+        }
+        else if (arg == "--client")
+        {
+            options.client = true;
+        }
+        else if (arg == "--ktls")
+        {
+            options.tls = true;
+            options.ktls = true;
+        }
+        else if (auto const v = value("--port="))
+        {
+            options.port = static_cast<std::uint16_t>(std::strtoul(v, nullptr, 10));
+        }
+        else if (auto const v = value("--rate="))
+        {
+            options.rate = std::strtod(v, nullptr);
+        }
+        else if (auto const v = value("--duration="))
+        {
+            options.duration = std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double>{std::strtod(v, nullptr)});
+        }
+        else if (auto const v = value("--ping="))
+        {
+            options.ping = std::chrono::milliseconds{std::strtoul(v, nullptr, 10)};
+        }
+        else if (auto const v = value("--mix="))
+        {
+            char* cursor = const_cast<char*>(v);
+            for (auto& weight : options.mix)
+            {
+                weight = std::strtoul(cursor, &cursor, 10);
+                if (',' == *cursor) cursor++;
+            }
+        }
+        else
+        {
+            usage();
+        }
+    }
+
+    if (0 == options.mix[0] + options.mix[1] + options.mix[2] || options.ping <= 0s)
+    {
+        usage();
+    }
+    return options;
+}
+
+/// @brief Configure a TLS context with a new self-signed certificate
+auto use_self_signed(boost::asio::ssl::context& ctx) -> void
+{
+    std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> const key{EVP_EC_gen("P-256"), EVP_PKEY_free};
+    std::unique_ptr<X509, decltype(&X509_free)> const cert{X509_new(), X509_free};
+    if (not key || not cert)
+    {
+        throw std::runtime_error{"failed to allocate certificate"};
+    }
+
+    X509_set_version(cert.get(), 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert.get()), 24 * 60 * 60);
+    X509_set_pubkey(cert.get(), key.get());
+
+    auto const name = X509_get_subject_name(cert.get());
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<unsigned char const*>(server_name), -1, -1, 0);
+    X509_set_issuer_name(cert.get(), name);
+
+    if (0 == X509_sign(cert.get(), key.get(), EVP_sha256())
+        || 1 != SSL_CTX_use_certificate(ctx.native_handle(), cert.get())
+        || 1 != SSL_CTX_use_PrivateKey(ctx.native_handle(), key.get()))
+    {
+        throw std::runtime_error{"failed to install self-signed certificate"};
+    }
+}
+
+/// @brief Results of one load session
+struct Report
+{
+    std::size_t messages = 0;
+    std::size_t bytes = 0;
+    clock::duration elapsed{};
+    clock::duration drain{};
+    std::size_t pings = 0;
+    std::size_t pongs = 0;
+    metrics::Histogram latency;
+
+    auto print(std::ostream& os) const -> void
+    {
+        auto const seconds = std::chrono::duration<double>{elapsed}.count();
+        auto const ms = [](std::uint64_t const ns) { return static_cast<double>(ns) / 1e6; };
+        os << "messages:   " << messages << '\n'
+           << "bytes:      " << bytes << '\n'
+           << "seconds:    " << seconds << '\n'
+           << "msgs/s:     " << messages / seconds << '\n'
+           << "MB/s:       " << bytes / seconds / 1e6 << '\n'
+           << "pongs:      " << pongs << " of " << pings << '\n'
+           << "pong p50:   " << ms(latency.quantile(0.5)) << " ms\n"
+           << "pong p99:   " << ms(latency.quantile(0.99)) << " ms\n"
+           << "pong max:   " << ms(latency.max()) << " ms\n"
+           << "drain:      " << std::chrono::duration<double, std::milli>{drain}.count() << " ms" << std::endl;
+    }
+};
+
+/// @brief Generate load messages in a deterministic weighted order
+class MessageMix
+{
+    std::array<unsigned, 3> mix_;
+    std::size_t counter_ = 0;
+
+public:
+    explicit MessageMix(std::array<unsigned, 3> const mix) : mix_{mix} {}
+
+    auto append(std::string& out, std::string_view const nick) -> void
+    {
+        auto const i = counter_++;
+        auto const n = std::to_string(i);
+        auto const octet = std::to_string(i % 256);
+        auto slot = i % (mix_[0] + mix_[1] + mix_[2]);
+
+        if (slot < mix_[0])
+        {
+            out += i % 2
+                ? ":mock.server NOTICE * :*** Notice -- Client connecting: user" + n + " (ident@192.0.2." + octet
+                    + ") [192.0.2." + octet + "] {users} <*> [Load Generator]\r\n"
+                : ":mock.server NOTICE * :*** Notice -- Client exiting: user" + n + " (ident@192.0.2." + octet
+                    + ") [Quit: bye] [192.0.2." + octet + "]\r\n";
+        }
+        else if ((slot -= mix_[0]) < mix_[1])
+        {
+            out += ":mock.server 265 ";
+            out += nick;
+            out += " " + n + " 100000 :Current local users " + n + ", max 100000\r\n";
+        }
+        else
+        {
+            out += ":user" + n + "!ident@192.0.2." + octet + " PRIVMSG #load :message number " + n + "\r\n";
+        }
+    }
+};
+
+/// @brief One client connected to the mock server
+template <typename Stream>
+class Session
+{
+    Stream& stream_;
+    Options const& options_;
+    Report& report_;
+    boost::asio::streambuf input_;
+    std::string line_;
+    std::string nick_ = "*";
+
+    /// Send times of the numbered PINGs
+    std::vector<clock::time_point> pings_;
+
+    /// True while read_pongs is running
+    bool reading_ = false;
+
+    auto write(std::string const& text) -> awaitable<void>
+    {
+        co_await boost::asio::async_write(stream_, boost::asio::buffer(text), use_awaitable);
+    }
+
+    auto read_message() -> awaitable<ircmsg>
+    {
+        auto const n = co_await boost::asio::async_read_until(stream_, input_, '\n', use_awaitable);
+        line_.assign(boost::asio::buffers_begin(input_.data()), boost::asio::buffers_begin(input_.data()) + n);
+        input_.consume(n);
+        while (not line_.empty() && ('\n' == line_.back() || '\r' == line_.back()))
+        {
+            line_.pop_back();
+        }
+        co_return parse_irc_message(line_.data());
+    }
+
+    auto reply(std::string_view const numeric, std::string_view const text) -> awaitable<void>
+    {
+        co_await write(":mock.server " + std::string{numeric} + " " + nick_ + " " + std::string{text} + "\r\n");
+    }
+
+    /// @brief Handle CAP, SASL, NICK, and USER until the client registers
+    auto registration() -> awaitable<void>
+    {
+        bool negotiating = false;
+        bool have_nick = false;
+        bool have_user = false;
+
+        while (negotiating || not have_nick || not have_user)
+        {
+            auto const msg = co_await read_message();
+            auto const arg = [&msg](std::size_t const i) { return i < msg.args.size() ? msg.args[i] : ""sv; };
+
+            if (msg.command == "CAP" && arg(0) == "LS")
+            {
+                negotiating = true;
+                co_await write(":mock.server CAP * LS :sasl=PLAIN\r\n");
+            }
+            else if (msg.command == "CAP" && arg(0) == "REQ")
+            {
+                co_await write(":mock.server CAP * ACK :" + std::string{arg(1)} + "\r\n");
+            }
+            else if (msg.command == "CAP" && arg(0) == "END")
+            {
+                negotiating = false;
+            }
+            else if (msg.command == "AUTHENTICATE" && arg(0) == "PLAIN")
+            {
+                co_await write("AUTHENTICATE +\r\n");
+            }
+            else if (msg.command == "AUTHENTICATE")
+            {
+                co_await reply("900", nick_ + "!bench@mock " + nick_ + " :You are now logged in");
+                co_await reply("903", ":SASL authentication successful");
+            }
+            else if (msg.command == "NICK")
+            {
+                nick_ = arg(0);
+                have_nick = true;
+            }
+            else if (msg.command == "USER")
+            {
+                have_user = true;
+            }
+        }
+
+        co_await reply("001", ":Welcome to the mock IRC network " + nick_);
+        co_await reply("002", ":Your host is mock.server");
+        co_await reply("003", ":This server was created for benchmarking");
+        co_await reply("004", "mock.server mock-1.0 iosw bklmnopst");
+        co_await reply("005", "CHANTYPES=# CASEMAPPING=rfc1459 NETWORK=Mock :are supported by this server");
+        co_await reply("376", ":End of /MOTD command.");
+    }
+
+    /// @brief Record PONG latencies until reading fails or is cancelled
+    auto read_pongs() -> awaitable<void>
+    {
+        try
+        {
+            for (;;)
+            {
+                auto const msg = co_await read_message();
+                if (msg.command == "PONG" && not msg.args.empty())
+                {
+                    auto const seq = std::strtoul(std::string{msg.args[msg.args.size() - 1]}.c_str(), nullptr, 10);
+                    if (seq < pings_.size())
+                    {
+                        report_.pongs++;
+                        report_.latency.record(clock::now() - pings_[seq]);
+                    }
+                }
+            }
+        }
+        catch (std::exception const&)
+        {
+        }
+        reading_ = false;
+    }
+
+    auto send_ping(std::string& out) -> std::size_t
+    {
+        auto const seq = pings_.size();
+        out += "PING :" + std::to_string(seq) + "\r\n";
+        pings_.push_back(clock::now());
+        report_.pings++;
+        return seq;
+    }
+
+    /// @brief Send the message mix at the target rate
+    auto load() -> awaitable<void>
+    {
+        auto const tick = 10ms;
+        auto const per_tick = options_.rate * std::chrono::duration<double>{tick}.count();
+        auto const max_owed = options_.rate > 0 ? options_.rate : 0.0;
+
+        MessageMix mix{options_.mix};
+        boost::asio::steady_timer timer{co_await boost::asio::this_coro::executor};
+        std::string batch;
+
+        auto const start = clock::now();
+        auto const end = start + options_.duration;
+        auto next_tick = start;
+        auto next_ping = start;
+        double owed = 0;
+
+        for (auto now = start; now < end; now = clock::now())
+        {
+            std::size_t n;
+            if (options_.rate > 0)
+            {
+                timer.expires_at(next_tick += tick);
+                co_await timer.async_wait(use_awaitable);
+                owed = std::min(owed + per_tick, max_owed);
+                n = static_cast<std::size_t>(owed);
+                owed -= n;
+            }
+            else
+            {
+                n = 1'000;
+            }
+
+            batch.clear();
+            for (std::size_t i = 0; i < n; i++)
+            {
+                mix.append(batch, nick_);
+            }
+            if (now >= next_ping)
+            {
+                next_ping += options_.ping;
+                send_ping(batch);
+            }
+
+            co_await write(batch);
+            report_.messages += n;
+            report_.bytes += batch.size();
+        }
+        report_.elapsed = clock::now() - start;
+    }
+
+public:
+    Session(Stream& stream, Options const& options, Report& report)
+        : stream_{stream}
+        , options_{options}
+        , report_{report}
+    {
+    }
+
+    auto run() -> awaitable<void>
+    {
+        co_await registration();
+
+        auto const executor = co_await boost::asio::this_coro::executor;
+        reading_ = true;
+        boost::asio::co_spawn(executor, read_pongs(), boost::asio::detached);
+
+        co_await load();
+
+        // Wait for the client to catch up with everything sent
+        auto const drain_start = clock::now();
+        std::string final_ping;
+        auto const seq = send_ping(final_ping);
+        co_await write(final_ping);
+
+        boost::asio::steady_timer timer{executor};
+        while (report_.pongs < seq + 1 && clock::now() - drain_start < 10s)
+        {
+            timer.expires_after(1ms);
+            co_await timer.async_wait(use_awaitable);
+        }
+        report_.drain = clock::now() - drain_start;
+
+        co_await write("ERROR :Closing Link: benchmark complete\r\n");
+
+        // The reader refers to this session so it must finish first
+        stream_.lowest_layer().cancel();
+        while (reading_)
+        {
+            timer.expires_after(1ms);
+            co_await timer.async_wait(use_awaitable);
+        }
+    }
+};
+
+/// @brief Accept clients and run load sessions
+auto serve(tcp::acceptor& acceptor, Options const& options) -> awaitable<bool>
+{
+    boost::asio::ssl::context ctx{boost::asio::ssl::context::tls_server};
+    if (options.tls)
+    {
+        use_self_signed(ctx);
+    }
+
+    do
+    {
+        auto socket = co_await acceptor.async_accept(use_awaitable);
+        socket.set_option(tcp::no_delay{true});
+
+        Report report;
+        try
+        {
+            if (options.tls)
+            {
+                boost::asio::ssl::stream<tcp::socket> stream{std::move(socket), ctx};
+                co_await stream.async_handshake(stream.server, use_awaitable);
+                co_await Session{stream, options, report}.run();
+            }
+            else
+            {
+                co_await Session{socket, options, report}.run();
+            }
+        }
+        catch (std::exception const& e)
+        {
+            std::cerr << "session failed: " << e.what() << std::endl;
+            if (options.client)
+            {
+                co_return false;
+            }
+            continue;
+        }
+
+        report.print(std::cout);
+        if (options.client)
+        {
+            co_return 0 < report.pongs;
+        }
+    } while (true);
+}
+
+/// @brief Minimal client answering PINGs through connection and LineBuffer
+auto client(boost::asio::io_context& io_context, Options const& options, std::uint16_t const port)
+    -> awaitable<std::size_t>
+{
+    Settings settings{
+        .tls = options.tls,
+        .host = "127.0.0.1",
+        .port = port,
+        .client_cert = {},
+        .client_key = {},
+        .verify = "",
+        .sni = server_name,
+        .ktls = options.ktls,
+        .session_cache = nullptr,
+        .socks_host = "",
+        .socks_port = 0,
+        .socks_auth = socks5::NoCredential{},
+        .replay = "",
+        .replay_speed = 0,
+    };
+
+    auto const irc = connection::create(io_context);
+    auto const description = co_await irc->connect(std::move(settings));
+    std::cout << "connected:  " << description << std::endl;
+
+    // OpenSSL silently falls back to userspace TLS without the kernel tls module
+    if (options.ktls && description.find(" ktls=off") != std::string::npos)
+    {
+        irc->close();
+        throw KtlsUnavailable{};
+    }
+
+    irc->send("CAP LS 302\r\nNICK bench\r\nUSER bench 0 * :bench\r\n", Lane::Normal);
+
+    std::size_t messages = 0;
+    for (LineBuffer buff{connection::irc_buffer_size, connection::irc_buffer_max_size};;)
+    {
+        auto const target = buff.prepare();
+        auto const n = co_await irc->get_stream().async_read_some(target, use_awaitable);
+        buff.commit(n);
+
+        while (auto const line = buff.next_line())
+        {
+            if ('\0' == *line)
+            {
+                continue;
+            }
+            auto const msg = parse_irc_message(line);
+            messages++;
+
+            auto const arg = [&msg](std::size_t const i) { return i < msg.args.size() ? msg.args[i] : ""sv; };
+            if (msg.command == "PING")
+            {
+                irc->send("PONG :" + std::string{arg(0)} + "\r\n", Lane::Urgent);
+            }
+            else if (msg.command == "CAP" && arg(1) == "LS")
+            {
+                irc->send("CAP REQ :sasl\r\n", Lane::Normal);
+            }
+            else if (msg.command == "CAP" && arg(1) == "ACK")
+            {
+                irc->send("AUTHENTICATE PLAIN\r\n", Lane::Normal);
+            }
+            else if (msg.command == "AUTHENTICATE")
+            {
+                // base64 of "bench\0bench\0bench"
+                irc->send("AUTHENTICATE YmVuY2gAYmVuY2gAYmVuY2g=\r\n", Lane::Normal);
+            }
+            else if (msg.command == "903" || msg.command == "904")
+            {
+                irc->send("CAP END\r\n", Lane::Normal);
+            }
+            else if (msg.command == "ERROR")
+            {
+                irc->close();
+                co_return messages;
+            }
+        }
+        buff.shift();
+    }
+}
+
+} // namespace
+
+auto main(int const argc, char const* argv[]) -> int
+{
+    auto const options = parse_options(argc, argv);
+
+    boost::asio::io_context server_context;
+    tcp::acceptor acceptor{server_context, {boost::asio::ip::address_v4::loopback(), options.port}};
+    auto const port = acceptor.local_endpoint().port();
+    std::cout << "listening:  127.0.0.1:" << port << (options.tls ? " (tls)" : "") << std::endl;
+
+    auto server_result = boost::asio::co_spawn(server_context, serve(acceptor, options), boost::asio::use_future);
+    std::thread server_thread{[&server_context] { server_context.run(); }};
+
+    auto ok = true;
+    if (options.client)
+    {
+        boost::asio::io_context client_context;
+        auto client_result =
+            boost::asio::co_spawn(client_context, client(client_context, options, port), boost::asio::use_future);
+        client_context.run();
+        try
+        {
+            auto const messages = client_result.get();
+            std::cout << "client:     " << messages << " messages parsed" << std::endl;
+        }
+        catch (KtlsUnavailable const& e)
+        {
+            std::cerr << "skipped:    " << e.what() << std::endl;
+            server_context.stop();
+            server_thread.join();
+            return exit_skipped;
+        }
+        catch (std::exception const& e)
+        {
+            std::cerr << "client failed: " << e.what() << std::endl;
+            ok = false;
+        }
+    }
+
+    ok = server_result.get() && ok;
+    server_thread.join();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file bench-linebuffer.cpp
+ * @brief Replay a captured server stream through LineBuffer
+ *
+ * Usage: bench-linebuffer [CAPTURE [READ_SIZE [ITERATIONS]]]
+ *
+ * The capture file is raw bytes as received from the server. When
+ * no capture is given a synthetic server notice flood is used. The
+ * stream is delivered in READ_SIZE chunks to mimic async_read_some.
+ */
+
+#include <linebuffer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+namespace {
+
+auto synthetic_stream() -> std::string
+{
+    std::string stream;
+    for (int i = 0; i < 20'000; i++)
+    {
+        stream += "@time=2024-01-01T00:00:00.000Z :irc.example.net NOTICE * :*** Notice -- "
+                  "Client connecting: nick" + std::to_string(i)
+            + " (user@192.0.2." + std::to_string(i % 256)
+            + ") [192.0.2." + std::to_string(i % 256) + "] {users} <*> [Real Name]\r\n";
+    }
+    return stream;
+}
+
+auto read_capture(char const* const path) -> std::string
+{
+    std::ifstream in{path, std::ios::binary};
+    if (not in)
+    {
+        std::cerr << "failed to open " << path << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+} // namespace
+
+auto main(int argc, char const* argv[]) -> int
+{
+    auto const stream = argc > 1 ? read_capture(argv[1]) : synthetic_stream();
+    std::size_t const read_size = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16'384;
+    std::size_t const iterations = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 50;
+
+    std::size_t lines = 0;
+    auto const start = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+        LineBuffer buff{131'072, 1'048'576};
+        for (std::size_t offset = 0; offset < stream.size();)
+        {
+            auto const target = buff.prepare();
+            if (target.size() == 0)
+            {
+                std::cerr << "line buffer full" << std::endl;
+                return EXIT_FAILURE;
+            }
+            auto const n = std::min({read_size, target.size(), stream.size() - offset});
+            std::memcpy(target.data(), stream.data() + offset, n);
+            offset += n;
+            buff.commit(n);
+
+            while (buff.next_line())
+            {
+                lines++;
+            }
+            buff.shift();
+        }
+    }
+
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+    auto const bytes = double(stream.size()) * iterations;
+
+    std::cout << "bytes:      " << bytes << '\n'
+              << "lines:      " << lines << '\n'
+              << "seconds:    " << elapsed.count() << '\n'
+              << "MB/s:       " << bytes / elapsed.count() / 1e6 << '\n'
+              << "lines/s:    " << lines / elapsed.count() << std::endl;
+}
@@ -0,0 +1,94 @@
+#include <capture.hpp>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+auto reader(std::string const& text) -> CaptureReader
+{
+    return CaptureReader{std::make_unique<std::istringstream>(text)};
+}
+
+auto read_all(CaptureReader& capture, std::size_t const chunk, CaptureReader::duration const until) -> std::string
+{
+    std::string result;
+    std::string buffer(chunk, '\0');
+    while (auto const n = capture.read(buffer, until))
+    {
+        result.append(buffer, 0, n);
+    }
+    return result;
+}
+
+TEST(Capture, ReadsInTimeOrder)
+{
+    auto capture = reader(
+        "100.5 :irc.example PING :1\n"
+        "\n"
+        "101.0 :irc.example PING :2\r\n"
+        "100.0 :irc.example PING :3\n"
+        "103.25 :irc.example PING :4\n");
+
+    EXPECT_EQ(capture.next_time(), 0s);
+    EXPECT_EQ(read_all(capture, 64, 0s), ":irc.example PING :1\r\n");
+
+    // Records never go back in time
+    EXPECT_EQ(capture.next_time(), 500ms);
+    EXPECT_EQ(read_all(capture, 64, 500ms), ":irc.example PING :2\r\n:irc.example PING :3\r\n");
+
+    EXPECT_EQ(capture.next_time(), 2750ms);
+    EXPECT_EQ(read_all(capture, 64, CaptureReader::duration::max()), ":irc.example PING :4\r\n");
+    EXPECT_EQ(capture.next_time(), std::nullopt);
+}
+
+TEST(Capture, SplitsRecordsAcrossReads)
+{
+    auto capture = reader("1 :a PRIVMSG #b :hello\n2 :c NOTICE d :world\n");
+
+    // A partially delivered record finishes even though it isn't due yet
+    std::string buffer(10, '\0');
+    ASSERT_EQ(capture.read(buffer, 0s), 10);
+    EXPECT_EQ(buffer, ":a PRIVMSG");
+    EXPECT_EQ(read_all(capture, 3, 0s), " #b :hello\r\n");
+    EXPECT_EQ(read_all(capture, 3, 1s), ":c NOTICE d :world\r\n");
+}
+
+TEST(Capture, RejectsMalformedTimestamps)
+{
+    EXPECT_THROW(reader("PING :x\n"), std::runtime_error);
+    EXPECT_THROW(reader(" PING :x\n"), std::runtime_error);
+
+    auto capture = reader("1 PING :x\n1.5x PING :y\n");
+    std::string buffer(64, '\0');
+    EXPECT_THROW(capture.read(buffer), std::runtime_error);
+}
+
+TEST(Capture, WriterRoundTrip)
+{
+    auto out = std::make_unique<std::ostringstream>();
+    auto& text = *out;
+    CaptureWriter writer{std::move(out)};
+
+    auto const t0 = std::chrono::system_clock::time_point{} + 1700000000s;
+    writer.write(t0, ":a PING :1\r\n:b PI");
+    writer.write(t0 + 1500ms, "NG :2\r\n\r\n");
+    writer.write(t0 + 2s, ":c PING :3\n");
+    EXPECT_EQ(text.str(),
+        "1700000000.000000 :a PING :1\n"
+        "1700000001.500000 :b PING :2\n"
+        "1700000002.000000 :c PING :3\n");
+
+    auto capture = reader(text.str());
+    EXPECT_EQ(read_all(capture, 7, 1500ms), ":a PING :1\r\n:b PING :2\r\n");
+    EXPECT_EQ(capture.next_time(), 2s);
+}
+
+} // namespace
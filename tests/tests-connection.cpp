@@ -0,0 +1,78 @@
+#include <connection.hpp>
+
+#include <gtest/gtest.h>
+
+#include <boost/asio.hpp>
+
+#include <string>
+#include <thread>
+
+namespace {
+
+// 40 bytes, so the third message crosses a 100 byte high-water mark
+std::string const message = "PRIVMSG #channel :0123456789abcdefghij\r\n";
+
+// No handler runs in these tests until asked, so no write can complete
+// and every sent byte stays queued.
+
+TEST(Connection, SendReportsBacklogBeforeWritesComplete)
+{
+    ASSERT_EQ(message.size(), 40);
+    boost::asio::io_context io_context;
+    auto const conn = connection::create(io_context, 100);
+
+    EXPECT_TRUE(conn->send(message, Lane::Normal));
+    EXPECT_TRUE(conn->send(message, Lane::Normal));
+    EXPECT_FALSE(conn->send(message, Lane::Normal));
+    EXPECT_EQ(conn->backlog(), 120);
+
+    auto const snapshot = conn->snapshot();
+    EXPECT_EQ(snapshot.stats.queued_bytes, 120);
+    EXPECT_EQ(snapshot.stats.queued_messages, 3);
+    EXPECT_EQ(snapshot.backlog(), 120);
+}
+
+TEST(Connection, SnapshotCountsScheduledBytes)
+{
+    boost::asio::io_context io_context;
+    auto const conn = connection::create(io_context, 100);
+
+    // Only the first message has a token; the rest wait in the scheduler
+    conn->set_pacing(1, 0.001);
+    EXPECT_TRUE(conn->send(message, Lane::Normal));
+    EXPECT_TRUE(conn->send(message, Lane::Normal));
+    EXPECT_FALSE(conn->send(message, Lane::Bulk));
+
+    auto const snapshot = conn->snapshot();
+    EXPECT_EQ(snapshot.stats.queued_bytes, 40);
+    EXPECT_EQ(snapshot.scheduled_bytes, 80);
+    EXPECT_EQ(snapshot.lanes[static_cast<std::size_t>(Lane::Bulk)].depth, 1);
+}
+
+TEST(Connection, RemoteSendersSeeHighWater)
+{
+    boost::asio::io_context io_context;
+    auto const conn = connection::create(io_context, 100);
+
+    std::thread{[&conn] {
+        EXPECT_TRUE(conn->post_send(message, Lane::Normal));
+        EXPECT_TRUE(conn->post_send(message, Lane::Normal));
+        EXPECT_FALSE(conn->post_send(message, Lane::Normal));
+    }}.join();
+
+    // Hand the posted messages to send. The first write's completion is
+    // queued behind them and hasn't run.
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_EQ(io_context.poll_one(), 1);
+    }
+
+    std::thread{[&conn] {
+        auto const snapshot = conn->snapshot();
+        EXPECT_EQ(snapshot.stats.queued_bytes, 120);
+        EXPECT_EQ(snapshot.backlog(), 120);
+        EXPECT_FALSE(conn->post_send(message, Lane::Normal));
+    }}.join();
+}
+
+} // namespace
@@ -0,0 +1,140 @@
+#include <grid.h>
+
+#include <gtest/gtest.h>
+
+#include <clocale>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace {
+
+class Grid : public testing::Test
+{
+protected:
+    static SCREEN* term;
+    grid g{};
+
+    static auto SetUpTestSuite() -> void
+    {
+        std::setlocale(LC_ALL, "C.UTF-8");
+        term = newterm("vt100", std::fopen("/dev/null", "w"), std::fopen("/dev/null", "r"));
+        ASSERT_NE(nullptr, term);
+    }
+
+    static auto TearDownTestSuite() -> void
+    {
+        endwin();
+        delscreen(term);
+    }
+
+    auto SetUp() -> void override
+    {
+        ASSERT_TRUE(grid_resize(&g, 3, 8));
+    }
+
+    auto TearDown() -> void override
+    {
+        grid_free(&g);
+    }
+
+    auto draw(int const y, int const x, std::string_view const text) -> void
+    {
+        ASSERT_TRUE(grid_move(&g, y, x));
+        grid_addnstr(&g, text.data(), text.size());
+    }
+
+    /// @brief Row of the back buffer with wide character halves shown as '.'
+    auto row(int const y) const -> std::string
+    {
+        std::string result;
+        for (int x = 0; x < g.cols; x++)
+        {
+            auto const ch = g.back[y * g.cols + x].ch;
+            result += 0 == ch ? '.' : 0x7f < ch ? '#' : static_cast<char>(ch);
+        }
+        return result;
+    }
+
+    /// @brief Row of the window after flushing
+    auto window_row(int const y) const -> std::string
+    {
+        std::string result;
+        for (int x = 0; x < g.cols; x++)
+        {
+            cchar_t cell;
+            mvwin_wch(stdscr, y, x, &cell);
+            wchar_t wch[CCHARW_MAX + 1];
+            attr_t attr;
+            short pair;
+            getcchar(&cell, wch, &attr, &pair, nullptr);
+            result += 0x7f < wch[0] ? '#' : static_cast<char>(wch[0]);
+        }
+        return result;
+    }
+};
+
+SCREEN* Grid::term;
+
+TEST_F(Grid, WrapsAtTheRightEdge)
+{
+    draw(0, 5, "abcdef");
+    EXPECT_EQ(row(0), "     abc");
+    EXPECT_EQ(row(1), "def     ");
+    EXPECT_EQ(g.y, 1);
+    EXPECT_EQ(g.x, 3);
+
+    // Drawing stops at the bottom-right corner
+    draw(2, 6, "xyz");
+    EXPECT_EQ(row(2), "      xy");
+}
+
+TEST_F(Grid, DrawsControlsAndWideCharacters)
+{
+    draw(0, 0, "a\tb\x01");
+    EXPECT_EQ(row(0), "a       ");
+    EXPECT_EQ(row(1), "b^A     ");
+
+    // A wide character that doesn't fit moves to the next row
+    draw(1, 7, "\xe5\xad\x97");
+    EXPECT_EQ(row(1), "b^A     ");
+    EXPECT_EQ(row(2), "#.      ");
+
+    // Overwriting half of a wide character blanks the other half
+    draw(2, 1, "z");
+    EXPECT_EQ(row(2), " z      ");
+}
+
+TEST_F(Grid, FlushesOnlyChangedRows)
+{
+    draw(0, 0, "one");
+    draw(2, 0, "three");
+    EXPECT_EQ(grid_flush(&g, stdscr), 3);
+    EXPECT_EQ(window_row(0).substr(0, 8), "one     ");
+    EXPECT_EQ(window_row(2).substr(0, 8), "three   ");
+    EXPECT_EQ(grid_flush(&g, stdscr), 0);
+
+    // Redrawing the same frame writes nothing
+    grid_erase(&g);
+    draw(0, 0, "one");
+    draw(2, 0, "three");
+    EXPECT_EQ(grid_flush(&g, stdscr), 0);
+
+    grid_erase(&g);
+    draw(0, 0, "one");
+    g.attr = WA_BOLD;
+    draw(2, 0, "three");
+    EXPECT_EQ(grid_flush(&g, stdscr), 1);
+
+    grid_erase(&g);
+    draw(0, 0, "two");
+    EXPECT_EQ(grid_flush(&g, stdscr), 2);
+    EXPECT_EQ(window_row(0).substr(0, 8), "two     ");
+    EXPECT_EQ(window_row(2).substr(0, 8), "        ");
+
+    grid_invalidate(&g);
+    EXPECT_EQ(grid_flush(&g, stdscr), 3);
+}
+
+} // namespace
@@ -0,0 +1,90 @@
+#include <ircformat.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+/// @brief Render runs as "text|attrs|fore,back" for comparison
+auto describe(IrcFormatted const& formatted) -> std::vector<std::string>
+{
+    std::vector<std::string> result;
+    std::size_t offset = 0;
+    for (auto const& span : formatted.spans)
+    {
+        result.push_back(
+            formatted.text.substr(offset, span.length) + "|" + std::to_string(span.attrs)
+            + "|" + std::to_string(span.fore) + "," + std::to_string(span.back));
+        offset += span.length;
+    }
+    EXPECT_EQ(offset, formatted.text.size());
+    return result;
+}
+
+TEST(IrcFormat, PlainText)
+{
+    auto const formatted = parse_irc_formatting("hello world");
+    EXPECT_EQ(formatted.text, "hello world");
+    EXPECT_EQ(describe(formatted), (std::vector<std::string>{"hello world|0|-1,-1"}));
+
+    EXPECT_TRUE(parse_irc_formatting("").spans.empty());
+}
+
+TEST(IrcFormat, TogglesAttributes)
+{
+    auto const formatted = parse_irc_formatting("a\x02" "b\x1d" "c\x02" "d\x1f\x16" "e\x0f" "f");
+    EXPECT_EQ(formatted.text, "abcdef");
+    EXPECT_EQ(describe(formatted), (std::vector<std::string>{
+        "a|0|-1,-1",
+        "b|1|-1,-1",
+        "c|3|-1,-1",
+        "d|2|-1,-1",
+        "e|14|-1,-1",
+        "f|0|-1,-1",
+    }));
+}
+
+TEST(IrcFormat, Colors)
+{
+    auto const formatted = parse_irc_formatting(
+        "\x03" "4red\x03" "12,01blue\x03" "5keep\x03" "reset\x03" "123\x03" "7,x\x03" "07,99z");
+    EXPECT_EQ(formatted.text, "redbluekeepreset3,xz");
+    EXPECT_EQ(describe(formatted), (std::vector<std::string>{
+        "red|0|4,-1",
+        "blue|0|12,1",
+        "keep|0|5,1",
+        "reset|0|-1,-1",
+        "3|0|12,-1",
+        ",x|0|7,-1",
+        "z|0|7,99",
+    }));
+}
+
+TEST(IrcFormat, MergesRunsAndShowsControls)
+{
+    // Codes that don't change the format don't split the text
+    auto const formatted = parse_irc_formatting("a\x02\x02" "b\x01" "c\x7f\n");
+    EXPECT_EQ(formatted.text, "ab␁c␡␤");
+    EXPECT_EQ(describe(formatted), (std::vector<std::string>{"ab␁c␡␤|0|-1,-1"}));
+}
+
+TEST(IrcFormat, CacheEvictsLeastRecentlyUsed)
+{
+    IrcFormatCache cache{2};
+
+    auto const* const a = &cache.get("\x02" "a");
+    EXPECT_EQ(a->text, "a");
+    cache.get("b");
+    EXPECT_EQ(&cache.get("\x02" "a"), a);
+
+    // b is now the least recently used
+    cache.get("c");
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(&cache.get("\x02" "a"), a);
+    EXPECT_EQ(cache.get("b").text, "b");
+    EXPECT_EQ(cache.size(), 2);
+}
+
+} // namespace
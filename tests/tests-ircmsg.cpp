@@ -2,6 +2,11 @@
 
 #include <gtest/gtest.h>
 
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
 namespace {
 
 TEST(Irc, NoArgs) {
@@ -53,6 +58,25 @@ TEST(Irc, MaxArgsColon)
   EXPECT_EQ(parse_irc_message(input), expect);
 }
 
+TEST(Irc, SpillArgs)
+{
+  char input[] = "command 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 :18 19";
+  ircmsg expect {{}, {}, "command", {"1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12", "13", "14", "15", "16", "17", "18 19"}};
+  auto const msg = parse_irc_message(input);
+  EXPECT_EQ(msg, expect);
+  EXPECT_EQ(ircmsg{msg}, expect);
+}
+
+TEST(Irc, SpillTags)
+{
+  char input[] = "@a=1;b=2;c=3;d=4;e=5;f=6;g=7;h=8;i=9;j=10 command";
+  ircmsg expect {{{"a","1"},{"b","2"},{"c","3"},{"d","4"},{"e","5"},{"f","6"},{"g","7"},{"h","8"},{"i","9"},{"j","10"}}, {}, "command", {}};
+  auto msg = parse_irc_message(input);
+  auto const moved = std::move(msg);
+  EXPECT_EQ(moved, expect);
+  EXPECT_TRUE(msg.tags.empty());
+}
+
 TEST(Irc, TestBarePrefix) {
   char input[] = ":prefix";
   EXPECT_ANY_THROW(parse_irc_message(input));
@@ -202,6 +226,51 @@ TEST(Irc, MixedValidAndUnconventionalTags) {
     EXPECT_EQ(parse_irc_message(input), expected);
 }
 
+// Parse with the given implementation, returning nullopt on error
+template <typename F>
+auto try_parse(F parse, std::string input) -> std::optional<std::vector<std::string>>
+{
+  try {
+    // Flatten into owned strings as the views point into input
+    auto const msg = parse(input.data());
+    std::vector<std::string> out;
+    for (auto&& tag : msg.tags) {
+      out.emplace_back(tag.key);
+      out.emplace_back(tag.val.data() == nullptr ? "<none>" : std::string{tag.val});
+    }
+    out.emplace_back(msg.source.data() == nullptr ? "<none>" : std::string{msg.source});
+    out.emplace_back(msg.command);
+    out.insert(out.end(), msg.args.begin(), msg.args.end());
+    return out;
+  } catch (irc_parse_error const&) {
+    return std::nullopt;
+  }
+}
+
+// Compare the vectorized parser against the scalar reference on
+// random messages built from characters significant to the grammar.
+TEST(Irc, DifferentialFuzz)
+{
+  std::mt19937 gen{1234};
+  std::string_view constexpr alphabet = "  ;;==\\\\::@@abrsn\r\nX";
+  std::uniform_int_distribution<std::size_t> pick{0, alphabet.size() - 1};
+  std::uniform_int_distribution<std::size_t> length{0, 200};
+
+  for (int i = 0; i < 100'000; i++) {
+    std::string input(length(gen), ' ');
+    for (auto& c : input) {
+      c = alphabet[pick(gen)];
+    }
+    if (i % 2 == 0) {
+      input.insert(0, "@"); // bias toward exercising the tag parser
+    }
+
+    auto const expect = try_parse(parse_irc_message_scalar, input);
+    auto const actual = try_parse(parse_irc_message, input);
+    ASSERT_EQ(expect, actual) << "input: " << input;
+  }
+}
+
 }
 
 int main(int argc, char **argv) {
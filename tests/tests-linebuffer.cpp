@@ -0,0 +1,98 @@
+#include <linebuffer.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+auto feed(LineBuffer& buff, std::string_view const input) -> void
+{
+    auto const target = buff.prepare();
+    ASSERT_GE(target.size(), input.size());
+    std::memcpy(target.data(), input.data(), input.size());
+    buff.commit(input.size());
+}
+
+auto drain(LineBuffer& buff) -> std::vector<std::string>
+{
+    std::vector<std::string> lines;
+    while (auto const line = buff.next_line())
+    {
+        lines.emplace_back(line);
+    }
+    buff.shift();
+    return lines;
+}
+
+TEST(FindNewline, AllPositions)
+{
+    // Exercise every offset across the vector and scalar tail paths
+    for (std::size_t len = 0; len < 100; len++)
+    {
+        std::string input(len, 'x');
+        EXPECT_EQ(find_newline(input.data(), input.data() + len), input.data() + len);
+        for (std::size_t i = 0; i < len; i++)
+        {
+            input[i] = '\n';
+            EXPECT_EQ(find_newline(input.data(), input.data() + len), input.data() + i);
+            input[i] = 'x';
+        }
+    }
+}
+
+TEST(LineBuffer, SplitLines)
+{
+    LineBuffer buff{64};
+    feed(buff, "one\r\ntwo\nthr");
+    EXPECT_EQ(drain(buff), (std::vector<std::string>{"one", "two"}));
+    feed(buff, "ee\r\n");
+    EXPECT_EQ(drain(buff), (std::vector<std::string>{"three"}));
+}
+
+TEST(LineBuffer, BareCarriageReturn)
+{
+    LineBuffer buff{64};
+    feed(buff, "\r\n\n");
+    EXPECT_EQ(drain(buff), (std::vector<std::string>{"", ""}));
+}
+
+TEST(LineBuffer, PartialLineRelocated)
+{
+    LineBuffer buff{16};
+    feed(buff, "0123456789\nabcd");
+    EXPECT_EQ(drain(buff), (std::vector<std::string>{"0123456789"}));
+
+    // consumed prefix exceeds free space, so the partial line moves
+    EXPECT_EQ(buff.prepare().size(), 12);
+    feed(buff, "efgh\n");
+    EXPECT_EQ(drain(buff), (std::vector<std::string>{"abcdefgh"}));
+    EXPECT_EQ(buff.capacity(), 16);
+}
+
+TEST(LineBuffer, GrowsForLongLine)
+{
+    LineBuffer buff{8, 32};
+    feed(buff, "01234567");
+    EXPECT_EQ(drain(buff), std::vector<std::string>{});
+    feed(buff, "89abcdef");
+    EXPECT_EQ(drain(buff), std::vector<std::string>{});
+    EXPECT_EQ(buff.capacity(), 16);
+    feed(buff, "\n");
+    EXPECT_EQ(drain(buff), (std::vector<std::string>{"0123456789abcdef"}));
+}
+
+TEST(LineBuffer, StopsAtMaximum)
+{
+    LineBuffer buff{8, 16};
+    feed(buff, "01234567");
+    drain(buff);
+    feed(buff, "89abcdef");
+    drain(buff);
+    EXPECT_EQ(buff.prepare().size(), 0);
+}
+
+} // namespace
@@ -0,0 +1,86 @@
+#include <loadaverage.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <string>
+
+namespace {
+
+TEST(LoadAverage, StartsEmpty)
+{
+    LoadAverage const avg;
+    EXPECT_EQ(avg.n(), 0);
+    EXPECT_EQ(avg.average(1), 0);
+    EXPECT_EQ(avg.graph(), std::string(LoadAverage::history, ' '));
+}
+
+TEST(LoadAverage, ShortWindowsUntilFull)
+{
+    LoadAverage avg;
+    avg.sample(10);
+
+    // With one partial minute of samples every window decays like the 1 minute one
+    auto const expected = 10 * (1 - std::exp(-1.0 / 60));
+    EXPECT_DOUBLE_EQ(avg.average(1), expected);
+    EXPECT_DOUBLE_EQ(avg.average(5), expected);
+    EXPECT_DOUBLE_EQ(avg.average(15), expected);
+    EXPECT_EQ(avg.average(2), 0);
+
+    for (int i = 0; i < 120; i++)
+    {
+        avg.sample(10);
+    }
+    // Both longer windows still cover the same three minutes
+    EXPECT_GT(avg.average(1), avg.average(5));
+    EXPECT_DOUBLE_EQ(avg.average(5), avg.average(15));
+    EXPECT_EQ(avg.n(), 121);
+}
+
+TEST(LoadAverage, GraphsNewestFirst)
+{
+    LoadAverage avg;
+    avg.sample(1);
+    avg.sample(100);
+    avg.sample(4);
+
+    auto const graph = avg.graph();
+    EXPECT_EQ(graph.substr(0, 9), "▄█▁");
+    EXPECT_EQ(graph.substr(9), std::string(LoadAverage::history - 3, ' '));
+
+    // The oldest sample falls off the end
+    for (std::size_t i = 0; i < LoadAverage::history - 2; i++)
+    {
+        avg.sample(0);
+    }
+    EXPECT_EQ(avg.graph().substr(avg.graph().size() - 6), "▄█");
+    avg.sample(0);
+    EXPECT_EQ(avg.graph().substr(avg.graph().size() - 3), "▄");
+}
+
+TEST(LoadTracker, InternsNamesAndSamplesTotals)
+{
+    LoadTracker tracker;
+    auto const a = tracker.intern("a.example");
+    auto const b = tracker.intern("b.example");
+    EXPECT_NE(a, b);
+    EXPECT_EQ(tracker.intern("a.example"), a);
+    EXPECT_EQ(tracker.size(), 2);
+    EXPECT_EQ(tracker.name(b), "b.example");
+
+    tracker.track(a);
+    tracker.track(a, 2);
+    tracker.track(b, 5);
+    tracker.tick();
+    EXPECT_EQ(tracker.detail(a).graph().substr(0, 3), "▃");
+    EXPECT_EQ(tracker.detail(b).graph().substr(0, 3), "▅");
+    EXPECT_EQ(tracker.global().graph().substr(0, 3), "█");
+
+    // Pending counts are cleared by each tick
+    tracker.tick();
+    EXPECT_EQ(tracker.detail(a).graph().substr(0, 4), " ▃");
+    EXPECT_EQ(tracker.detail(a).n(), 2);
+    EXPECT_EQ(tracker.global().n(), 2);
+}
+
+} // namespace
@@ -0,0 +1,148 @@
+#include <lpm.hpp>
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+auto pton(char const* const text) -> std::string
+{
+    char buffer[16];
+    if (1 == inet_pton(AF_INET, text, buffer))
+    {
+        return {buffer, 4};
+    }
+    if (1 == inet_pton(AF_INET6, text, buffer))
+    {
+        return {buffer, 16};
+    }
+    ADD_FAILURE() << "bad address " << text;
+    return {};
+}
+
+TEST(Lpm, LongestPrefixWins)
+{
+    lpm::Trie trie;
+    ASSERT_TRUE(trie.insert(pton("192.0.2.0"), 24, 1));
+    ASSERT_TRUE(trie.insert(pton("192.0.2.128"), 25, 2));
+    ASSERT_TRUE(trie.insert(pton("192.0.2.200"), 32, 3));
+
+    EXPECT_EQ(trie.match(pton("192.0.2.1")), 1);
+    EXPECT_EQ(trie.match(pton("192.0.2.129")), 2);
+    EXPECT_EQ(trie.match(pton("192.0.2.200")), 3);
+    EXPECT_EQ(trie.match(pton("192.0.3.1")), std::nullopt);
+}
+
+TEST(Lpm, IgnoresHostBits)
+{
+    lpm::Trie trie;
+    ASSERT_TRUE(trie.insert(pton("192.0.2.77"), 25, 1));
+    EXPECT_EQ(trie.match(pton("192.0.2.0")), 1);
+    EXPECT_EQ(trie.match(pton("192.0.2.128")), std::nullopt);
+    EXPECT_EQ(trie.erase(pton("192.0.2.1"), 25), 1);
+    EXPECT_EQ(trie.match(pton("192.0.2.0")), std::nullopt);
+}
+
+TEST(Lpm, FamiliesAreSeparate)
+{
+    lpm::Trie trie;
+    ASSERT_TRUE(trie.insert(pton("0.0.0.0"), 0, 4));
+    EXPECT_EQ(trie.match(pton("198.51.100.1")), 4);
+    EXPECT_EQ(trie.match(pton("::1")), std::nullopt);
+
+    ASSERT_TRUE(trie.insert(pton("2001:db8::"), 32, 6));
+    EXPECT_EQ(trie.match(pton("2001:db8:1::1")), 6);
+    EXPECT_EQ(trie.match(pton("2001:db9::1")), std::nullopt);
+}
+
+TEST(Lpm, RejectsInvalid)
+{
+    lpm::Trie trie;
+    EXPECT_FALSE(trie.insert("abc", 8, 1));
+    EXPECT_FALSE(trie.insert(pton("192.0.2.0"), 33, 1));
+    EXPECT_EQ(trie.match("abc"), std::nullopt);
+    EXPECT_EQ(trie.erase(pton("192.0.2.0"), 24), std::nullopt);
+}
+
+TEST(Lpm, EraseKeepsOthers)
+{
+    lpm::Trie trie;
+    ASSERT_TRUE(trie.insert(pton("10.0.0.0"), 8, 1));
+    ASSERT_TRUE(trie.insert(pton("10.1.0.0"), 16, 2));
+    ASSERT_TRUE(trie.insert(pton("10.1.2.0"), 24, 3));
+
+    EXPECT_EQ(trie.erase(pton("10.1.0.0"), 16), 2);
+    EXPECT_EQ(trie.match(pton("10.1.2.3")), 3);
+    EXPECT_EQ(trie.match(pton("10.1.3.3")), 1);
+
+    EXPECT_EQ(trie.erase(pton("10.1.2.0"), 24), 3);
+    EXPECT_EQ(trie.match(pton("10.1.2.3")), 1);
+
+    // Released nodes are reused
+    ASSERT_TRUE(trie.insert(pton("10.1.2.0"), 24, 5));
+    EXPECT_EQ(trie.match(pton("10.1.2.3")), 5);
+}
+
+// Compare against a linear scan of prefixes
+TEST(Lpm, MatchesLinearScan)
+{
+    struct Prefix
+    {
+        std::string network;
+        std::size_t length;
+    };
+
+    auto const covers = [](Prefix const& p, std::string_view const address) {
+        for (std::size_t i = 0; i < p.length; i++)
+        {
+            auto const bit = [i](std::string_view const s) { return (s[i / 8] >> (7 - i % 8)) & 1; };
+            if (bit(p.network) != bit(address))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> byte{0, 3}; // narrow alphabet so prefixes overlap
+    auto const random_address = [&] {
+        std::string address(4, '\0');
+        for (auto& c : address) c = static_cast<char>(byte(gen) << 6);
+        return address;
+    };
+
+    lpm::Trie trie;
+    std::vector<Prefix> prefixes;
+    for (std::uint32_t i = 0; i < 200; i++)
+    {
+        Prefix p{random_address(), std::uniform_int_distribution<std::size_t>{0, 32}(gen)};
+        ASSERT_TRUE(trie.insert(p.network, p.length, i));
+        prefixes.push_back(p);
+    }
+
+    for (int n = 0; n < 1000; n++)
+    {
+        auto const address = random_address();
+        std::optional<std::uint32_t> expected;
+        std::size_t best = 0;
+        for (std::uint32_t i = 0; i < prefixes.size(); i++)
+        {
+            if (covers(prefixes[i], address) && (not expected || prefixes[i].length >= best))
+            {
+                expected = i;
+                best = prefixes[i].length;
+            }
+        }
+        EXPECT_EQ(trie.match(address), expected);
+    }
+}
+
+} // namespace
@@ -0,0 +1,68 @@
+#include <messagearena.hpp>
+
+#include <gtest/gtest.h>
+
+#include <ircmsg.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> const lines {
+    "@time=2024-01-01T00:00:00.000Z;account=glguy;flag :nick!user@host PRIVMSG #chan :hello world",
+    "PING :irc.example",
+    ":server 005 nick A B C D E F G H I J K L M N :are supported",
+    "@a=b\\sc CMD",
+};
+
+TEST(MessageArena, MatchesParser)
+{
+    MessageArena arena;
+    for (auto const& line : lines)
+    {
+        arena.append(line);
+    }
+    ASSERT_EQ(arena.size(), lines.size());
+
+    for (std::size_t i = 0; i < lines.size(); i++)
+    {
+        auto text = lines[i];
+        auto const expect = parse_irc_message(text.data());
+        EXPECT_EQ(arena.message(i), expect);
+        EXPECT_EQ(arena.message(i).source.data() == nullptr, expect.source.data() == nullptr);
+        EXPECT_STREQ(arena.line(i), text.c_str());
+    }
+}
+
+TEST(MessageArena, RejectsMalformedLines)
+{
+    MessageArena arena;
+    arena.append("PING :1");
+    auto const bytes = arena.bytes();
+
+    EXPECT_THROW(arena.append(":prefix"), irc_parse_error);
+    EXPECT_EQ(arena.size(), 1);
+    EXPECT_EQ(arena.bytes(), bytes);
+
+    arena.append("PING :2");
+    ASSERT_EQ(arena.size(), 2);
+    EXPECT_EQ(arena.message(1).args[0], "2");
+}
+
+TEST(MessageArena, SurvivesMoveAndReuse)
+{
+    MessageArena arena;
+    arena.append(lines[0]);
+    auto moved = std::move(arena);
+    EXPECT_EQ(moved.message(0).args[1], "hello world");
+
+    moved.clear();
+    EXPECT_TRUE(moved.empty());
+    EXPECT_EQ(moved.bytes(), 0);
+    moved.append(lines[1]);
+    EXPECT_EQ(moved.message(0).command, "PING");
+}
+
+} // namespace
@@ -0,0 +1,94 @@
+#include <metrics.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+namespace {
+
+TEST(Metrics, BucketsRoundTrip)
+{
+    for (std::size_t i = 0; i < metrics::Histogram::bucket_count; i++)
+    {
+        auto const min = metrics::Histogram::bucket_min(i);
+        EXPECT_EQ(metrics::Histogram::bucket_of(min), i);
+        if (min > 0)
+        {
+            EXPECT_EQ(metrics::Histogram::bucket_of(min - 1), i - 1);
+        }
+    }
+    EXPECT_EQ(metrics::Histogram::bucket_of(UINT64_MAX), metrics::Histogram::bucket_count - 1);
+}
+
+TEST(Metrics, HistogramPrecision)
+{
+    // Values keep 3 significant bits
+    for (std::uint64_t v : {9ull, 100ull, 1'000ull, 123'456'789ull})
+    {
+        auto const bucket = metrics::Histogram::bucket_of(v);
+        auto const lo = metrics::Histogram::bucket_min(bucket);
+        auto const hi = metrics::Histogram::bucket_min(bucket + 1);
+        EXPECT_LE(lo, v);
+        EXPECT_LT(v, hi);
+        EXPECT_LE(hi - lo, lo / 8 + 1);
+    }
+}
+
+TEST(Metrics, Quantiles)
+{
+    metrics::Histogram hist;
+    EXPECT_EQ(hist.quantile(0.5), 0);
+
+    for (std::uint64_t v = 1; v <= 1000; v++)
+    {
+        hist.record(v * 1000);
+    }
+    EXPECT_EQ(hist.count(), 1000);
+    EXPECT_EQ(hist.max(), 1'000'000);
+    EXPECT_EQ(hist.sum(), 500'500'000);
+
+    auto const p50 = hist.quantile(0.5);
+    EXPECT_GE(p50, 500'000);
+    EXPECT_LE(p50, 500'000 + 500'000 / 8);
+    EXPECT_EQ(hist.quantile(1), 1'000'000);
+
+    EXPECT_EQ(hist.count_below(1024), 1);
+    EXPECT_EQ(hist.count_below(std::uint64_t{1} << 40), 1000);
+}
+
+TEST(Metrics, Registry)
+{
+    auto& c = metrics::counter("test_events_total", "Events");
+    c.add();
+    c.add(2);
+    EXPECT_EQ(&metrics::counter("test_events_total", "Events"), &c);
+    EXPECT_EQ(c.value(), 3);
+    EXPECT_THROW(metrics::gauge("test_events_total", "Events"), std::logic_error);
+
+    metrics::gauge("test_level", "Level").set(-4);
+    metrics::histogram("test_latency_seconds", "Latency").record(std::chrono::milliseconds{2});
+
+    auto const text = metrics::render_prometheus();
+    EXPECT_NE(text.find("# TYPE test_events_total counter\ntest_events_total 3\n"), std::string::npos);
+    EXPECT_NE(text.find("test_level -4\n"), std::string::npos);
+    EXPECT_NE(text.find("test_latency_seconds_bucket{le=\"+Inf\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_latency_seconds_count 1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_latency_seconds_sum 0.002\n"), std::string::npos);
+}
+
+TEST(Metrics, PrometheusBucketsIncludeTheirBound)
+{
+    auto& hist = metrics::histogram("test_bounds_seconds", "Bounds");
+    hist.record(1023);
+    hist.record(1024);
+    hist.record(std::uint64_t{1} << 34);
+
+    auto const text = metrics::render_prometheus();
+    EXPECT_NE(text.find("test_bounds_seconds_bucket{le=\"1.023e-06\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_bounds_seconds_bucket{le=\"2.047e-06\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("test_bounds_seconds_bucket{le=\"17.179869183\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("test_bounds_seconds_bucket{le=\"+Inf\"} 3\n"), std::string::npos);
+}
+
+} // namespace
@@ -0,0 +1,87 @@
+#include <mpscqueue.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+TEST(MpscQueue, FirstInFirstOut)
+{
+    MpscQueue<std::string> queue;
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.pop(), std::nullopt);
+
+    queue.push("one");
+    queue.push("two");
+    EXPECT_FALSE(queue.empty());
+    EXPECT_EQ(queue.pop(), "one");
+    queue.push("three");
+    EXPECT_EQ(queue.pop(), "two");
+    EXPECT_EQ(queue.pop(), "three");
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.pop(), std::nullopt);
+}
+
+TEST(MpscQueue, DestroysRemainingElements)
+{
+    auto const tracker = std::make_shared<int>();
+    {
+        MpscQueue<std::shared_ptr<int>> queue;
+        queue.push(tracker);
+        queue.push(tracker);
+        EXPECT_EQ(tracker.use_count(), 3);
+        queue.pop();
+        EXPECT_EQ(tracker.use_count(), 2);
+    }
+    EXPECT_EQ(tracker.use_count(), 1);
+}
+
+TEST(MpscQueue, ManyProducers)
+{
+    std::size_t constexpr producers = 4;
+    std::size_t constexpr count = 100'000;
+
+    struct Item
+    {
+        std::size_t producer;
+        std::size_t sequence;
+    };
+    MpscQueue<Item> queue;
+
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&queue, p] {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                queue.push({p, i});
+            }
+        });
+    }
+
+    // Each producer's items arrive in order
+    std::vector<std::size_t> next(producers);
+    std::size_t received = 0;
+    while (received < producers * count)
+    {
+        if (auto const item = queue.pop())
+        {
+            ASSERT_EQ(item->sequence, next[item->producer]);
+            next[item->producer]++;
+            received++;
+        }
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+} // namespace
@@ -0,0 +1,132 @@
+#include <irccase.hpp>
+#include <orderedmap.hpp>
+
+extern "C" {
+#include <lauxlib.h>
+#include <lua.h>
+#include <lualib.h>
+}
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+
+class OrderedMap : public testing::Test
+{
+protected:
+    lua_State* L = nullptr;
+
+    auto SetUp() -> void override
+    {
+        L = luaL_newstate();
+        ASSERT_NE(nullptr, L);
+        luaL_openlibs(L);
+        lua_register(L, "OrderedMap", l_new_ordered_map);
+        lua_register(L, "irccase", l_irccase);
+    }
+
+    auto TearDown() -> void override
+    {
+        lua_close(L);
+    }
+
+    /// @brief Run a chunk and return its error message, empty on success
+    auto run(char const* const code) -> std::string
+    {
+        if (LUA_OK == luaL_dostring(L, code))
+        {
+            return "";
+        }
+        std::string message = lua_tostring(L, -1);
+        lua_pop(L, 1);
+        return message;
+    }
+};
+
+TEST_F(OrderedMap, LookupWithoutKeyFunction)
+{
+    EXPECT_EQ(run(R"(
+        local m = OrderedMap(2)
+        m:insert('a', 1)
+        m:insert(true, 2)
+        assert(m:lookup('a') == 1)
+        assert(m:lookup(true) == 2)
+        assert(m:lookup('A') == nil)
+        assert(m:lookup(false) == nil)
+        assert(m:lookup(nil) == nil)
+
+        -- a newer entry shadows an older one with the same key
+        m:insert('a', 3)
+        assert(m:lookup('a') == 3)
+
+        -- eviction removes the evicted entry from the index
+        m:insert('b', 4)
+        assert(m:lookup(true) == nil)
+        assert(m:lookup('a') == 3)
+    )"), "");
+}
+
+TEST_F(OrderedMap, RekeyWithoutKeyFunction)
+{
+    EXPECT_EQ(run(R"(
+        local m = OrderedMap(4)
+        m:insert('old', 1)
+        m:rekey('old', 'new')
+        assert(m:lookup('old') == nil)
+        assert(m:lookup('new') == 1)
+
+        local _, key = m:each()()
+        assert(key == 'new')
+
+        -- missing keys are ignored
+        m:rekey('missing', 'other')
+        assert(m:lookup('other') == nil)
+    )"), "");
+}
+
+TEST_F(OrderedMap, NativeIrccase)
+{
+    EXPECT_EQ(run(R"(
+        local m = OrderedMap(4, irccase)
+        m:insert('Nick[a]', 1)
+        assert(m:lookup('NICK{A}') == 1)
+        m:rekey('nick{a}', 'Other')
+        assert(m:lookup('nick[a]') == nil)
+        assert(m:lookup('OTHER') == 1)
+
+        local _, key = m:each()()
+        assert(key == 'Other')
+    )"), "");
+}
+
+TEST_F(OrderedMap, LuaKeyFunction)
+{
+    EXPECT_EQ(run(R"(
+        local m = OrderedMap(4, function(k) return string.lower(k) end)
+        m:insert('Key', 1)
+        assert(m:lookup('KEY') == 1)
+        m:rekey('kEY', 'Next')
+        assert(m:lookup('key') == nil)
+        assert(m:lookup('NEXT') == 1)
+    )"), "");
+}
+
+TEST_F(OrderedMap, RejectsUnsupportedKeys)
+{
+    EXPECT_NE(run("OrderedMap(4):insert({}, 1)").find("nil, boolean, or string expected"), std::string::npos);
+    EXPECT_NE(run("OrderedMap(4):lookup(1)").find("nil, boolean, or string expected"), std::string::npos);
+    EXPECT_NE(run("OrderedMap(4, function() return {} end):insert('a', 1)").find("key function"), std::string::npos);
+
+    // Errors raised by the key function leave the map usable
+    EXPECT_EQ(run(R"(
+        local m = OrderedMap(4, function(k) if k == 'bad' then error 'no' end return k end)
+        assert(not pcall(m.insert, m, 'bad', 1))
+        m:insert('good', 2)
+        assert(m:lookup('good') == 2)
+        assert(m.n == 1)
+    )"), "");
+}
+
+} // namespace
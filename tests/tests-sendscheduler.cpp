@@ -0,0 +1,91 @@
+#include <sendscheduler.hpp>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+auto const t0 = SendScheduler::clock::time_point{} + 1h;
+
+TEST(SendScheduler, UnpacedReleasesEverything)
+{
+    SendScheduler scheduler;
+    for (int i = 0; i < 100; i++)
+    {
+        scheduler.push(Lane::Normal, "PING x\r\n");
+    }
+    int n = 0;
+    while (scheduler.pop(t0))
+    {
+        n++;
+    }
+    EXPECT_EQ(n, 100);
+    EXPECT_TRUE(scheduler.empty());
+    EXPECT_EQ(scheduler.lane_stats(Lane::Normal).sent, 100);
+    EXPECT_EQ(scheduler.lane_stats(Lane::Normal).peak, 100);
+}
+
+TEST(SendScheduler, BurstThenRate)
+{
+    SendScheduler scheduler;
+    scheduler.configure(3, 2, t0);
+    for (int i = 0; i < 10; i++)
+    {
+        scheduler.push(Lane::Bulk, "STATS u\r\n");
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_TRUE(scheduler.pop(t0));
+    }
+    EXPECT_FALSE(scheduler.pop(t0));
+    EXPECT_EQ(scheduler.delay(t0), 500ms);
+
+    EXPECT_FALSE(scheduler.pop(t0 + 499ms));
+    EXPECT_TRUE(scheduler.pop(t0 + 500ms));
+    EXPECT_FALSE(scheduler.pop(t0 + 500ms));
+
+    // Tokens never exceed the burst size
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_TRUE(scheduler.pop(t0 + 1h));
+    }
+    EXPECT_FALSE(scheduler.pop(t0 + 1h));
+    EXPECT_EQ(scheduler.lane_stats(Lane::Bulk).depth, 3);
+}
+
+TEST(SendScheduler, LanePriority)
+{
+    SendScheduler scheduler;
+    scheduler.configure(1, 1, t0);
+    scheduler.push(Lane::Bulk, "TESTMASK a\r\n");
+    scheduler.push(Lane::Normal, "KLINE b\r\n");
+    scheduler.push(Lane::Urgent, "PONG c\r\n");
+    EXPECT_EQ(scheduler.queued_bytes(), 29);
+
+    EXPECT_EQ(scheduler.pop(t0), "PONG c\r\n");
+    EXPECT_EQ(scheduler.pop(t0 + 1s), "KLINE b\r\n");
+    EXPECT_EQ(scheduler.pop(t0 + 2s), "TESTMASK a\r\n");
+    EXPECT_EQ(scheduler.pop(t0 + 3s), std::nullopt);
+    EXPECT_EQ(scheduler.queued_bytes(), 0);
+    EXPECT_EQ(scheduler.delay(t0 + 3s), 0s);
+}
+
+TEST(SendScheduler, MessageLane)
+{
+    EXPECT_EQ(message_lane("PONG :irc.example\r\n"), Lane::Urgent);
+    EXPECT_EQ(message_lane("TESTMASK *@example.com\r\n"), Lane::Bulk);
+    EXPECT_EQ(message_lane("stats L\r\n"), Lane::Bulk);
+    EXPECT_EQ(message_lane("WHO\r\n"), Lane::Bulk);
+    EXPECT_EQ(message_lane("@label=1 :nick STATS p\r\n"), Lane::Bulk);
+    EXPECT_EQ(message_lane("KLINE 1 *@b :c\r\n"), Lane::Normal);
+    EXPECT_EQ(message_lane("WHOIS nick\r\n"), Lane::Normal);
+    EXPECT_EQ(message_lane(""), Lane::Normal);
+}
+
+} // namespace
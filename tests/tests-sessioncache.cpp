@@ -0,0 +1,140 @@
+#include <sessioncache.hpp>
+
+#include <gtest/gtest.h>
+
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+/// A cipher for synthetic sessions; sessions without one can't be encoded
+auto cipher() -> SSL_CIPHER const*
+{
+    static SSL_CTX* const ctx = SSL_CTX_new(TLS_client_method());
+    static SSL* const ssl = SSL_new(ctx);
+    unsigned char const id[] = {0xC0, 0x2F}; // ECDHE-RSA-AES128-GCM-SHA256
+    return SSL_CIPHER_find(ssl, id);
+}
+
+auto make_session(unsigned char const id, long const timeout = 300) -> TlsSessionCache::Session
+{
+    TlsSessionCache::Session session{SSL_SESSION_new()};
+    unsigned char const session_id[] = {id, 2, 3, 4};
+    unsigned char const master_key[48] = {id};
+    SSL_SESSION_set1_id(session.get(), session_id, sizeof session_id);
+    SSL_SESSION_set1_master_key(session.get(), master_key, sizeof master_key);
+    SSL_SESSION_set_protocol_version(session.get(), TLS1_2_VERSION);
+    SSL_SESSION_set_cipher(session.get(), cipher());
+    SSL_SESSION_set_time(session.get(), std::time(nullptr));
+    SSL_SESSION_set_timeout(session.get(), timeout);
+    return session;
+}
+
+auto session_id(SSL_SESSION const* const session) -> unsigned char
+{
+    unsigned int len = 0;
+    return SSL_SESSION_get_id(session, &len)[0];
+}
+
+class SessionFile : public testing::Test
+{
+protected:
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / ("tests-sessioncache-" + std::to_string(::getpid()));
+
+    ~SessionFile() override
+    {
+        std::filesystem::remove(path);
+    }
+};
+
+TEST(TlsSessionCache, ReplacesSessionsPerKey)
+{
+    TlsSessionCache cache;
+    auto const key = TlsSessionCache::make_key("irc.example", 6697, "irc.example", "irc.example", nullptr);
+    EXPECT_EQ(cache.get(key), nullptr);
+
+    cache.put(key, make_session(1));
+    cache.put(key, make_session(2));
+    EXPECT_EQ(cache.size(), 1);
+
+    auto const session = cache.get(key);
+    ASSERT_NE(session, nullptr);
+    EXPECT_EQ(session_id(session.get()), 2);
+
+    // Lookups share the cached session
+    EXPECT_EQ(cache.get(key).get(), session.get());
+    EXPECT_EQ(cache.get(TlsSessionCache::make_key("irc.example", 6697, "other.example", "other.example", nullptr)), nullptr);
+    EXPECT_EQ(cache.get(TlsSessionCache::make_key("irc.example", 6698, "irc.example", "irc.example", nullptr)), nullptr);
+
+    // A session from an unverified connection isn't offered to a verified one
+    EXPECT_EQ(cache.get(TlsSessionCache::make_key("irc.example", 6697, "irc.example", "", nullptr)), nullptr);
+}
+
+TEST(TlsSessionCache, KeysIncludeClientCertificate)
+{
+    EVP_PKEY* const key = EVP_EC_gen("P-256");
+    X509* const cert = X509_new();
+    X509_set_pubkey(cert, key);
+    X509_sign(cert, key, EVP_sha256());
+
+    auto const anonymous = TlsSessionCache::make_key("irc.example", 6697, "irc.example", "irc.example", nullptr);
+    auto const identified = TlsSessionCache::make_key("irc.example", 6697, "irc.example", "irc.example", cert);
+    EXPECT_NE(anonymous, identified);
+    EXPECT_TRUE(identified.starts_with(anonymous));
+
+    X509_free(cert);
+    EVP_PKEY_free(key);
+}
+
+TEST(TlsSessionCache, DropsExpiredSessions)
+{
+    TlsSessionCache cache;
+    auto const key = TlsSessionCache::make_key("irc.example", 6697, "irc.example", "irc.example", nullptr);
+
+    auto session = make_session(1);
+    SSL_SESSION_set_time(session.get(), std::time(nullptr) - 600);
+    cache.put(key, std::move(session));
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.get(key), nullptr);
+}
+
+TEST_F(SessionFile, PersistsSessions)
+{
+    auto const key1 = TlsSessionCache::make_key("irc.example", 6697, "irc.example", "irc.example", nullptr);
+    auto const key2 = TlsSessionCache::make_key("irc.other", 6697, "irc.other", "irc.other", nullptr);
+    {
+        TlsSessionCache cache{path};
+        cache.put(key1, make_session(1));
+        cache.put(key2, make_session(2));
+    }
+
+    auto const perms = std::filesystem::status(path).permissions();
+    EXPECT_EQ(perms & std::filesystem::perms::all,
+              std::filesystem::perms::owner_read | std::filesystem::perms::owner_write);
+
+    // No temporary files are left behind
+    auto const prefix = path.filename().string() + '.';
+    for (auto const& entry : std::filesystem::directory_iterator{path.parent_path()})
+    {
+        EXPECT_FALSE(entry.path().filename().string().starts_with(prefix)) << entry.path();
+    }
+
+    // Garbage lines are skipped
+    std::ofstream{path, std::ios::app} << "junk\nkey zz\n";
+
+    TlsSessionCache cache{path};
+    EXPECT_EQ(cache.size(), 2);
+    auto const session = cache.get(key2);
+    ASSERT_NE(session, nullptr);
+    EXPECT_EQ(session_id(session.get()), 2);
+}
+
+} // namespace
@@ -0,0 +1,193 @@
+#include <snote.hpp>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace {
+
+using Fields = std::map<std::string, std::string>;
+
+auto fields_of(snote::Notice const& notice) -> Fields
+{
+    Fields result;
+    for (auto&& field : notice.fields())
+    {
+        result.emplace(field.key, field.value);
+    }
+    return result;
+}
+
+auto expect_notice(std::string_view const text, std::string_view const name, Fields const& fields) -> void
+{
+    auto const notice = snote::parse(text);
+    ASSERT_TRUE(notice.has_value()) << text;
+    EXPECT_EQ(notice->name, name) << text;
+    EXPECT_EQ(fields_of(*notice), fields) << text;
+}
+
+TEST(Snote, Connect)
+{
+    expect_notice(
+        "Client connecting: nick (user@host.example) [192.0.2.1] {users} <acct> [Real Name]",
+        "connect",
+        {{"nick", "nick"}, {"user", "user"}, {"host", "host.example"}, {"ip", "192.0.2.1"},
+         {"class", "users"}, {"account", "acct"}, {"gecos", "Real Name"}}
+    );
+}
+
+TEST(Snote, ConnectUnknownIp)
+{
+    expect_notice(
+        "Client connecting: nick (user@host.example) [0] {users} <*> [Real Name]",
+        "connect",
+        {{"nick", "nick"}, {"user", "user"}, {"host", "host.example"},
+         {"class", "users"}, {"account", "*"}, {"gecos", "Real Name"}}
+    );
+}
+
+TEST(Snote, ConnectHybrid)
+{
+    expect_notice(
+        "Client connecting: nick (user@host.example) [192.0.2.1] {users} [Real Name]",
+        "connect",
+        {{"nick", "nick"}, {"user", "user"}, {"host", "host.example"}, {"ip", "192.0.2.1"},
+         {"class", "users"}, {"gecos", "Real Name"}}
+    );
+}
+
+TEST(Snote, Disconnect)
+{
+    expect_notice(
+        "Client exiting: nick (user@host.example) [Quit: bye] [192.0.2.1]",
+        "disconnect",
+        {{"nick", "nick"}, {"user", "user"}, {"host", "host.example"}, {"reason", "Quit: bye"}, {"ip", "192.0.2.1"}}
+    );
+}
+
+TEST(Snote, BanAdded)
+{
+    auto const notice = snote::parse(
+        "oper!ou@staff/oper{opername} added global 1440 min. K-Line for [*@bad.example] [spam|!oper]"
+    );
+    ASSERT_TRUE(notice.has_value());
+    EXPECT_EQ(notice->name, "kline");
+    EXPECT_EQ(fields_of(*notice), (Fields{
+        {"nick", "oper"}, {"user", "ou"}, {"host", "staff/oper"}, {"oper", "opername"},
+        {"duration", "1440"}, {"mask", "*@bad.example"}, {"reason", "spam|!oper"}}));
+
+    for (auto&& field : notice->fields())
+    {
+        if (field.key == "duration")
+        {
+            EXPECT_EQ(field.conversion, snote::Conversion::Integer);
+        }
+    }
+
+    EXPECT_EQ(snote::parse("o!u@h{o} added global 5 min. RESV for [#chan] [why]")->name, "resv");
+    EXPECT_FALSE(snote::parse("o!u@h{o} added global 5 min. Q-Line for [#chan] [why]").has_value());
+}
+
+TEST(Snote, Rejected)
+{
+    expect_notice(
+        "Rejecting K-Lined user nick[user@host] [192.0.2.1] (mask)",
+        "rejected",
+        {{"kind", "K-Line"}, {"nick", "nick"}, {"user", "user"}, {"host", "host"}, {"ip", "192.0.2.1"}, {"mask", "mask"}}
+    );
+
+    auto const notice = snote::parse("Rejecting X-Lined user nick[user@host] [mask]");
+    ASSERT_TRUE(notice.has_value());
+    for (auto&& field : notice->fields())
+    {
+        if (field.key == "kind")
+        {
+            EXPECT_EQ(field.conversion, snote::Conversion::Lower);
+        }
+    }
+}
+
+TEST(Snote, Expired)
+{
+    expect_notice("Temporary K-Line for [*@host] expired", "expired", {{"kind", "K-Line"}, {"mask", "*@host"}});
+    expect_notice("Propagated ban for [*@host] expired", "expired", {{"kind", "k-line"}, {"mask", "*@host"}});
+}
+
+TEST(Snote, Kill)
+{
+    expect_notice(
+        "Received KILL message for nick!user@host. From oper Path: server!oper (reason)",
+        "kill",
+        {{"nick", "nick"}, {"user", "user"}, {"host", "host"}, {"from", "oper"}, {"reason", "reason"}}
+    );
+    expect_notice(
+        "Received KILL message for nick!user@host. From services. (ghosted)",
+        "kill",
+        {{"nick", "nick"}, {"user", "user"}, {"host", "host"}, {"from", "services."}, {"reason", "ghosted"}}
+    );
+}
+
+TEST(Snote, Netsplit)
+{
+    expect_notice(
+        "Netsplit a.example <-> b.example (1AA 2BB) (Remote host closed the connection)",
+        "netsplit",
+        {{"server1", "a.example"}, {"server2", "b.example"}, {"sid1", "1AA"}, {"sid2", "2BB"},
+         {"reason", "Remote host closed the connection"}}
+    );
+}
+
+TEST(Snote, GenericFormats)
+{
+    expect_notice("nick is creating new channel #chan", "create_channel", {{"nick", "nick"}, {"channel", "#chan"}});
+    expect_notice("nick (user@host) is now an operator", "oper", {{"nick", "nick"}, {"user", "user"}, {"host", "host"}});
+    expect_notice(
+        "n!u@h{o} is deopering target.",
+        "ungrant",
+        {{"nick", "n"}, {"user", "u"}, {"host", "h"}, {"oper", "o"}, {"target", "target"}}
+    );
+    expect_notice(
+        "n!u@h{o} enabled user shedding (interval: 30 seconds, reason: load)",
+        "shedding_on",
+        {{"nick", "n"}, {"user", "u"}, {"host", "h"}, {"oper", "o"}, {"interval", "30"}, {"reason", "load"}}
+    );
+}
+
+TEST(Snote, BadLogin)
+{
+    expect_notice(
+        "Warning: \x02" "5\x02 failed login attempts to \x02" "acct\x02. Last attempt received from "
+        "\x02<Unknown user on irc.example (via SASL):host.example>\x02",
+        "badlogin",
+        {{"count", "5"}, {"account", "acct"}, {"host", "host.example"}}
+    );
+    expect_notice(
+        "Warning: \x02" "5\x02 failed login attempts to \x02" "acct\x02. Last attempt received from "
+        "\x02nick!user@host\x02 on Jan 1",
+        "badlogin",
+        {{"count", "5"}, {"account", "acct"}, {"nick", "nick"}, {"user", "user"}, {"host", "host"}}
+    );
+}
+
+TEST(Snote, Module)
+{
+    expect_notice("Module m_foo [0x1234] loaded at 0xdead", "modload", {{"module", "m_foo"}});
+    expect_notice("Module m_foo unloaded", "modunload", {{"module", "m_foo"}});
+}
+
+TEST(Snote, Simple)
+{
+    expect_notice("Filtering enabled.", "filtering_enabled", {});
+    expect_notice("New filters loaded.", "filtering_loaded", {});
+}
+
+TEST(Snote, Unrecognized)
+{
+    EXPECT_FALSE(snote::parse("").has_value());
+    EXPECT_FALSE(snote::parse("Client connecting: incomplete").has_value());
+    EXPECT_FALSE(snote::parse("Something entirely different").has_value());
+}
+
+} // namespace